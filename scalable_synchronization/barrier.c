@@ -1,5 +1,4 @@
 #include "synchronize.h"
-#include <stdlib.h>
 
 static uint ceiling_log2(uint n) {
   uint i = 0;
@@ -15,7 +14,7 @@ static uint min_uint_2(uint a, uint b) { return (a < b) ? a : b; }
 int barrier_init_centralized(barrier_centralized_t *barrier, uint t_num) {
   uint i;
   padded_bool_t *local_sense =
-      (padded_bool_t *)malloc(sizeof(padded_bool_t) * t_num);
+      (padded_bool_t *)slab_alloc(sizeof(padded_bool_t) * t_num);
   if (local_sense == NULL) {
     return OUT_OF_MEMORY;
   }
@@ -30,7 +29,7 @@ int barrier_init_centralized(barrier_centralized_t *barrier, uint t_num) {
 }
 
 void barrier_destroy_centralized(barrier_centralized_t *barrier) {
-  free(barrier->local_sense);
+  slab_free(barrier->local_sense);
   barrier->local_sense = NULL;
 }
 
@@ -52,7 +51,7 @@ int barrier_init_combining_tree(barrier_combining_tree_t *barrier, uint t_num) {
   uint i, n_num, n_lower, n_curr, n_prev;
   padded_combining_tree_node_t *nodes;
   padded_bool_t *local_sense =
-      (padded_bool_t *)malloc(sizeof(padded_bool_t) * t_num);
+      (padded_bool_t *)slab_alloc(sizeof(padded_bool_t) * t_num);
   if (local_sense == NULL) {
     return OUT_OF_MEMORY;
   }
@@ -69,10 +68,10 @@ int barrier_init_combining_tree(barrier_combining_tree_t *barrier, uint t_num) {
   }
   n_num = n_lower + 1;
 
-  nodes = (padded_combining_tree_node_t *)malloc(
+  nodes = (padded_combining_tree_node_t *)slab_alloc(
       sizeof(padded_combining_tree_node_t) * n_num);
   if (nodes == NULL) {
-    free(local_sense);
+    slab_free(local_sense);
     return OUT_OF_MEMORY;
   }
 
@@ -110,8 +109,8 @@ int barrier_init_combining_tree(barrier_combining_tree_t *barrier, uint t_num) {
 }
 
 void barrier_destroy_combining_tree(barrier_combining_tree_t *barrier) {
-  free(barrier->nodes);
-  free(barrier->local_sense);
+  slab_free(barrier->nodes);
+  slab_free(barrier->local_sense);
   barrier->nodes = NULL;
   barrier->local_sense = NULL;
 }
@@ -142,8 +141,9 @@ void barrier_wait_combining_tree(barrier_combining_tree_t *barrier) {
 
 int barrier_init_dissemination(barrier_dissemination_t *barrier, uint t_num) {
   uint i, j, succ, log_t_num, table_size;
-  padded_dissemination_flags_t *flags = (padded_dissemination_flags_t *)malloc(
-      sizeof(padded_dissemination_flags_t) * t_num);
+  padded_dissemination_flags_t *flags =
+      (padded_dissemination_flags_t *)slab_alloc(
+          sizeof(padded_dissemination_flags_t) * t_num);
   if (flags == NULL) {
     return OUT_OF_MEMORY;
   }
@@ -155,7 +155,7 @@ int barrier_init_dissemination(barrier_dissemination_t *barrier, uint t_num) {
       CACHE_LINE_SIZE;
 
   for (i = 0; i < t_num; ++i) {
-    void *buff = malloc(table_size + sizeof(atomic_bool) * 2 * log_t_num);
+    void *buff = slab_alloc(table_size + sizeof(atomic_bool) * 2 * log_t_num);
     if (buff == NULL) {
       break;
     }
@@ -182,9 +182,9 @@ int barrier_init_dissemination(barrier_dissemination_t *barrier, uint t_num) {
     return SUCCESS;
   } else {
     for (i = 0; i < succ; ++i) {
-      free(flags[i].value.partner_flags);
+      slab_free(flags[i].value.partner_flags);
     }
-    free(flags);
+    slab_free(flags);
     return OUT_OF_MEMORY;
   }
 }
@@ -192,9 +192,9 @@ int barrier_init_dissemination(barrier_dissemination_t *barrier, uint t_num) {
 void barrier_destroy_dissemination(barrier_dissemination_t *barrier) {
   uint i;
   for (i = 0; i < barrier->thread_num; ++i) {
-    free(barrier->flags[i].value.partner_flags);
+    slab_free(barrier->flags[i].value.partner_flags);
   }
-  free(barrier->flags);
+  slab_free(barrier->flags);
   barrier->flags = NULL;
 }
 
@@ -222,7 +222,7 @@ void barrier_wait_dissemination(barrier_dissemination_t *barrier) {
 
 int barrier_init_tournament(barrier_tournament_t *barrier, uint t_num) {
   uint i, j, succ, log_t_num, table_size;
-  padded_tournament_flags_t *flags = (padded_tournament_flags_t *)malloc(
+  padded_tournament_flags_t *flags = (padded_tournament_flags_t *)slab_alloc(
       sizeof(padded_tournament_flags_t) * t_num);
   if (flags == NULL) {
     return OUT_OF_MEMORY;
@@ -235,7 +235,7 @@ int barrier_init_tournament(barrier_tournament_t *barrier, uint t_num) {
                CACHE_LINE_SIZE;
 
   for (i = 0; i < t_num; ++i) {
-    void *buff = malloc(table_size + sizeof(atomic_bool) * log_t_num);
+    void *buff = slab_alloc(table_size + sizeof(atomic_bool) * log_t_num);
     if (buff == NULL) {
       break;
     }
@@ -284,9 +284,9 @@ int barrier_init_tournament(barrier_tournament_t *barrier, uint t_num) {
     return SUCCESS;
   } else {
     for (i = 0; i < succ; ++i) {
-      free(flags[i].value.opponent_flags);
+      slab_free(flags[i].value.opponent_flags);
     }
-    free(flags);
+    slab_free(flags);
     return OUT_OF_MEMORY;
   }
 }
@@ -294,9 +294,9 @@ int barrier_init_tournament(barrier_tournament_t *barrier, uint t_num) {
 void barrier_destroy_tournament(barrier_tournament_t *barrier) {
   uint i;
   for (i = 0; i < barrier->thread_num; ++i) {
-    free(barrier->flags[i].value.opponent_flags);
+    slab_free(barrier->flags[i].value.opponent_flags);
   }
-  free(barrier->flags);
+  slab_free(barrier->flags);
   barrier->flags = NULL;
 }
 
@@ -340,7 +340,7 @@ void barrier_wait_tournament(barrier_tournament_t *barrier) {
 
 int barrier_init_dual_tree(barrier_dual_tree_t *barrier, uint t_num) {
   uint i, j;
-  padded_dual_tree_node_t *nodes = (padded_dual_tree_node_t *)malloc(
+  padded_dual_tree_node_t *nodes = (padded_dual_tree_node_t *)slab_alloc(
       sizeof(padded_dual_tree_node_t) * t_num);
   if (nodes == NULL) {
     return OUT_OF_MEMORY;
@@ -360,7 +360,7 @@ int barrier_init_dual_tree(barrier_dual_tree_t *barrier, uint t_num) {
     }
 
     for (j = 0; j < DUAL_TREE_FAN_OUT; ++j) {
-      if (DUAL_TREE_FAN_OUT * i + j + 1 > t_num) {
+      if (DUAL_TREE_FAN_OUT * i + j + 1 >= t_num) {
         node->fan_out_child_flags[j] = NULL;
       } else {
         node->fan_out_child_flags[j] =
@@ -377,7 +377,7 @@ int barrier_init_dual_tree(barrier_dual_tree_t *barrier, uint t_num) {
 }
 
 void barrier_destroy_dual_tree(barrier_dual_tree_t *barrier) {
-  free(barrier->nodes);
+  slab_free(barrier->nodes);
   barrier->nodes = NULL;
 }
 
@@ -422,7 +422,7 @@ void barrier_wait_dual_tree(barrier_dual_tree_t *barrier) {
 
 int barrier_init_arrival_tree(barrier_arrival_tree_t *barrier, uint t_num) {
   uint i, j;
-  padded_arrival_tree_node_t *nodes = (padded_arrival_tree_node_t *)malloc(
+  padded_arrival_tree_node_t *nodes = (padded_arrival_tree_node_t *)slab_alloc(
       sizeof(padded_arrival_tree_node_t) * t_num);
   if (nodes == NULL) {
     return OUT_OF_MEMORY;
@@ -444,12 +444,13 @@ int barrier_init_arrival_tree(barrier_arrival_tree_t *barrier, uint t_num) {
     node->local_sense = true;
   }
 
+  atomic_init(&barrier->sense, false);
   barrier->nodes = nodes;
   return SUCCESS;
 }
 
 void barrier_destroy_arrival_tree(barrier_arrival_tree_t *barrier) {
-  free(barrier->nodes);
+  slab_free(barrier->nodes);
   barrier->nodes = NULL;
 }
 
@@ -476,4 +477,64 @@ void barrier_wait_arrival_tree(barrier_arrival_tree_t *barrier) {
   }
 
   my_node->local_sense = !sense;
-}
\ No newline at end of file
+}
+/* The arrival tree with `WIDE_TREE_FAN_IN` children per node, so a node
+ * polls all its children's flags in one vector and the tree is only
+ * log32(t_num) levels deep. Nodes start on a cache line, which keeps each
+ * node's flags within one line. */
+
+int barrier_init_wide_tree(barrier_wide_tree_t *barrier, uint t_num) {
+  uint i, j;
+  padded_wide_tree_node_t *nodes = (padded_wide_tree_node_t *)slab_alloc(
+      sizeof(padded_wide_tree_node_t) * t_num);
+  if (nodes == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < t_num; ++i) {
+    wide_tree_node_t *node = &nodes[i].value;
+    node->parent_flag =
+        (i == 0) ? NULL
+                 : &nodes[(i - 1) / WIDE_TREE_FAN_IN]
+                        .value.child_not_ready[(i - 1) % WIDE_TREE_FAN_IN];
+    node->children = 0;
+    for (j = 0; j < WIDE_TREE_FAN_IN; ++j) {
+      bool have_child = WIDE_TREE_FAN_IN * i + j + 1 < t_num;
+      node->children += have_child;
+      atomic_init(&node->child_not_ready[j], have_child);
+    }
+    node->local_sense = true;
+  }
+
+  atomic_init(&barrier->sense, false);
+  barrier->nodes = nodes;
+  return SUCCESS;
+}
+
+void barrier_destroy_wide_tree(barrier_wide_tree_t *barrier) {
+  slab_free(barrier->nodes);
+  barrier->nodes = NULL;
+}
+
+void barrier_wait_wide_tree(barrier_wide_tree_t *barrier) {
+  uint i;
+  uint my_id = thread_current_id();
+  wide_tree_node_t *my_node = &barrier->nodes[my_id].value;
+  bool sense = my_node->local_sense;
+
+  while (flags_any(my_node->child_not_ready, 1)) {
+    delay(0);
+  }
+  for (i = 0; i < my_node->children; ++i) {
+    ATOMIC_STORE(&my_node->child_not_ready[i], true);
+  }
+  if (my_id != 0) {
+    ATOMIC_RELEASE(my_node->parent_flag, false);
+    while (ATOMIC_ACQUIRE(&barrier->sense) != sense) {
+      delay(0);
+    }
+  } else {
+    ATOMIC_RELEASE(&barrier->sense, sense);
+  }
+
+  my_node->local_sense = !sense;
+}
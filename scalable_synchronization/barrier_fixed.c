@@ -0,0 +1,156 @@
+#include "synchronize.h"
+#include <stdlib.h>
+
+#ifndef BARRIER_FIXED_THREADS
+#error "barrier_fixed.c is compiled with -DBARRIER_FIXED_THREADS=<N>"
+#endif
+
+/* The waits below take the thread id as a constant: `DISPATCH` expands one
+ * inlined copy per id into a switch, and the rounds of each copy are fully
+ * unrolled, so partner flags become constant offsets into the barrier and
+ * roles are settled at compile time. An id of `BARRIER_FIXED_THREADS` or
+ * beyond means the barrier was built for another thread count, and aborts
+ * rather than leave the barrier without waiting. */
+
+#define N BARRIER_FIXED_THREADS
+#define INLINE static inline __attribute__((always_inline))
+
+#define CASE(body, id)                                                         \
+  case id:                                                                     \
+    if ((id) < N) {                                                            \
+      body(barrier, (id) % N);                                                 \
+      break;                                                                   \
+    }                                                                          \
+    abort();
+
+#define CASES_16(body, h)                                                      \
+  CASE(body, h##0) CASE(body, h##1) CASE(body, h##2) CASE(body, h##3)          \
+  CASE(body, h##4) CASE(body, h##5) CASE(body, h##6) CASE(body, h##7)          \
+  CASE(body, h##8) CASE(body, h##9) CASE(body, h##A) CASE(body, h##B)          \
+  CASE(body, h##C) CASE(body, h##D) CASE(body, h##E) CASE(body, h##F)
+
+#if N > 48
+#define DISPATCH(body)                                                         \
+  CASES_16(body, 0x0) CASES_16(body, 0x1) CASES_16(body, 0x2)                  \
+  CASES_16(body, 0x3)
+#elif N > 32
+#define DISPATCH(body)                                                         \
+  CASES_16(body, 0x0) CASES_16(body, 0x1) CASES_16(body, 0x2)
+#elif N > 16
+#define DISPATCH(body) CASES_16(body, 0x0) CASES_16(body, 0x1)
+#else
+#define DISPATCH(body) CASES_16(body, 0x0)
+#endif
+
+int barrier_init_fixed_dissemination(barrier_fixed_dissemination_t *barrier) {
+  uint i, j;
+  for (i = 0; i < N; ++i) {
+    for (j = 0; j <= BARRIER_FIXED_LOG; ++j) {
+      atomic_init(&barrier->flags[i].value.my_flags[0][j], false);
+      atomic_init(&barrier->flags[i].value.my_flags[1][j], false);
+    }
+    barrier->flags[i].value.parity = 0;
+    barrier->flags[i].value.sense = true;
+  }
+  return SUCCESS;
+}
+
+INLINE void wait_dissemination(barrier_fixed_dissemination_t *barrier,
+                               const uint id) {
+  fixed_dissemination_flags_t *my_flags = &barrier->flags[id].value;
+  uint r, parity = my_flags->parity;
+  bool sense = my_flags->sense;
+
+#pragma GCC unroll 8
+  for (r = 0; r < BARRIER_FIXED_LOG; ++r) {
+    ATOMIC_RELEASE(
+        &barrier->flags[(id + (1u << r)) % N].value.my_flags[parity][r],
+        sense);
+    while (ATOMIC_ACQUIRE(&my_flags->my_flags[parity][r]) != sense) {
+      delay(0);
+    }
+  }
+
+  if (parity == 1) {
+    my_flags->sense = !sense;
+  }
+  my_flags->parity = parity ^ 1;
+}
+
+void barrier_wait_fixed_dissemination(barrier_fixed_dissemination_t *barrier) {
+  switch (thread_current_id()) {
+    DISPATCH(wait_dissemination)
+  default:
+    abort();
+  }
+}
+
+int barrier_init_fixed_tournament(barrier_fixed_tournament_t *barrier) {
+  uint i, j;
+  for (i = 0; i < N; ++i) {
+    for (j = 0; j <= BARRIER_FIXED_LOG; ++j) {
+      atomic_init(&barrier->flags[i].value.my_flags[j], false);
+    }
+    barrier->flags[i].value.sense = true;
+  }
+  return SUCCESS;
+}
+
+/* Same roles as `barrier_init_tournament`; 0 past the last round of `id` */
+INLINE char tournament_role(const uint id, const uint r) {
+  uint base = 2u << r, half_base = 1u << r;
+  if (id == 0 && base >= N) {
+    return CHAMPION;
+  } else if (id % base == half_base) {
+    return LOSER;
+  } else if (id % base == 0) {
+    return (id + half_base < N) ? WINNER : BYE;
+  }
+  return 0;
+}
+
+INLINE void wait_tournament(barrier_fixed_tournament_t *barrier,
+                            const uint id) {
+  fixed_tournament_flags_t *my_flags = &barrier->flags[id].value;
+  bool sense = my_flags->sense;
+  uint r;
+
+#pragma GCC unroll 8
+  for (r = 0; r < BARRIER_FIXED_LOG; ++r) {
+    char role = tournament_role(id, r);
+    if (role == LOSER) {
+      ATOMIC_RELEASE(&barrier->flags[id - (1u << r)].value.my_flags[r], sense);
+      while (ATOMIC_ACQUIRE(&my_flags->my_flags[r]) != sense) {
+        delay(0);
+      }
+    } else if (role == WINNER) {
+      while (ATOMIC_ACQUIRE(&my_flags->my_flags[r]) != sense) {
+        delay(0);
+      }
+    } else if (role == CHAMPION) {
+      while (ATOMIC_ACQUIRE(&my_flags->my_flags[r]) != sense) {
+        delay(0);
+      }
+      ATOMIC_RELEASE(&barrier->flags[id + (1u << r)].value.my_flags[r], sense);
+    }
+    if (role == LOSER || role == CHAMPION) {
+      break;
+    }
+  }
+
+#pragma GCC unroll 8
+  for (r = BARRIER_FIXED_LOG; r-- > 0;) {
+    if (tournament_role(id, r) == WINNER) {
+      ATOMIC_RELEASE(&barrier->flags[id + (1u << r)].value.my_flags[r], sense);
+    }
+  }
+  my_flags->sense = !sense;
+}
+
+void barrier_wait_fixed_tournament(barrier_fixed_tournament_t *barrier) {
+  switch (thread_current_id()) {
+    DISPATCH(wait_tournament)
+  default:
+    abort();
+  }
+}
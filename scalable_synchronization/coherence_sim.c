@@ -0,0 +1,266 @@
+#include "synchronize.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Replays a trace of `test_trace` on a directory-based MESI protocol, with
+ * one private cache of unbounded size per core, so that only coherence
+ * misses remain. Threads map to cores round-robin, either filling sockets
+ * one after the other (compact) or alternating between them (scatter).
+ * Cache lines have their home directory interleaved across sockets, and a
+ * message between two sockets counts as interconnect traffic. */
+
+typedef struct {
+  bool used;
+  uintptr_t line;
+  /* Core holding the line in E or M state, or -1 */
+  int owner;
+  /* Cores holding the line in S state, when there is no owner */
+  uint64_t *sharers;
+} line_state_t;
+
+typedef struct {
+  uint cores, sockets, cores_per_socket, words;
+  bool scatter;
+  line_state_t *lines;
+  uint line_capacity, line_num;
+  unsigned long accesses, misses, invalidations, messages, interconnect;
+  unsigned long episodes;
+} simulator_t;
+
+static int simulator_init(simulator_t *sim, uint cores, uint sockets,
+                          bool scatter) {
+  sim->cores = cores;
+  sim->sockets = sockets;
+  sim->cores_per_socket = cores / sockets;
+  sim->words = (cores + 63) / 64;
+  sim->scatter = scatter;
+  sim->line_capacity = 1024;
+  sim->line_num = 0;
+  sim->lines =
+      (line_state_t *)calloc(sim->line_capacity, sizeof(line_state_t));
+  if (sim->lines == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  sim->accesses = sim->misses = sim->invalidations = 0;
+  sim->messages = sim->interconnect = sim->episodes = 0;
+  return SUCCESS;
+}
+
+static void simulator_destroy(simulator_t *sim) {
+  uint i;
+  for (i = 0; i < sim->line_capacity; ++i) {
+    free(sim->lines[i].sharers);
+  }
+  free(sim->lines);
+  sim->lines = NULL;
+}
+
+static uint core_of(simulator_t *sim, uint thread) {
+  uint core = thread % sim->cores;
+  if (sim->scatter) {
+    core =
+        (core % sim->sockets) * sim->cores_per_socket + core / sim->sockets;
+  }
+  return core;
+}
+
+static uint socket_of(simulator_t *sim, uint core) {
+  return core / sim->cores_per_socket;
+}
+
+static uint home_of(simulator_t *sim, uintptr_t line) {
+  return line % sim->sockets;
+}
+
+static line_state_t *probe(line_state_t *lines, uint capacity,
+                           uintptr_t line) {
+  uint i = (uint)((line * 0x9e3779b97f4a7c15ull) >> 32) & (capacity - 1);
+  while (lines[i].used && lines[i].line != line) {
+    i = (i + 1) & (capacity - 1);
+  }
+  return &lines[i];
+}
+
+static int grow(simulator_t *sim) {
+  uint i, capacity = 2 * sim->line_capacity;
+  line_state_t *lines =
+      (line_state_t *)calloc(capacity, sizeof(line_state_t));
+  if (lines == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < sim->line_capacity; ++i) {
+    if (sim->lines[i].used) {
+      *probe(lines, capacity, sim->lines[i].line) = sim->lines[i];
+    }
+  }
+  free(sim->lines);
+  sim->lines = lines;
+  sim->line_capacity = capacity;
+  return SUCCESS;
+}
+
+static line_state_t *lookup(simulator_t *sim, uintptr_t line) {
+  line_state_t *state;
+  if (2 * (sim->line_num + 1) > sim->line_capacity && grow(sim) != SUCCESS) {
+    return NULL;
+  }
+  state = probe(sim->lines, sim->line_capacity, line);
+  if (!state->used) {
+    state->sharers = (uint64_t *)calloc(sim->words, sizeof(uint64_t));
+    if (state->sharers == NULL) {
+      return NULL;
+    }
+    state->used = true;
+    state->line = line;
+    state->owner = -1;
+    ++sim->line_num;
+  }
+  return state;
+}
+
+static bool is_sharer(line_state_t *state, uint core) {
+  return (state->sharers[core / 64] >> (core % 64)) & 1;
+}
+
+static void add_sharer(line_state_t *state, uint core) {
+  state->sharers[core / 64] |= 1ull << (core % 64);
+}
+
+static void message(simulator_t *sim, uint from_socket, uint to_socket) {
+  ++sim->messages;
+  sim->interconnect += (from_socket != to_socket);
+}
+
+static void read_line(simulator_t *sim, line_state_t *state, uint core) {
+  uint home = home_of(sim, state->line);
+  uint i;
+  bool shared = false;
+
+  if (state->owner == (int)core || is_sharer(state, core)) {
+    return;
+  }
+  ++sim->misses;
+  message(sim, socket_of(sim, core), home);
+  if (state->owner >= 0) {
+    uint owner = state->owner;
+    message(sim, home, socket_of(sim, owner));
+    message(sim, socket_of(sim, owner), socket_of(sim, core));
+    add_sharer(state, owner);
+    add_sharer(state, core);
+    state->owner = -1;
+    return;
+  }
+  message(sim, home, socket_of(sim, core));
+  for (i = 0; i < sim->words; ++i) {
+    shared = shared || state->sharers[i] != 0;
+  }
+  if (shared) {
+    add_sharer(state, core);
+  } else {
+    state->owner = core;
+  }
+}
+
+static void write_line(simulator_t *sim, line_state_t *state, uint core) {
+  uint home = home_of(sim, state->line);
+  uint i;
+
+  if (state->owner == (int)core) {
+    return;
+  }
+  ++sim->misses;
+  message(sim, socket_of(sim, core), home);
+  if (state->owner >= 0) {
+    uint owner = state->owner;
+    message(sim, home, socket_of(sim, owner));
+    message(sim, socket_of(sim, owner), socket_of(sim, core));
+    ++sim->invalidations;
+  } else {
+    for (i = 0; i < sim->cores; ++i) {
+      if (i != core && is_sharer(state, i)) {
+        message(sim, home, socket_of(sim, i));
+        message(sim, socket_of(sim, i), socket_of(sim, core));
+        ++sim->invalidations;
+      }
+    }
+    /* The data, or only the permission when upgrading a shared copy */
+    message(sim, home, socket_of(sim, core));
+  }
+  memset(state->sharers, 0, sizeof(uint64_t) * sim->words);
+  state->owner = core;
+}
+
+static int replay(simulator_t *sim, FILE *trace) {
+  uint thread;
+  char operation;
+  unsigned long address;
+  while (fscanf(trace, "%u %c %lx", &thread, &operation, &address) == 3) {
+    line_state_t *state;
+    if (operation == 'E') {
+      ++sim->episodes;
+      continue;
+    }
+    if (operation == 'F') {
+      continue;
+    }
+    state = lookup(sim, address / CACHE_LINE_SIZE);
+    if (state == NULL) {
+      return OUT_OF_MEMORY;
+    }
+    ++sim->accesses;
+    if (operation == 'R') {
+      read_line(sim, state, core_of(sim, thread));
+    } else {
+      write_line(sim, state, core_of(sim, thread));
+    }
+  }
+  return SUCCESS;
+}
+
+static void report(const char *name, unsigned long count,
+                   unsigned long episodes) {
+  printf("\t\t%s: total %lu, per episode %.2lf\n", name, count,
+         (episodes > 0) ? (double)count / episodes : 0.0);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    int cores = atoi(argv[2]);
+    int sockets = (argc > 3) ? atoi(argv[3]) : 1;
+    bool scatter = (argc > 4) && strcmp(argv[4], "scatter") == 0;
+    if (cores > 0 && sockets > 0 && cores % sockets == 0) {
+      simulator_t sim;
+      int retval;
+      FILE *trace = fopen(argv[1], "r");
+      if (trace == NULL) {
+        printf("Cannot read %s\n", argv[1]);
+        return -3;
+      }
+      printf("Replaying %s on %d cores in %d sockets, %s...\n", argv[1],
+             cores, sockets, scatter ? "scatter" : "compact");
+      retval = simulator_init(&sim, cores, sockets, scatter);
+      if (retval == SUCCESS) {
+        retval = replay(&sim, trace);
+      }
+      fclose(trace);
+      if (retval != SUCCESS) {
+        printf("Out of memory\n");
+        return retval;
+      }
+      printf("\t%lu accesses to %u lines, %lu episodes\n", sim.accesses,
+             sim.line_num, sim.episodes);
+      report("remote references", sim.misses, sim.episodes);
+      report("invalidations", sim.invalidations, sim.episodes);
+      report("messages", sim.messages, sim.episodes);
+      report("interconnect messages", sim.interconnect, sim.episodes);
+      simulator_destroy(&sim);
+      return SUCCESS;
+    }
+  }
+  printf("USAGE:\n\t%s <trace file> <#cores> [#sockets] [compact|scatter]\n",
+         argv[0]);
+  printf("\tThe number of cores must be a multiple of the number of "
+         "sockets.\n");
+  return -3;
+}
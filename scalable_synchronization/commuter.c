@@ -0,0 +1,243 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Conflict checker after the scalable commutativity rule (Clements et al.,
+ * SOSP 2013): operations that commute have an implementation whose memory
+ * accesses do not conflict. Each case runs one operation on thread 0, then
+ * a commuting one on thread 1, both traced through the `ATOMIC_*` macros.
+ * A cache line written by one and accessed by the other is a conflict.
+ * Each operation runs once untraced first, so that only the steady state is
+ * checked. Plain loads and stores are not traced. Cases that are expected
+ * to be conflict-free and are not make the checker fail. */
+
+#define TRACE_CAPACITY (1ul << 16)
+#define MAX_LINES 1024
+#define STRIPES 64
+#define CAPACITY 1024
+
+typedef struct {
+  counter_distributed_t counter_distributed;
+  counter_sloppy_t counter_sloppy;
+  indicator_SNZI_t indicator_SNZI;
+  hashmap_t map;
+  mutex_ticket_t bravo_mutex;
+  rwlock_BRAVO_t rwlock_BRAVO;
+  mutex_ticket_t flags_mutex;
+  rwlock_flags_t rwlock_flags;
+} structures_t;
+
+typedef void (*commuter_operation_t)(structures_t *s, uint tid);
+
+typedef struct {
+  const char *name;
+  commuter_operation_t operation;
+  bool conflict_free;
+} commuter_case_t;
+
+typedef struct {
+  uintptr_t line;
+  bool accessed[2];
+  bool written[2];
+} line_access_t;
+
+typedef struct {
+  line_access_t lines[MAX_LINES];
+  uint line_num;
+  bool overflow;
+} footprint_t;
+
+typedef struct {
+  int thread_num;
+  structures_t structures;
+  footprint_t footprint;
+  uint regressions;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static void add_distributed(structures_t *s, uint tid) {
+  counter_add_distributed(&s->counter_distributed, 1);
+}
+
+static void add_sloppy(structures_t *s, uint tid) {
+  counter_add_sloppy(&s->counter_sloppy, 1);
+}
+
+static void arrive_SNZI(structures_t *s, uint tid) {
+  indicator_arrive_SNZI(&s->indicator_SNZI);
+}
+
+static void put_distinct(structures_t *s, uint tid) {
+  hashmap_put(&s->map, tid + 1, tid);
+}
+
+static void get_same(structures_t *s, uint tid) {
+  unsigned long value;
+  hashmap_get(&s->map, 1, &value);
+}
+
+static void put_get_distinct(structures_t *s, uint tid) {
+  unsigned long value;
+  if (tid == 0) {
+    hashmap_put(&s->map, 1, tid);
+  } else {
+    hashmap_get(&s->map, 2, &value);
+  }
+}
+
+static void read_BRAVO(structures_t *s, uint tid) {
+  rwlock_BRAVO_token_t token;
+  token.ownership = NULL;
+  rwlock_read_lock_BRAVO(&s->rwlock_BRAVO, &token);
+  rwlock_read_unlock_BRAVO(&s->rwlock_BRAVO, &token);
+}
+
+static void read_flags(structures_t *s, uint tid) {
+  rwlock_read_lock_flags(&s->rwlock_flags);
+  rwlock_read_unlock_flags(&s->rwlock_flags);
+}
+
+static const commuter_case_t cases[] = {
+    {"counter_distributed add/add", add_distributed, true},
+    {"counter_sloppy add/add", add_sloppy, true},
+    /* Threads 0 and 1 share a leaf */
+    {"indicator_SNZI arrive/arrive", arrive_SNZI, false},
+    {"hashmap put/put, distinct keys", put_distinct, true},
+    {"hashmap get/get, same key", get_same, true},
+    {"hashmap put/get, distinct keys", put_get_distinct, true},
+    {"rwlock_BRAVO read/read", read_BRAVO, true},
+    /* Readers 0 and 1 share a flag vector */
+    {"rwlock_flags read/read", read_flags, false},
+};
+
+#define CASES (sizeof(cases) / sizeof(cases[0]))
+
+static void record_access(uint thread, char operation, const void *address,
+                          void *arg) {
+  footprint_t *footprint = (footprint_t *)arg;
+  uintptr_t line = (uintptr_t)address / CACHE_LINE_SIZE;
+  uint i;
+  if (thread > 1 || operation == ATOMIC_TRACE_FENCE ||
+      operation == ATOMIC_TRACE_EPISODE) {
+    return;
+  }
+  for (i = 0; i < footprint->line_num; ++i) {
+    if (footprint->lines[i].line == line) {
+      break;
+    }
+  }
+  if (i == footprint->line_num) {
+    if (i == MAX_LINES) {
+      footprint->overflow = true;
+      return;
+    }
+    footprint->lines[i].line = line;
+    footprint->lines[i].accessed[0] = footprint->lines[i].accessed[1] = false;
+    footprint->lines[i].written[0] = footprint->lines[i].written[1] = false;
+    ++footprint->line_num;
+  }
+  footprint->lines[i].accessed[thread] = true;
+  footprint->lines[i].written[thread] |= (operation != ATOMIC_TRACE_READ);
+}
+
+static const char *access_kind(const line_access_t *access, uint thread) {
+  return access->written[thread] ? "write" : "read";
+}
+
+static void report(pthread_subroutine_args_t *obj, const commuter_case_t *c) {
+  footprint_t *footprint = &obj->footprint;
+  uint i, conflicts = 0;
+  for (i = 0; i < footprint->line_num; ++i) {
+    const line_access_t *access = &footprint->lines[i];
+    if ((access->written[0] && access->accessed[1]) ||
+        (access->written[1] && access->accessed[0])) {
+      ++conflicts;
+    }
+  }
+  printf("\t%s: %u lines, %u shared with a write%s%s\n", c->name,
+         footprint->line_num, conflicts,
+         footprint->overflow ? " (footprint truncated)" : "",
+         (conflicts > 0 && c->conflict_free) ? ", expected conflict-free"
+                                             : "");
+  for (i = 0; i < footprint->line_num; ++i) {
+    const line_access_t *access = &footprint->lines[i];
+    if ((access->written[0] && access->accessed[1]) ||
+        (access->written[1] && access->accessed[0])) {
+      printf("\t\tline %#lx: thread 0 %s, thread 1 %s\n",
+             (unsigned long)access->line * CACHE_LINE_SIZE,
+             access_kind(access, 0), access_kind(access, 1));
+    }
+  }
+  obj->regressions += (conflicts > 0 && c->conflict_free);
+}
+
+static void check_case(pthread_subroutine_args_t *obj,
+                       const commuter_case_t *c) {
+  uint tid = thread_current_id();
+  int round;
+  for (round = 0; round < 2; ++round) {
+    pthread_barrier_wait(&obj->barrier_aux);
+    if (round == 1 && tid == 0) {
+      atomic_trace_start(TRACE_CAPACITY);
+    }
+    pthread_barrier_wait(&obj->barrier_aux);
+    if (tid == 0) {
+      c->operation(&obj->structures, tid);
+    }
+    pthread_barrier_wait(&obj->barrier_aux);
+    if (tid == 1) {
+      c->operation(&obj->structures, tid);
+    }
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (tid == 0) {
+    obj->footprint.line_num = 0;
+    obj->footprint.overflow = false;
+    atomic_trace_stop(record_access, &obj->footprint);
+    report(obj, c);
+  }
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  uint i;
+  thread_init(obj->thread_num);
+  for (i = 0; i < CASES; ++i) {
+    check_case(obj, &cases[i]);
+  }
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  structures_t *s = &obj.structures;
+  int retval;
+  obj.thread_num = 2;
+  obj.regressions = 0;
+  printf("Checking %u pairs of commuting operations on 2 threads...\n",
+         (uint)CASES);
+
+  pthread_barrier_init(&obj.barrier_aux, NULL, obj.thread_num);
+  counter_init_distributed(&s->counter_distributed, obj.thread_num);
+  counter_init_sloppy(&s->counter_sloppy, obj.thread_num, 1l << 30);
+  indicator_init_SNZI(&s->indicator_SNZI, obj.thread_num);
+  hashmap_init(&s->map, obj.thread_num, STRIPES, CAPACITY);
+  mutex_init_ticket(&s->bravo_mutex);
+  rwlock_init_BRAVO(&s->rwlock_BRAVO, &s->bravo_mutex, &rwlock_mutex_ticket);
+  mutex_init_ticket(&s->flags_mutex);
+  rwlock_init_flags(&s->rwlock_flags, obj.thread_num, &s->flags_mutex,
+                    &rwlock_mutex_ticket);
+
+  retval = parallel_execute(pthread_subroutine, (void *)&obj, obj.thread_num);
+
+  printf("%u unexpected conflicts\n", obj.regressions);
+  counter_destroy_distributed(&s->counter_distributed);
+  counter_destroy_sloppy(&s->counter_sloppy);
+  indicator_destroy_SNZI(&s->indicator_SNZI);
+  hashmap_destroy(&s->map);
+  rwlock_destroy_flags(&s->rwlock_flags);
+  pthread_barrier_destroy(&obj.barrier_aux);
+  return (retval != SUCCESS) ? retval : (obj.regressions > 0);
+}
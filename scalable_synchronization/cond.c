@@ -0,0 +1,233 @@
+#include "synchronize.h"
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define COND_WAITING 0
+/* The waiter already holds a place in the mutex's queue */
+#define COND_REQUEUED 1
+/* The mutex has no queue, the waiter must acquire it again */
+#define COND_RETRY 2
+
+static void futex_wait(atomic_uint *word, uint value) {
+  syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void futex_wake(atomic_uint *word, int count) {
+  syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+int cond_init(cond_t *cond) {
+  cond->head = NULL;
+  cond->tail = NULL;
+  return SUCCESS;
+}
+
+static void cond_append(cond_t *cond, cond_waiter_t *waiter) {
+  atomic_init(&waiter->state, COND_WAITING);
+  waiter->next = NULL;
+  waiter->next_morphed = NULL;
+  if (cond->tail == NULL) {
+    cond->head = waiter;
+  } else {
+    cond->tail->next = waiter;
+  }
+  cond->tail = waiter;
+}
+
+static uint cond_park(cond_waiter_t *waiter) {
+  uint state;
+  while ((state = ATOMIC_ACQUIRE(&waiter->state)) == COND_WAITING) {
+    futex_wait(&waiter->state, COND_WAITING);
+  }
+  return state;
+}
+
+/* The waiter may return and release its record as soon as the state is
+ * stored; the futex call only uses the address as a key. */
+static void cond_wake(cond_waiter_t *waiter, uint state) {
+  ATOMIC_RELEASE(&waiter->state, state);
+  futex_wake(&waiter->state, 1);
+}
+
+/* Once a requeued waiter owns the mutex it wakes the next waiter of the same
+ * broadcast, which then spins on its own place until the mutex is passed on.
+ * Only one morphed waiter spins at a time. */
+static void cond_handoff(cond_waiter_t *waiter) {
+  if (waiter->next_morphed != NULL) {
+    cond_wake(waiter->next_morphed, COND_REQUEUED);
+  }
+}
+
+typedef void (*cond_requeue_t)(void *mutex, cond_waiter_t *waiter);
+
+/* Moves up to `n` waiters from the condition to the mutex's queue, in FIFO
+ * order, and wakes the first one. Without `requeue` every waiter is woken to
+ * retry the mutex itself. */
+static void cond_transfer(cond_t *cond, void *mutex, cond_requeue_t requeue,
+                          uint n) {
+  cond_waiter_t *first = cond->head, *last = NULL, *waiter = cond->head;
+  if (first == NULL) {
+    return;
+  }
+  for (; waiter != NULL && n > 0; --n) {
+    cond_waiter_t *next = waiter->next;
+    if (requeue == NULL) {
+      cond_wake(waiter, COND_RETRY);
+    } else {
+      requeue(mutex, waiter);
+      if (last != NULL) {
+        last->next_morphed = waiter;
+      }
+      last = waiter;
+    }
+    waiter = next;
+  }
+  cond->head = waiter;
+  if (waiter == NULL) {
+    cond->tail = NULL;
+  }
+  if (requeue != NULL) {
+    cond_wake(first, COND_REQUEUED);
+  }
+}
+
+#define CREATE_COND_SIGNAL(type, requeue)                                      \
+  void cond_signal_##type(cond_t *cond, mutex_##type##_t *mutex) {             \
+    cond_transfer(cond, mutex, requeue, 1);                                    \
+  }                                                                            \
+                                                                               \
+  void cond_broadcast_##type(cond_t *cond, mutex_##type##_t *mutex) {          \
+    cond_transfer(cond, mutex, requeue, UINT_MAX);                             \
+  }
+
+void cond_wait_test_and_set(cond_t *cond, mutex_test_and_set_t *mutex) {
+  cond_waiter_t waiter;
+  cond_append(cond, &waiter);
+  mutex_unlock_test_and_set(mutex);
+  cond_park(&waiter);
+  mutex_lock_test_and_set(mutex);
+}
+
+CREATE_COND_SIGNAL(test_and_set, NULL)
+
+static void cond_requeue_ticket(void *mutex, cond_waiter_t *waiter) {
+  waiter->ticket = mutex_enqueue_ticket((mutex_ticket_t *)mutex);
+}
+
+void cond_wait_ticket(cond_t *cond, mutex_ticket_t *mutex) {
+  cond_waiter_t waiter;
+  cond_append(cond, &waiter);
+  mutex_unlock_ticket(mutex);
+  cond_park(&waiter);
+  mutex_wait_ticket(mutex, waiter.ticket);
+  cond_handoff(&waiter);
+}
+
+CREATE_COND_SIGNAL(ticket, cond_requeue_ticket)
+
+static void cond_requeue_Anderson(void *mutex, cond_waiter_t *waiter) {
+  mutex_enqueue_Anderson((mutex_Anderson_t *)mutex,
+                         (mutex_Anderson_ownership_t *)waiter->ownership);
+}
+
+void cond_wait_Anderson(cond_t *cond, mutex_Anderson_t *mutex,
+                        mutex_Anderson_ownership_t *ownership) {
+  cond_waiter_t waiter;
+  cond_append(cond, &waiter);
+  waiter.ownership = ownership;
+  mutex_unlock_Anderson(mutex, ownership);
+  cond_park(&waiter);
+  mutex_wait_Anderson(mutex, ownership);
+  cond_handoff(&waiter);
+}
+
+CREATE_COND_SIGNAL(Anderson, cond_requeue_Anderson)
+
+static void cond_requeue_GT(void *mutex, cond_waiter_t *waiter) {
+  waiter->last = mutex_enqueue_GT((mutex_GT_t *)mutex, waiter->tid);
+}
+
+void cond_wait_GT(cond_t *cond, mutex_GT_t *mutex) {
+  cond_waiter_t waiter;
+  cond_append(cond, &waiter);
+  waiter.tid = thread_current_id();
+  mutex_unlock_GT(mutex);
+  cond_park(&waiter);
+  mutex_wait_GT(mutex, waiter.last);
+  cond_handoff(&waiter);
+}
+
+CREATE_COND_SIGNAL(GT, cond_requeue_GT)
+
+static void cond_requeue_MCS(void *mutex, cond_waiter_t *waiter) {
+  mutex_enqueue_MCS((mutex_MCS_t *)mutex,
+                    (mutex_MCS_ownership_t *)waiter->ownership);
+}
+
+void cond_wait_MCS(cond_t *cond, mutex_MCS_t *mutex,
+                   mutex_MCS_ownership_t *ownership) {
+  cond_waiter_t waiter;
+  cond_append(cond, &waiter);
+  waiter.ownership = ownership;
+  mutex_unlock_MCS(mutex, ownership);
+  cond_park(&waiter);
+  mutex_wait_MCS(mutex, ownership);
+  cond_handoff(&waiter);
+}
+
+CREATE_COND_SIGNAL(MCS, cond_requeue_MCS)
+
+static void cond_requeue_CLH(void *mutex, cond_waiter_t *waiter) {
+  mutex_enqueue_CLH((mutex_CLH_t *)mutex, waiter->tid);
+}
+
+void cond_wait_CLH(cond_t *cond, mutex_CLH_t *mutex) {
+  cond_waiter_t waiter;
+  cond_append(cond, &waiter);
+  waiter.tid = thread_current_id();
+  mutex_unlock_CLH(mutex);
+  cond_park(&waiter);
+  mutex_wait_CLH(mutex, waiter.tid);
+  cond_handoff(&waiter);
+}
+
+CREATE_COND_SIGNAL(CLH, cond_requeue_CLH)
+
+/* Counting semaphore on a futex. Waiters announce themselves before
+ * sleeping, so posts skip the system call when nobody sleeps. */
+
+int semaphore_init_futex(semaphore_futex_t *semaphore, uint value) {
+  atomic_init(&semaphore->count, value);
+  atomic_init(&semaphore->waiters, 0);
+  return SUCCESS;
+}
+
+bool semaphore_try_wait_futex(semaphore_futex_t *semaphore) {
+  uint count = ATOMIC_LOAD(&semaphore->count);
+  while (count > 0) {
+    if (ATOMIC_COMPARE_EXCHANGE_ACQUIRE(&semaphore->count, &count,
+                                        count - 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void semaphore_wait_futex(semaphore_futex_t *semaphore) {
+  while (!semaphore_try_wait_futex(semaphore)) {
+    ATOMIC_ADD(&semaphore->waiters, 1);
+    ATOMIC_FENCE();
+    futex_wait(&semaphore->count, 0);
+    ATOMIC_SUB(&semaphore->waiters, 1);
+  }
+}
+
+void semaphore_post_futex(semaphore_futex_t *semaphore) {
+  atomic_fetch_add_explicit(&semaphore->count, 1, memory_order_release);
+  ATOMIC_FENCE();
+  if (ATOMIC_LOAD(&semaphore->waiters) > 0) {
+    futex_wake(&semaphore->count, 1);
+  }
+}
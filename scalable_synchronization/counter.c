@@ -0,0 +1,178 @@
+#include "synchronize.h"
+
+static uint ceiling_frac(uint num, uint den) { return (num - 1) / den + 1; }
+
+int counter_init_distributed(counter_distributed_t *counter, uint t_num) {
+  uint i;
+  padded_along_t *slots =
+      (padded_along_t *)slab_alloc(sizeof(padded_along_t) * t_num);
+  if (slots == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < t_num; ++i) {
+    atomic_init(&slots[i].value, 0);
+  }
+  counter->slots = slots;
+  counter->thread_num = t_num;
+  return SUCCESS;
+}
+
+void counter_destroy_distributed(counter_distributed_t *counter) {
+  slab_free(counter->slots);
+  counter->slots = NULL;
+}
+
+/* Each slot has a single writer, so no read-modify-write is needed. */
+void counter_add_distributed(counter_distributed_t *counter, long value) {
+  atomic_long *slot = &counter->slots[thread_current_id()].value;
+  ATOMIC_STORE(slot, ATOMIC_LOAD(slot) + value);
+}
+
+long counter_read_distributed(counter_distributed_t *counter) {
+  uint i;
+  long sum = 0;
+  for (i = 0; i < counter->thread_num; ++i) {
+    sum += ATOMIC_ACQUIRE(&counter->slots[i].value);
+  }
+  return sum;
+}
+
+int counter_init_sloppy(counter_sloppy_t *counter, uint t_num,
+                        long threshold) {
+  uint i;
+  padded_along_t *local =
+      (padded_along_t *)slab_alloc(sizeof(padded_along_t) * t_num);
+  if (local == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < t_num; ++i) {
+    atomic_init(&local[i].value, 0);
+  }
+  counter->local = local;
+  counter->thread_num = t_num;
+  counter->threshold = threshold;
+  atomic_init(&counter->global, 0);
+  return SUCCESS;
+}
+
+void counter_destroy_sloppy(counter_sloppy_t *counter) {
+  slab_free(counter->local);
+  counter->local = NULL;
+}
+
+/* The local part of every thread stays strictly below `threshold` in
+ * magnitude, so `counter_read_sloppy` is off by less than
+ * `thread_num * threshold`. */
+void counter_add_sloppy(counter_sloppy_t *counter, long value) {
+  atomic_long *local = &counter->local[thread_current_id()].value;
+  long pending = ATOMIC_LOAD(local) + value;
+  if (pending >= counter->threshold || pending <= -counter->threshold) {
+    ATOMIC_ADD(&counter->global, pending);
+    pending = 0;
+  }
+  ATOMIC_STORE(local, pending);
+}
+
+void counter_flush_sloppy(counter_sloppy_t *counter) {
+  atomic_long *local = &counter->local[thread_current_id()].value;
+  long pending = ATOMIC_LOAD(local);
+  if (pending != 0) {
+    ATOMIC_ADD(&counter->global, pending);
+    ATOMIC_STORE(local, 0);
+  }
+}
+
+long counter_read_sloppy(counter_sloppy_t *counter) {
+  return ATOMIC_ACQUIRE(&counter->global);
+}
+
+long counter_read_exact_sloppy(counter_sloppy_t *counter) {
+  uint i;
+  long sum = ATOMIC_ACQUIRE(&counter->global);
+  for (i = 0; i < counter->thread_num; ++i) {
+    sum += ATOMIC_ACQUIRE(&counter->local[i].value);
+  }
+  return sum;
+}
+
+/* Hierarchical SNZI (Ellen et al., PODC 2007) with one level of leaves, each
+ * shared by `SNZI_FAN_IN` threads. The root is a plain counter: only the
+ * 0 -> 1 and 1 -> 0 transitions of a leaf reach it. */
+
+#define SNZI_PACK(surplus, version) (((uint64_t)(version) << 32) | (surplus))
+#define SNZI_SURPLUS(state) ((uint)((state)&0xffffffffu))
+#define SNZI_VERSION(state) ((uint)((state) >> 32))
+
+int indicator_init_SNZI(indicator_SNZI_t *indicator, uint t_num) {
+  uint i, n_num = ceiling_frac(t_num, SNZI_FAN_IN);
+  padded_SNZI_node_t *leaves =
+      (padded_SNZI_node_t *)slab_alloc(sizeof(padded_SNZI_node_t) * n_num);
+  if (leaves == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < n_num; ++i) {
+    atomic_init(&leaves[i].value.state, SNZI_PACK(0, 0));
+  }
+  indicator->leaves = leaves;
+  atomic_init(&indicator->root.value, 0);
+  return SUCCESS;
+}
+
+void indicator_destroy_SNZI(indicator_SNZI_t *indicator) {
+  slab_free(indicator->leaves);
+  indicator->leaves = NULL;
+}
+
+void indicator_arrive_SNZI(indicator_SNZI_t *indicator) {
+  _Atomic uint64_t *leaf =
+      &indicator->leaves[thread_current_id() / SNZI_FAN_IN].value.state;
+  uint undo = 0;
+  bool done = false;
+
+  while (!done) {
+    uint64_t x = ATOMIC_LOAD(leaf);
+    uint surplus = SNZI_SURPLUS(x);
+
+    if (surplus >= 2) {
+      uint64_t expected = x;
+      done = ATOMIC_COMPARE_EXCHANGE(leaf, &expected, x + 2);
+    } else if (surplus == 0) {
+      uint64_t expected = x;
+      uint64_t half = SNZI_PACK(1, SNZI_VERSION(x) + 1);
+      if (ATOMIC_COMPARE_EXCHANGE(leaf, &expected, half)) {
+        done = true;
+        x = half;
+        surplus = 1;
+      }
+    }
+    if (surplus == 1) {
+      uint64_t expected = x;
+      ATOMIC_ADD(&indicator->root.value, 1);
+      if (!ATOMIC_COMPARE_EXCHANGE(leaf, &expected,
+                                   SNZI_PACK(2, SNZI_VERSION(x)))) {
+        ++undo;
+      }
+    }
+  }
+
+  while (undo > 0) {
+    ATOMIC_SUB(&indicator->root.value, 1);
+    --undo;
+  }
+}
+
+void indicator_depart_SNZI(indicator_SNZI_t *indicator) {
+  _Atomic uint64_t *leaf =
+      &indicator->leaves[thread_current_id() / SNZI_FAN_IN].value.state;
+  uint64_t x = ATOMIC_LOAD(leaf);
+  while (!ATOMIC_COMPARE_EXCHANGE(leaf, &x, x - 2)) {
+    delay(0);
+  }
+  if (SNZI_SURPLUS(x) == 2) {
+    ATOMIC_SUB(&indicator->root.value, 1);
+  }
+}
+
+bool indicator_query_SNZI(indicator_SNZI_t *indicator) {
+  return ATOMIC_ACQUIRE(&indicator->root.value) != 0;
+}
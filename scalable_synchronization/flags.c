@@ -0,0 +1,84 @@
+#include "synchronize.h"
+#include <immintrin.h>
+
+/* The vector kernel reads the flags with plain vector loads, which x86
+ * performs byte by byte atomically, and the acquire fence after a clear
+ * poll orders it like an acquire load of every flag. The kernel is chosen
+ * on the first poll, and compiled for AVX2 independently of the flags of
+ * the rest of the library. */
+
+_Static_assert(sizeof(atomic_bool) == 1, "flags must be single bytes");
+
+typedef bool (*flags_poll_t)(const atomic_bool *flags, uint vectors);
+
+static bool flags_any_scalar(const atomic_bool *flags, uint vectors) {
+  uint i;
+  for (i = 0; i < vectors * FLAGS_PER_VECTOR; ++i) {
+    if (ATOMIC_LOAD(&flags[i])) {
+      return true;
+    }
+  }
+  atomic_thread_fence(memory_order_acquire);
+  return false;
+}
+
+__attribute__((target("avx2"))) static bool
+flags_any_avx2(const atomic_bool *flags, uint vectors) {
+  uint i;
+  for (i = 0; i < vectors; ++i) {
+    const atomic_bool *vector = &flags[i * FLAGS_PER_VECTOR];
+    __m256i value = _mm256_loadu_si256((const __m256i *)vector);
+    if (!ATOMIC_TRACED(vector, ATOMIC_TRACE_READ,
+                       _mm256_testz_si256(value, value))) {
+      return true;
+    }
+  }
+  atomic_thread_fence(memory_order_acquire);
+  return false;
+}
+
+bool flags_vectorized() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+static bool flags_any_select(const atomic_bool *flags, uint vectors);
+
+static _Atomic flags_poll_t flags_poll = flags_any_select;
+
+static bool flags_any_select(const atomic_bool *flags, uint vectors) {
+  flags_poll_t poll = flags_vectorized() ? flags_any_avx2 : flags_any_scalar;
+  atomic_store_explicit(&flags_poll, poll, memory_order_relaxed);
+  return poll(flags, vectors);
+}
+
+bool flags_any(const atomic_bool *flags, uint vectors) {
+  return atomic_load_explicit(&flags_poll, memory_order_relaxed)(flags,
+                                                                 vectors);
+}
+
+/* Vectors are cache-line aligned, so a poll never splits a line */
+int flag_array_init(flag_array_t *array, uint size) {
+  uint i, vectors = (size + FLAGS_PER_VECTOR - 1) / FLAGS_PER_VECTOR;
+  uint bytes = (vectors * FLAGS_PER_VECTOR + CACHE_LINE_SIZE - 1) /
+               CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+  atomic_bool *flags;
+  if (size == 0) {
+    return LIB_INIT_INVALID;
+  }
+  flags = (atomic_bool *)slab_alloc(bytes);
+  if (flags == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < bytes; ++i) {
+    atomic_init(&flags[i], false);
+  }
+  array->flags = flags;
+  array->vectors = vectors;
+  return SUCCESS;
+}
+
+void flag_array_destroy(flag_array_t *array) {
+  slab_free(array->flags);
+  array->flags = NULL;
+}
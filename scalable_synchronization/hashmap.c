@@ -0,0 +1,310 @@
+#include "synchronize.h"
+
+/* Lock-striped hash map. Writers lock the stripe of a key's bucket; readers
+ * take no lock at all, since nodes are published with release stores and
+ * unlinked with a single store, and the epochs keep unlinked nodes alive for
+ * readers still walking them.
+ *
+ * The table doubles by incremental migration. Each bucket is copied into the
+ * next table under its stripe lock and then marked moved, readers follow
+ * moved buckets into the next table, and every writer migrates a few
+ * buckets until the old table can be retired. A table has at least as many
+ * buckets as there are stripes, so bucket `b` and its images `b` and
+ * `b + size` in the doubled table always share a stripe. */
+
+#ifdef HASHMAP_MUTEX_OWNERSHIP
+typedef HASHMAP_NAME(mutex_, HASHMAP_MUTEX, _ownership_t) stripe_ownership_t;
+#define stripe_lock(stripe, ownership)                                         \
+  HASHMAP_NAME(mutex_lock_, HASHMAP_MUTEX, )(&(stripe)->mutex, ownership)
+#define stripe_unlock(stripe, ownership)                                       \
+  HASHMAP_NAME(mutex_unlock_, HASHMAP_MUTEX, )(&(stripe)->mutex, ownership)
+#else
+typedef char stripe_ownership_t;
+#define stripe_lock(stripe, ownership)                                         \
+  HASHMAP_NAME(mutex_lock_, HASHMAP_MUTEX, )(&(stripe)->mutex)
+#define stripe_unlock(stripe, ownership)                                       \
+  HASHMAP_NAME(mutex_unlock_, HASHMAP_MUTEX, )(&(stripe)->mutex)
+#endif
+
+/* Head of a bucket whose nodes live in the next table */
+static hashmap_node_t moved;
+#define MOVED (&moved)
+
+static uint ceiling_2(uint n) {
+  uint i = 1;
+  while (i < n) {
+    i = i << 1;
+  }
+  return i;
+}
+
+static uint64_t hash(unsigned long key) {
+  uint64_t h = key;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+static hashmap_table_t *table_create(uint size) {
+  uint i;
+  hashmap_table_t *table = (hashmap_table_t *)slab_alloc(
+      sizeof(hashmap_table_t) + sizeof(padded_aptr_t) * size);
+  if (table == NULL) {
+    return NULL;
+  }
+  table->mask = size - 1;
+  atomic_init(&table->next, NULL);
+  atomic_init(&table->claimed.value, 0);
+  atomic_init(&table->migrated.value, 0);
+  for (i = 0; i < size; ++i) {
+    atomic_init(&table->buckets[i].value, NULL);
+  }
+  return table;
+}
+
+int hashmap_init(hashmap_t *map, uint t_num, uint stripes, uint capacity) {
+  uint i;
+  int retval;
+  hashmap_table_t *table;
+  padded_hashmap_stripe_t *stripe_array;
+
+  if (t_num == 0 || stripes == 0) {
+    return LIB_INIT_INVALID;
+  }
+  stripes = ceiling_2(stripes);
+  capacity = ceiling_2(capacity);
+  if (capacity < stripes) {
+    capacity = stripes;
+  }
+
+  stripe_array = (padded_hashmap_stripe_t *)slab_alloc(
+      sizeof(padded_hashmap_stripe_t) * stripes);
+  if (stripe_array == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  table = table_create(capacity);
+  if (table == NULL) {
+    slab_free(stripe_array);
+    return OUT_OF_MEMORY;
+  }
+  retval = reclaim_init_epoch(&map->epochs, t_num, slab_free);
+  if (retval != SUCCESS) {
+    slab_free(stripe_array);
+    slab_free(table);
+    return retval;
+  }
+
+  for (i = 0; i < stripes; ++i) {
+    HASHMAP_NAME(mutex_init_, HASHMAP_MUTEX, )(&stripe_array[i].value.mutex);
+    stripe_array[i].value.count = 0;
+  }
+  map->stripes = stripe_array;
+  map->stripe_mask = stripes - 1;
+  atomic_init(&map->table, table);
+  return SUCCESS;
+}
+
+void hashmap_destroy(hashmap_t *map) {
+  hashmap_table_t *table = ATOMIC_LOAD(&map->table);
+  reclaim_destroy_epoch(&map->epochs);
+  while (table != NULL) {
+    uint i;
+    hashmap_table_t *next = ATOMIC_LOAD(&table->next);
+    for (i = 0; i <= table->mask; ++i) {
+      hashmap_node_t *node = ATOMIC_LOAD(&table->buckets[i].value);
+      while (node != NULL && node != MOVED) {
+        hashmap_node_t *next_node = ATOMIC_LOAD(&node->next);
+        slab_free(node);
+        node = next_node;
+      }
+    }
+    slab_free(table);
+    table = next;
+  }
+  slab_free(map->stripes);
+  map->stripes = NULL;
+  atomic_init(&map->table, NULL);
+}
+
+static hashmap_node_t *chain_find(hashmap_node_t *node, unsigned long key) {
+  while (node != NULL && node->key != key) {
+    node = ATOMIC_ACQUIRE(&node->next);
+  }
+  return node;
+}
+
+/* Copies bucket `index` of `table` into the next table, with its stripe lock
+ * held. The bucket stays where it is if the copies cannot be allocated. */
+static bool bucket_migrate(hashmap_t *map, hashmap_table_t *table,
+                           uint index) {
+  hashmap_table_t *next = ATOMIC_ACQUIRE(&table->next);
+  hashmap_node_t *first = ATOMIC_LOAD(&table->buckets[index].value);
+  hashmap_node_t *heads[2] = {NULL, NULL};
+  hashmap_node_t *node;
+  uint size = table->mask + 1;
+
+  if (first == MOVED) {
+    return true;
+  }
+  for (node = first; node != NULL; node = ATOMIC_LOAD(&node->next)) {
+    hashmap_node_t *copy = (hashmap_node_t *)slab_alloc(sizeof(hashmap_node_t));
+    uint half = (hash(node->key) & next->mask) != index;
+    if (copy == NULL) {
+      for (half = 0; half < 2; ++half) {
+        while (heads[half] != NULL) {
+          copy = ATOMIC_LOAD(&heads[half]->next);
+          slab_free(heads[half]);
+          heads[half] = copy;
+        }
+      }
+      return false;
+    }
+    copy->key = node->key;
+    atomic_init(&copy->value, ATOMIC_LOAD(&node->value));
+    atomic_init(&copy->next, heads[half]);
+    heads[half] = copy;
+  }
+  ATOMIC_RELEASE(&next->buckets[index].value, heads[0]);
+  ATOMIC_RELEASE(&next->buckets[index + size].value, heads[1]);
+  ATOMIC_RELEASE(&table->buckets[index].value, MOVED);
+
+  for (node = first; node != NULL;) {
+    hashmap_node_t *next_node = ATOMIC_LOAD(&node->next);
+    reclaim_retire_epoch(&map->epochs, node);
+    node = next_node;
+  }
+  if (ATOMIC_ADD(&table->migrated.value, 1) == table->mask) {
+    ATOMIC_RELEASE(&map->table, next);
+    reclaim_retire_epoch(&map->epochs, table);
+  }
+  return true;
+}
+
+/* Migrates up to `HASHMAP_MIGRATE_BATCH` unclaimed buckets of an ongoing
+ * resize, taking one stripe lock at a time */
+static void resize_help(hashmap_t *map) {
+  uint i;
+  hashmap_table_t *table = ATOMIC_ACQUIRE(&map->table);
+  if (ATOMIC_ACQUIRE(&table->next) == NULL) {
+    return;
+  }
+  for (i = 0; i < HASHMAP_MIGRATE_BATCH; ++i) {
+    stripe_ownership_t ownership;
+    hashmap_stripe_t *stripe;
+    uint index = ATOMIC_ADD(&table->claimed.value, 1);
+    if (index > table->mask) {
+      return;
+    }
+    stripe = &map->stripes[index & map->stripe_mask].value;
+    stripe_lock(stripe, &ownership);
+    bucket_migrate(map, table, index);
+    stripe_unlock(stripe, &ownership);
+  }
+}
+
+/* Only the oldest live table grows, so tables are retired in order */
+static void resize_start(hashmap_t *map, hashmap_table_t *table) {
+  hashmap_table_t *next, *expected = NULL;
+  if (table != ATOMIC_LOAD(&map->table) ||
+      ATOMIC_LOAD(&table->next) != NULL) {
+    return;
+  }
+  next = table_create(2 * (table->mask + 1));
+  if (next != NULL &&
+      !ATOMIC_COMPARE_EXCHANGE_RELEASE(&table->next, &expected, next)) {
+    slab_free(next);
+  }
+}
+
+/* The table holding the bucket of `h`, with its stripe lock held. Buckets
+ * met on the way are migrated first, so writers never touch a moved one. */
+static hashmap_table_t *bucket_table(hashmap_t *map, uint64_t h) {
+  hashmap_table_t *table = ATOMIC_ACQUIRE(&map->table);
+  while (ATOMIC_ACQUIRE(&table->next) != NULL &&
+         bucket_migrate(map, table, h & table->mask)) {
+    table = ATOMIC_LOAD(&table->next);
+  }
+  return table;
+}
+
+bool hashmap_get(hashmap_t *map, unsigned long key, unsigned long *value) {
+  uint64_t h = hash(key);
+  hashmap_table_t *table;
+  hashmap_node_t *head, *node;
+
+  reclaim_enter_epoch(&map->epochs);
+  table = ATOMIC_ACQUIRE(&map->table);
+  while ((head = ATOMIC_ACQUIRE(&table->buckets[h & table->mask].value)) ==
+         MOVED) {
+    table = ATOMIC_ACQUIRE(&table->next);
+  }
+  node = chain_find(head, key);
+  if (node != NULL) {
+    *value = ATOMIC_ACQUIRE(&node->value);
+  }
+  reclaim_exit_epoch(&map->epochs);
+  return node != NULL;
+}
+
+bool hashmap_put(hashmap_t *map, unsigned long key, unsigned long value) {
+  uint64_t h = hash(key);
+  hashmap_stripe_t *stripe = &map->stripes[h & map->stripe_mask].value;
+  stripe_ownership_t ownership;
+  hashmap_table_t *table;
+  atomic_ptr_t *bucket;
+  hashmap_node_t *node;
+  bool inserted = false;
+
+  reclaim_enter_epoch(&map->epochs);
+  resize_help(map);
+  stripe_lock(stripe, &ownership);
+  table = bucket_table(map, h);
+  bucket = &table->buckets[h & table->mask].value;
+  node = chain_find(ATOMIC_LOAD(bucket), key);
+  if (node != NULL) {
+    ATOMIC_RELEASE(&node->value, value);
+  } else if ((node = (hashmap_node_t *)slab_alloc(
+                  sizeof(hashmap_node_t))) != NULL) {
+    node->key = key;
+    atomic_init(&node->value, value);
+    atomic_init(&node->next, ATOMIC_LOAD(bucket));
+    ATOMIC_RELEASE(bucket, node);
+    inserted = true;
+    if (++stripe->count > HASHMAP_LOAD_FACTOR * (table->mask + 1) /
+                              (map->stripe_mask + 1)) {
+      resize_start(map, table);
+    }
+  }
+  stripe_unlock(stripe, &ownership);
+  reclaim_exit_epoch(&map->epochs);
+  return inserted;
+}
+
+bool hashmap_remove(hashmap_t *map, unsigned long key) {
+  uint64_t h = hash(key);
+  hashmap_stripe_t *stripe = &map->stripes[h & map->stripe_mask].value;
+  stripe_ownership_t ownership;
+  hashmap_table_t *table;
+  atomic_ptr_t *link;
+  hashmap_node_t *node;
+
+  reclaim_enter_epoch(&map->epochs);
+  resize_help(map);
+  stripe_lock(stripe, &ownership);
+  table = bucket_table(map, h);
+  link = &table->buckets[h & table->mask].value;
+  while ((node = ATOMIC_LOAD(link)) != NULL && node->key != key) {
+    link = &node->next;
+  }
+  if (node != NULL) {
+    ATOMIC_RELEASE(link, ATOMIC_LOAD(&node->next));
+    reclaim_retire_epoch(&map->epochs, node);
+    --stripe->count;
+  }
+  stripe_unlock(stripe, &ownership);
+  reclaim_exit_epoch(&map->epochs);
+  return node != NULL;
+}
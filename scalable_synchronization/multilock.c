@@ -0,0 +1,109 @@
+#include "synchronize.h"
+
+/* Locks are always taken in increasing address order, so multi-lock
+ * acquisitions cannot wait for each other in a cycle. The MCS and CLH
+ * versions take their place in every queue first and only then wait, so
+ * the waits overlap instead of adding up. Their enqueue phase is atomic
+ * within a domain: two acquisitions enqueued concurrently could otherwise
+ * be ahead of each other on two different locks and deadlock. */
+
+#define CREATE_SORT(name, type)                                                \
+  static void sort_##name(type *mutexes, uint n) {                             \
+    uint i, j;                                                                 \
+    for (i = 1; i < n; ++i) {                                                  \
+      type mutex = mutexes[i];                                                 \
+      for (j = i; j > 0 && (uintptr_t)mutexes[j - 1] > (uintptr_t)mutex;       \
+           --j) {                                                              \
+        mutexes[j] = mutexes[j - 1];                                           \
+      }                                                                        \
+      mutexes[j] = mutex;                                                      \
+    }                                                                          \
+  }
+
+CREATE_SORT(any, void *)
+CREATE_SORT(MCS, mutex_MCS_t *)
+CREATE_SORT(CLH, mutex_CLH_t *)
+
+/* Whether the i-th lock of a sorted array is a repeat of the previous one */
+#define REPEATED(mutexes_, i_)                                                 \
+  ((i_) > 0 && (mutexes_)[i_] == (mutexes_)[(i_)-1])
+
+void mutex_lock_multi(const rwlock_mutex_t *operations, void **mutexes,
+                      void **ownerships, uint n) {
+  uint i;
+  sort_any(mutexes, n);
+  for (i = 0; i < n; ++i) {
+    if (!REPEATED(mutexes, i)) {
+      operations->lock(mutexes[i], ownerships ? ownerships[i] : NULL);
+    }
+  }
+}
+
+void mutex_unlock_multi(const rwlock_mutex_t *operations, void **mutexes,
+                        void **ownerships, uint n) {
+  uint i;
+  for (i = n; i-- > 0;) {
+    if (!REPEATED(mutexes, i)) {
+      operations->unlock(mutexes[i], ownerships ? ownerships[i] : NULL);
+    }
+  }
+}
+
+int mutex_init_multi(mutex_multi_t *domain) {
+  return mutex_init_ticket(&domain->enqueue);
+}
+
+void mutex_lock_multi_MCS(mutex_multi_t *domain, mutex_MCS_t **mutexes,
+                          mutex_MCS_ownership_t *ownerships, uint n) {
+  uint i;
+  sort_MCS(mutexes, n);
+  mutex_lock_ticket(&domain->enqueue);
+  for (i = 0; i < n; ++i) {
+    if (!REPEATED(mutexes, i)) {
+      mutex_enqueue_MCS(mutexes[i], &ownerships[i]);
+    }
+  }
+  mutex_unlock_ticket(&domain->enqueue);
+  for (i = 0; i < n; ++i) {
+    if (!REPEATED(mutexes, i)) {
+      mutex_wait_MCS(mutexes[i], &ownerships[i]);
+    }
+  }
+}
+
+void mutex_unlock_multi_MCS(mutex_MCS_t **mutexes,
+                            mutex_MCS_ownership_t *ownerships, uint n) {
+  uint i;
+  for (i = 0; i < n; ++i) {
+    if (!REPEATED(mutexes, i)) {
+      mutex_unlock_MCS(mutexes[i], &ownerships[i]);
+    }
+  }
+}
+
+void mutex_lock_multi_CLH(mutex_multi_t *domain, mutex_CLH_t **mutexes,
+                          uint n) {
+  uint i, tid = thread_current_id();
+  sort_CLH(mutexes, n);
+  mutex_lock_ticket(&domain->enqueue);
+  for (i = 0; i < n; ++i) {
+    if (!REPEATED(mutexes, i)) {
+      mutex_enqueue_CLH(mutexes[i], tid);
+    }
+  }
+  mutex_unlock_ticket(&domain->enqueue);
+  for (i = 0; i < n; ++i) {
+    if (!REPEATED(mutexes, i)) {
+      mutex_wait_CLH(mutexes[i], tid);
+    }
+  }
+}
+
+void mutex_unlock_multi_CLH(mutex_CLH_t **mutexes, uint n) {
+  uint i;
+  for (i = 0; i < n; ++i) {
+    if (!REPEATED(mutexes, i)) {
+      mutex_unlock_CLH(mutexes[i]);
+    }
+  }
+}
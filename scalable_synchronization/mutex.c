@@ -1,10 +1,10 @@
 #include "synchronize.h"
-#include <stdlib.h>
+#define THREAD_LOCAL _Thread_local
 
 static uint ceiling_2(uint n) {
   uint i = 2;
   while (i < n) {
-    i = i << 2;
+    i = i << 1;
   }
   return i;
 }
@@ -42,11 +42,96 @@ void mutex_unlock_ticket(mutex_ticket_t *mutex) {
   ATOMIC_RELEASE(&mutex->now_serving, next);
 }
 
+int mutex_init_partitioned_ticket(mutex_partitioned_ticket_t *mutex,
+                                  uint t_num) {
+  uint i;
+  uint slots = ceiling_2(t_num);
+  padded_auint_t *grants =
+      (padded_auint_t *)slab_alloc(sizeof(padded_auint_t) * slots);
+
+  if (grants == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  mutex->grants = grants;
+  mutex->mask = slots - 1;
+
+  /* Slot `i` holds a ticket that is never drawn before ticket `i` */
+  atomic_init(&grants[0].value, 0);
+  for (i = 1; i < slots; ++i) {
+    atomic_init(&grants[i].value, i - slots);
+  }
+  atomic_init(&mutex->new_ticket, 0);
+  atomic_init(&mutex->now_serving, 0);
+  return SUCCESS;
+}
+
+void mutex_destroy_partitioned_ticket(mutex_partitioned_ticket_t *mutex) {
+  slab_free(mutex->grants);
+  mutex->grants = NULL;
+}
+
+void mutex_lock_partitioned_ticket(mutex_partitioned_ticket_t *mutex) {
+  uint my_ticket = ATOMIC_ADD(&mutex->new_ticket, 1);
+  while (ATOMIC_ACQUIRE(&mutex->grants[my_ticket & mutex->mask].value) !=
+         my_ticket) {
+    delay(0);
+  }
+  ATOMIC_STORE(&mutex->now_serving, my_ticket);
+}
+
+void mutex_unlock_partitioned_ticket(mutex_partitioned_ticket_t *mutex) {
+  uint next = ATOMIC_LOAD(&mutex->now_serving) + 1;
+  ATOMIC_RELEASE(&mutex->grants[next & mutex->mask].value, next);
+}
+
+static atomic_uint TWA_waiting[MUTEX_TWA_SLOTS];
+
+static atomic_uint *TWA_slot(mutex_TWA_t *mutex, uint ticket) {
+  return &TWA_waiting[(((uintptr_t)mutex >> 4) * 17 + ticket * 127) &
+                      (MUTEX_TWA_SLOTS - 1)];
+}
+
+int mutex_init_TWA(mutex_TWA_t *mutex) {
+  atomic_init(&mutex->ticket, 0);
+  atomic_init(&mutex->grant, 0);
+  return SUCCESS;
+}
+
+/* A long-term waiter reads its slot before checking `grant`, and the
+ * release of ticket `t` bumps the slot of ticket `t + MUTEX_TWA_LONG_TERM`
+ * after publishing `grant`, so a waiter never misses its wake-up. Other
+ * locks hashing to the same slot only cause spurious rechecks. */
+void mutex_lock_TWA(mutex_TWA_t *mutex) {
+  uint my_ticket = ATOMIC_ADD(&mutex->ticket, 1);
+  if (my_ticket - ATOMIC_LOAD(&mutex->grant) > MUTEX_TWA_LONG_TERM) {
+    atomic_uint *slot = TWA_slot(mutex, my_ticket);
+    for (;;) {
+      uint seen = ATOMIC_ACQUIRE(slot);
+      if (my_ticket - ATOMIC_LOAD(&mutex->grant) <= MUTEX_TWA_LONG_TERM) {
+        break;
+      }
+      while (ATOMIC_LOAD(slot) == seen) {
+        delay(0);
+      }
+    }
+  }
+  while (ATOMIC_ACQUIRE(&mutex->grant) != my_ticket) {
+    delay(0);
+  }
+}
+
+void mutex_unlock_TWA(mutex_TWA_t *mutex) {
+  uint next = ATOMIC_LOAD(&mutex->grant) + 1;
+  ATOMIC_RELEASE(&mutex->grant, next);
+  atomic_thread_fence(memory_order_release);
+  ATOMIC_ADD(TWA_slot(mutex, next + MUTEX_TWA_LONG_TERM), 1);
+}
+
 int mutex_init_Anderson(mutex_Anderson_t *mutex, uint thread_num) {
   uint i;
   uint tnum = ceiling_2(thread_num);
   padded_abool_t *slots =
-      (padded_abool_t *)malloc(sizeof(padded_abool_t) * tnum);
+      (padded_abool_t *)slab_alloc(sizeof(padded_abool_t) * tnum);
 
   if (slots == NULL) {
     return OUT_OF_MEMORY;
@@ -63,7 +148,7 @@ int mutex_init_Anderson(mutex_Anderson_t *mutex, uint thread_num) {
 }
 
 void mutex_destroy_Anderson(mutex_Anderson_t *mutex) {
-  free(mutex->slots);
+  slab_free(mutex->slots);
   mutex->slots = NULL;
 }
 
@@ -88,7 +173,7 @@ int mutex_init_GT(mutex_GT_t *mutex, uint t_num) {
   padded_abool_t *slots;
   mutex_GT_tail_t init_value = {0, false};
 
-  slots = (padded_abool_t *)malloc(sizeof(padded_abool_t) * t_num);
+  slots = (padded_abool_t *)slab_alloc(sizeof(padded_abool_t) * t_num);
   if (slots == NULL) {
     return OUT_OF_MEMORY;
   }
@@ -103,7 +188,7 @@ int mutex_init_GT(mutex_GT_t *mutex, uint t_num) {
 }
 
 void mutex_destroy_GT(mutex_GT_t *mutex) {
-  free(mutex->slots);
+  slab_free(mutex->slots);
   mutex->slots = NULL;
 }
 
@@ -122,6 +207,33 @@ void mutex_unlock_GT(mutex_GT_t *mutex) {
   ATOMIC_RELEASE(&mutex->slots[tid].value, !value);
 }
 
+/* Granted asynchronous waiters of this thread, see `mutex_lock_async_MCS` */
+static THREAD_LOCAL mutex_MCS_async_ownership_t *ready_head, *ready_tail;
+static THREAD_LOCAL bool dispatching;
+
+static void async_grant(mutex_MCS_async_ownership_t *ownership) {
+  ownership->next_ready = NULL;
+  if (ready_tail == NULL) {
+    ready_head = ownership;
+  } else {
+    ready_tail->next_ready = ownership;
+  }
+  ready_tail = ownership;
+  if (dispatching) {
+    return;
+  }
+  dispatching = true;
+  while (ready_head != NULL) {
+    ownership = ready_head;
+    ready_head = ownership->next_ready;
+    if (ready_head == NULL) {
+      ready_tail = NULL;
+    }
+    ownership->callback(ownership->arg);
+  }
+  dispatching = false;
+}
+
 int mutex_init_MCS(mutex_MCS_t *mutex) {
   atomic_init(&mutex->tail, NULL);
   return SUCCESS;
@@ -151,7 +263,12 @@ void mutex_unlock_MCS(mutex_MCS_t *mutex, mutex_MCS_ownership_t *ownership) {
       delay(0);
     }
   }
-  successor = ATOMIC_LOAD(&ownership->next);
+  successor = ATOMIC_ACQUIRE(&ownership->next);
+  if ((uintptr_t)successor & MUTEX_MCS_ASYNC) {
+    async_grant((mutex_MCS_async_ownership_t *)((uintptr_t)successor &
+                                                ~MUTEX_MCS_ASYNC));
+    return;
+  }
   ATOMIC_RELEASE(&successor->locked, false);
 }
 
@@ -160,11 +277,11 @@ int mutex_init_CLH(mutex_CLH_t *mutex, uint t_num) {
   padded_abool_t *slots;
   padded_CLH_state_t *states;
 
-  slots = (padded_abool_t *)malloc(sizeof(padded_abool_t) * (t_num + 1));
+  slots = (padded_abool_t *)slab_alloc(sizeof(padded_abool_t) * (t_num + 1));
   if (slots == NULL) {
     return OUT_OF_MEMORY;
   }
-  states = (padded_CLH_state_t *)malloc(sizeof(padded_CLH_state_t) * t_num);
+  states = (padded_CLH_state_t *)slab_alloc(sizeof(padded_CLH_state_t) * t_num);
   if (states == NULL) {
     return OUT_OF_MEMORY;
   }
@@ -182,8 +299,8 @@ int mutex_init_CLH(mutex_CLH_t *mutex, uint t_num) {
 }
 
 void mutex_destroy_CLH(mutex_CLH_t *mutex) {
-  free(mutex->slots);
-  free(mutex->states);
+  slab_free(mutex->slots);
+  slab_free(mutex->states);
   mutex->slots = NULL;
   mutex->states = NULL;
 }
@@ -202,4 +319,291 @@ void mutex_unlock_CLH(mutex_CLH_t *mutex) {
   mutex_CLH_state_t *current_state = &mutex->states[thread_current_id()].value;
   ATOMIC_RELEASE(&mutex->slots[current_state->my_id].value, true);
   current_state->my_id = current_state->watching;
-}
\ No newline at end of file
+}
+
+/* Malthusian MCS (Dice, EuroSys 2017). When the successor already has a
+ * successor of its own, the owner moves it to a passive list, so only the
+ * owner and one waiter circulate through the caches. Passive waiters keep
+ * spinning on their own node and re-enter ahead of the queue when it drains,
+ * and one of them every `MALTHUSIAN_FAIRNESS` handoffs for long-term
+ * fairness. */
+
+int mutex_init_Malthusian(mutex_Malthusian_t *mutex) {
+  atomic_init(&mutex->tail, NULL);
+  mutex->passive_head = NULL;
+  mutex->passive_tail = NULL;
+  mutex->handoffs = 0;
+  return SUCCESS;
+}
+
+void mutex_lock_Malthusian(mutex_Malthusian_t *mutex,
+                           mutex_Malthusian_ownership_t *ownership) {
+  mutex_MCS_ownership_t *predecessor;
+  atomic_init(&ownership->next, NULL);
+  atomic_init(&ownership->locked, true);
+  predecessor = ATOMIC_ACQUIRE_EXCHANGE(&mutex->tail, ownership);
+  if (predecessor != NULL) {
+    ATOMIC_RELEASE(&predecessor->next, ownership);
+    while (ATOMIC_ACQUIRE(&ownership->locked)) {
+      delay(0);
+    }
+  }
+}
+
+static void passive_push(mutex_Malthusian_t *mutex,
+                         mutex_MCS_ownership_t *node) {
+  ATOMIC_STORE(&node->next, NULL);
+  if (mutex->passive_tail == NULL) {
+    mutex->passive_head = node;
+  } else {
+    ATOMIC_STORE(&mutex->passive_tail->next, node);
+  }
+  mutex->passive_tail = node;
+}
+
+static mutex_MCS_ownership_t *passive_pop(mutex_Malthusian_t *mutex) {
+  mutex_MCS_ownership_t *node = mutex->passive_head;
+  mutex->passive_head = ATOMIC_LOAD(&node->next);
+  if (mutex->passive_head == NULL) {
+    mutex->passive_tail = NULL;
+  }
+  return node;
+}
+
+void mutex_unlock_Malthusian(mutex_Malthusian_t *mutex,
+                             mutex_Malthusian_ownership_t *ownership) {
+  mutex_MCS_ownership_t *successor, *next;
+  if (ATOMIC_ACQUIRE(&ownership->next) == NULL) {
+    mutex_MCS_ownership_t *expected = ownership;
+    if (mutex->passive_head != NULL) {
+      mutex_MCS_ownership_t *passive = passive_pop(mutex);
+      ATOMIC_STORE(&passive->next, NULL);
+      if (ATOMIC_COMPARE_EXCHANGE_RELEASE(&mutex->tail, &expected, passive)) {
+        ATOMIC_RELEASE(&passive->locked, false);
+        return;
+      }
+      while ((next = ATOMIC_ACQUIRE(&ownership->next)) == NULL) {
+        delay(0);
+      }
+      ATOMIC_STORE(&passive->next, next);
+      ATOMIC_RELEASE(&passive->locked, false);
+      return;
+    }
+    if (ATOMIC_COMPARE_EXCHANGE_RELEASE(&mutex->tail, &expected, NULL)) {
+      return;
+    }
+    while (ATOMIC_ACQUIRE(&ownership->next) == NULL) {
+      delay(0);
+    }
+  }
+  successor = ATOMIC_LOAD(&ownership->next);
+
+  next = ATOMIC_ACQUIRE(&successor->next);
+  if (next != NULL) {
+    passive_push(mutex, successor);
+    successor = next;
+  }
+  if (mutex->passive_head != NULL &&
+      ++mutex->handoffs % MALTHUSIAN_FAIRNESS == 0) {
+    mutex_MCS_ownership_t *passive = passive_pop(mutex);
+    ATOMIC_STORE(&passive->next, successor);
+    successor = passive;
+  }
+  ATOMIC_RELEASE(&successor->locked, false);
+}
+
+/* Shuffle lock (Kashyap et al., SOSP 2019) on MCS nodes. Waiters reorder the
+ * queue behind themselves while they spin, so the holder's paths are plain
+ * MCS. One waiter at a time is the shuffler: it keeps walking the queue from
+ * its own node and moves every waiter the policy accepts right behind the
+ * last member of its group. Once the group grew it hands the role to that
+ * member, and a shuffler that gets the lock hands it to its successor. Only
+ * nodes behind a waiting shuffler are moved, and never the tail, so neither
+ * the holder nor arriving threads see a node being relinked. */
+
+bool mutex_shuffle_same_key(const mutex_shuffle_ownership_t *shuffler,
+                            const mutex_shuffle_ownership_t *waiter) {
+  return waiter->key == shuffler->key;
+}
+
+/* Waiters with a non-zero key are latency critical */
+bool mutex_shuffle_priority(const mutex_shuffle_ownership_t *shuffler,
+                            const mutex_shuffle_ownership_t *waiter) {
+  return waiter->key > 0 && waiter->key >= shuffler->key;
+}
+
+int mutex_init_shuffle(mutex_shuffle_t *mutex, mutex_shuffle_policy_t policy) {
+  mutex_init_MCS(&mutex->queue);
+  atomic_init(&mutex->shuffling, false);
+  mutex->policy = (policy == NULL) ? mutex_shuffle_same_key : policy;
+  return SUCCESS;
+}
+
+/* Returns whether the shuffler role was handed on */
+static bool shuffle_pass(mutex_shuffle_t *mutex,
+                         mutex_shuffle_ownership_t *self) {
+  mutex_MCS_ownership_t *last = &self->qnode, *prev = &self->qnode;
+  uint scanned;
+  for (scanned = 0; scanned < MUTEX_SHUFFLE_SCAN &&
+                    ATOMIC_LOAD(&self->qnode.locked);
+       ++scanned) {
+    mutex_MCS_ownership_t *current = ATOMIC_ACQUIRE(&prev->next), *next;
+    mutex_shuffle_ownership_t *waiter = (mutex_shuffle_ownership_t *)current;
+    if (current == NULL ||
+        ((mutex_shuffle_ownership_t *)last)->batch >= MUTEX_SHUFFLE_BATCH) {
+      break;
+    }
+    if (!mutex->policy(self, waiter)) {
+      prev = current;
+      continue;
+    }
+    next = ATOMIC_ACQUIRE(&current->next);
+    if (prev == last) {
+      prev = current;
+    } else if (next != NULL) {
+      ATOMIC_STORE(&prev->next, next);
+      ATOMIC_STORE(&current->next, ATOMIC_LOAD(&last->next));
+      ATOMIC_RELEASE(&last->next, current);
+    } else {
+      break;
+    }
+    waiter->batch = ((mutex_shuffle_ownership_t *)last)->batch + 1;
+    last = current;
+  }
+  if (last == &self->qnode) {
+    return false;
+  }
+  ATOMIC_RELEASE(&((mutex_shuffle_ownership_t *)last)->shuffler, true);
+  return true;
+}
+
+void mutex_lock_shuffle(mutex_shuffle_t *mutex,
+                        mutex_shuffle_ownership_t *ownership) {
+  mutex_MCS_ownership_t *predecessor, *successor;
+  bool shuffler;
+  ownership->batch = 0;
+  atomic_init(&ownership->shuffler, false);
+  atomic_init(&ownership->qnode.next, NULL);
+  atomic_init(&ownership->qnode.locked, true);
+  predecessor = ATOMIC_ACQUIRE_EXCHANGE(&mutex->queue.tail, &ownership->qnode);
+  if (predecessor == NULL) {
+    return;
+  }
+  ATOMIC_RELEASE(&predecessor->next, &ownership->qnode);
+  /* A new waiter takes the role if nobody holds it */
+  shuffler = !ATOMIC_LOAD(&mutex->shuffling) &&
+             !ATOMIC_ACQUIRE_EXCHANGE(&mutex->shuffling, true);
+  while (ATOMIC_ACQUIRE(&ownership->qnode.locked)) {
+    if (!shuffler && ATOMIC_ACQUIRE(&ownership->shuffler)) {
+      ATOMIC_STORE(&ownership->shuffler, false);
+      shuffler = true;
+    }
+    if (shuffler && shuffle_pass(mutex, ownership)) {
+      shuffler = false;
+    }
+    delay(0);
+  }
+  if (shuffler || ATOMIC_ACQUIRE(&ownership->shuffler)) {
+    successor = ATOMIC_ACQUIRE(&ownership->qnode.next);
+    if (successor != NULL) {
+      ATOMIC_RELEASE(&((mutex_shuffle_ownership_t *)successor)->shuffler,
+                     true);
+    } else {
+      ATOMIC_RELEASE(&mutex->shuffling, false);
+    }
+  }
+}
+
+void mutex_unlock_shuffle(mutex_shuffle_t *mutex,
+                          mutex_shuffle_ownership_t *ownership) {
+  mutex_unlock_MCS(&mutex->queue, &ownership->qnode);
+}
+
+/* Split-phase acquisition: `mutex_enqueue_*` takes a place in the lock's
+ * queue, possibly on behalf of another thread, and `mutex_wait_*` spins
+ * until that place is granted. */
+
+uint mutex_enqueue_ticket(mutex_ticket_t *mutex) {
+  return ATOMIC_ADD(&mutex->new_ticket, 1);
+}
+
+void mutex_wait_ticket(mutex_ticket_t *mutex, uint ticket) {
+  while (ATOMIC_ACQUIRE(&mutex->now_serving) != ticket) {
+    delay(0);
+  }
+}
+
+void mutex_enqueue_Anderson(mutex_Anderson_t *mutex,
+                            mutex_Anderson_ownership_t *ownership) {
+  ownership->my_place = ATOMIC_ADD(&mutex->next_slot, 1) & mutex->mask;
+}
+
+void mutex_wait_Anderson(mutex_Anderson_t *mutex,
+                         mutex_Anderson_ownership_t *ownership) {
+  while (ATOMIC_ACQUIRE(&mutex->slots[ownership->my_place].value)) {
+    delay(0);
+  }
+  ATOMIC_STORE(&mutex->slots[ownership->my_place].value, true);
+}
+
+mutex_GT_tail_t mutex_enqueue_GT(mutex_GT_t *mutex, uint tid) {
+  mutex_GT_tail_t current = {tid, ATOMIC_LOAD(&mutex->slots[tid].value)};
+  return ATOMIC_EXCHANGE(&mutex->tail, current);
+}
+
+void mutex_wait_GT(mutex_GT_t *mutex, mutex_GT_tail_t last) {
+  while (ATOMIC_ACQUIRE(&mutex->slots[last.id].value) == last.locked) {
+    delay(0);
+  }
+}
+
+bool mutex_enqueue_MCS(mutex_MCS_t *mutex, mutex_MCS_ownership_t *ownership) {
+  mutex_MCS_ownership_t *predecessor;
+  atomic_init(&ownership->next, NULL);
+  atomic_init(&ownership->locked, true);
+  predecessor = ATOMIC_EXCHANGE(&mutex->tail, ownership);
+  if (predecessor == NULL) {
+    ATOMIC_STORE(&ownership->locked, false);
+    return true;
+  }
+  ATOMIC_RELEASE(&predecessor->next, ownership);
+  return false;
+}
+
+void mutex_wait_MCS(mutex_MCS_t *mutex, mutex_MCS_ownership_t *ownership) {
+  while (ATOMIC_ACQUIRE(&ownership->locked)) {
+    delay(0);
+  }
+}
+
+void mutex_enqueue_CLH(mutex_CLH_t *mutex, uint tid) {
+  mutex_CLH_state_t *state = &mutex->states[tid].value;
+  ATOMIC_STORE(&mutex->slots[state->my_id].value, false);
+  state->watching = ATOMIC_EXCHANGE(&mutex->tail, state->my_id);
+}
+
+void mutex_wait_CLH(mutex_CLH_t *mutex, uint tid) {
+  mutex_CLH_state_t *state = &mutex->states[tid].value;
+  while (!ATOMIC_ACQUIRE(&mutex->slots[state->watching].value)) {
+    delay(0);
+  }
+}
+
+bool mutex_lock_async_MCS(mutex_MCS_t *mutex,
+                          mutex_MCS_async_ownership_t *ownership,
+                          mutex_MCS_callback_t callback, void *arg) {
+  mutex_MCS_ownership_t *predecessor;
+  ownership->callback = callback;
+  ownership->arg = arg;
+  atomic_init(&ownership->qnode.next, NULL);
+  atomic_init(&ownership->qnode.locked, true);
+  predecessor = ATOMIC_EXCHANGE(&mutex->tail, &ownership->qnode);
+  if (predecessor == NULL) {
+    ATOMIC_STORE(&ownership->qnode.locked, false);
+    return true;
+  }
+  ATOMIC_RELEASE(&predecessor->next,
+                 (mutex_MCS_ownership_t *)((uintptr_t)&ownership->qnode |
+                                           MUTEX_MCS_ASYNC));
+  return false;
+}
@@ -0,0 +1,242 @@
+#include "synchronize.h"
+
+/* Array-based locks pay for one padded slot per thread, and CLH for one
+ * padded node per thread too, in every lock instance. The pooled variants
+ * keep a single, shared set of padded spin cells and CLH nodes per thread,
+ * so a lock shrinks to a few words: a thread only needs a cell while it
+ * waits for or holds a lock, never one per lock it might ever touch. */
+
+static uint ceiling_2(uint n) {
+  uint i = 2;
+  while (i < n) {
+    i = i << 1;
+  }
+  return i;
+}
+
+int mutex_pool_init(mutex_pool_t *pool, uint t_num) {
+  uint i, j;
+  padded_auint_t *cells;
+  padded_pool_thread_t *threads;
+
+  if (t_num == 0) {
+    return LIB_INIT_INVALID;
+  }
+  cells = (padded_auint_t *)slab_alloc(sizeof(padded_auint_t) * t_num *
+                                       MUTEX_POOL_DEPTH);
+  if (cells == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  threads =
+      (padded_pool_thread_t *)slab_alloc(sizeof(padded_pool_thread_t) * t_num);
+  if (threads == NULL) {
+    slab_free(cells);
+    return OUT_OF_MEMORY;
+  }
+  pool->cells = cells;
+  pool->threads = threads;
+  pool->thread_num = t_num;
+
+  for (i = 0; i < t_num * MUTEX_POOL_DEPTH; ++i) {
+    atomic_init(&cells[i].value, 0);
+  }
+  for (i = 0; i < t_num; ++i) {
+    mutex_pool_thread_t *thread = &threads[i].value;
+    thread->free_cell_num = MUTEX_POOL_DEPTH;
+    thread->free_nodes = NULL;
+    for (j = 0; j < MUTEX_POOL_DEPTH; ++j) {
+      padded_CLH_node_t *node =
+          (padded_CLH_node_t *)slab_alloc(sizeof(padded_CLH_node_t));
+      if (node == NULL) {
+        pool->thread_num = i + 1;
+        mutex_pool_destroy(pool);
+        return OUT_OF_MEMORY;
+      }
+      thread->free_cells[j] = i * MUTEX_POOL_DEPTH + j;
+      node->value.next_free = thread->free_nodes;
+      thread->free_nodes = node;
+    }
+  }
+  return SUCCESS;
+}
+
+/* Every pooled lock must be destroyed first, so that all CLH nodes are back
+ * in some thread's free list */
+void mutex_pool_destroy(mutex_pool_t *pool) {
+  uint i;
+  for (i = 0; i < pool->thread_num; ++i) {
+    padded_CLH_node_t *node = pool->threads[i].value.free_nodes;
+    while (node != NULL) {
+      padded_CLH_node_t *next = (padded_CLH_node_t *)node->value.next_free;
+      slab_free(node);
+      node = next;
+    }
+  }
+  slab_free(pool->cells);
+  slab_free(pool->threads);
+  pool->cells = NULL;
+  pool->threads = NULL;
+}
+
+static uint pool_get_cell(mutex_pool_t *pool) {
+  mutex_pool_thread_t *thread = &pool->threads[thread_current_id()].value;
+  return thread->free_cells[--thread->free_cell_num];
+}
+
+static void pool_put_cell(mutex_pool_t *pool, uint cell) {
+  mutex_pool_thread_t *thread = &pool->threads[thread_current_id()].value;
+  thread->free_cells[thread->free_cell_num++] = cell;
+}
+
+static padded_CLH_node_t *pool_get_node(mutex_pool_t *pool) {
+  mutex_pool_thread_t *thread = &pool->threads[thread_current_id()].value;
+  padded_CLH_node_t *node = thread->free_nodes;
+  thread->free_nodes = (padded_CLH_node_t *)node->value.next_free;
+  return node;
+}
+
+static void pool_put_node(mutex_pool_t *pool, padded_CLH_node_t *node) {
+  mutex_pool_thread_t *thread = &pool->threads[thread_current_id()].value;
+  node->value.next_free = thread->free_nodes;
+  thread->free_nodes = node;
+}
+
+/* Cells are shared by every pooled lock and only ever count up, so a waiter
+ * spins until its cell differs from the value it saw when it queued, and a
+ * cell reused for another lock never reads as unreleased again. */
+
+/* The ring holds 4-byte entries instead of padded flags. A waiter publishes
+ * the index of its pool cell in its ring entry and spins on the cell; the
+ * releaser either finds the entry empty and marks it granted, or finds a
+ * cell and raises it. */
+
+int mutex_init_Anderson_pooled(mutex_Anderson_pooled_t *mutex,
+                               mutex_pool_t *pool) {
+  uint i;
+  uint tnum = ceiling_2(pool->thread_num);
+  atomic_uint *ring = (atomic_uint *)slab_alloc(sizeof(atomic_uint) * tnum);
+
+  if (ring == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  mutex->pool = pool;
+  mutex->ring = ring;
+  mutex->mask = tnum - 1;
+
+  atomic_init(&ring[0], MUTEX_POOL_GRANTED);
+  for (i = 1; i < tnum; ++i) {
+    atomic_init(&ring[i], MUTEX_POOL_NONE);
+  }
+  atomic_init(&mutex->next_slot, 0);
+  return SUCCESS;
+}
+
+void mutex_destroy_Anderson_pooled(mutex_Anderson_pooled_t *mutex) {
+  slab_free(mutex->ring);
+  mutex->ring = NULL;
+}
+
+void mutex_lock_Anderson_pooled(mutex_Anderson_pooled_t *mutex,
+                                mutex_Anderson_pooled_ownership_t *ownership) {
+  uint my_place = ATOMIC_ADD(&mutex->next_slot, 1) & mutex->mask;
+  uint cell = pool_get_cell(mutex->pool);
+  atomic_uint *flag = &mutex->pool->cells[cell].value;
+  uint value = ATOMIC_LOAD(flag);
+  uint expected = MUTEX_POOL_NONE;
+
+  if (atomic_compare_exchange_strong_explicit(
+          &mutex->ring[my_place], &expected, cell, memory_order_release,
+          memory_order_acquire)) {
+    while (ATOMIC_ACQUIRE(flag) == value) {
+      delay(0);
+    }
+  }
+  ATOMIC_STORE(&mutex->ring[my_place], MUTEX_POOL_NONE);
+  pool_put_cell(mutex->pool, cell);
+  ownership->my_place = my_place;
+}
+
+void mutex_unlock_Anderson_pooled(
+    mutex_Anderson_pooled_t *mutex,
+    mutex_Anderson_pooled_ownership_t *ownership) {
+  atomic_uint *next = &mutex->ring[(ownership->my_place + 1) & mutex->mask];
+  uint expected = MUTEX_POOL_NONE;
+  if (!atomic_compare_exchange_strong_explicit(next, &expected,
+                                               MUTEX_POOL_GRANTED,
+                                               memory_order_release,
+                                               memory_order_acquire)) {
+    atomic_fetch_add_explicit(&mutex->pool->cells[expected].value, 1,
+                              memory_order_release);
+  }
+}
+
+/* The tail names a pool cell and the value it had when its owner queued */
+
+int mutex_init_GT_pooled(mutex_GT_pooled_t *mutex, mutex_pool_t *pool) {
+  mutex_GT_pooled_tail_t init_value = {MUTEX_POOL_NONE, 0};
+  mutex->pool = pool;
+  atomic_init(&mutex->tail, init_value);
+  return SUCCESS;
+}
+
+void mutex_lock_GT_pooled(mutex_GT_pooled_t *mutex,
+                          mutex_GT_pooled_ownership_t *ownership) {
+  uint cell = pool_get_cell(mutex->pool);
+  mutex_GT_pooled_tail_t current = {
+      cell, ATOMIC_LOAD(&mutex->pool->cells[cell].value)};
+  mutex_GT_pooled_tail_t last = ATOMIC_EXCHANGE(&mutex->tail, current);
+  if (last.cell != MUTEX_POOL_NONE) {
+    while (ATOMIC_ACQUIRE(&mutex->pool->cells[last.cell].value) ==
+           last.value) {
+      delay(0);
+    }
+  }
+  ownership->cell = cell;
+}
+
+void mutex_unlock_GT_pooled(mutex_GT_pooled_t *mutex,
+                            mutex_GT_pooled_ownership_t *ownership) {
+  atomic_uint *flag = &mutex->pool->cells[ownership->cell].value;
+  ATOMIC_RELEASE(flag, ATOMIC_LOAD(flag) + 1);
+  pool_put_cell(mutex->pool, ownership->cell);
+}
+
+/* The lock owns one node, its tail. A releasing thread keeps its
+ * predecessor's node in exchange for its own, so nodes wander between
+ * threads and locks but their number stays fixed. */
+
+int mutex_init_CLH_pooled(mutex_CLH_pooled_t *mutex, mutex_pool_t *pool) {
+  padded_CLH_node_t *node =
+      (padded_CLH_node_t *)slab_alloc(sizeof(padded_CLH_node_t));
+  if (node == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  atomic_init(&node->value.locked, false);
+  mutex->pool = pool;
+  atomic_init(&mutex->tail, node);
+  return SUCCESS;
+}
+
+void mutex_destroy_CLH_pooled(mutex_CLH_pooled_t *mutex) {
+  slab_free(ATOMIC_LOAD(&mutex->tail));
+  atomic_init(&mutex->tail, NULL);
+}
+
+void mutex_lock_CLH_pooled(mutex_CLH_pooled_t *mutex,
+                           mutex_CLH_pooled_ownership_t *ownership) {
+  padded_CLH_node_t *node = pool_get_node(mutex->pool);
+  padded_CLH_node_t *predecessor;
+  ATOMIC_STORE(&node->value.locked, true);
+  predecessor = ATOMIC_EXCHANGE(&mutex->tail, node);
+  while (ATOMIC_ACQUIRE(&predecessor->value.locked)) {
+    delay(0);
+  }
+  ownership->node = node;
+  ownership->predecessor = predecessor;
+}
+
+void mutex_unlock_CLH_pooled(mutex_CLH_pooled_t *mutex,
+                             mutex_CLH_pooled_ownership_t *ownership) {
+  ATOMIC_RELEASE(&ownership->node->value.locked, false);
+  pool_put_node(mutex->pool, ownership->predecessor);
+}
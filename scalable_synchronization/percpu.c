@@ -0,0 +1,300 @@
+#include "synchronize.h"
+#include <linux/rseq.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define THREAD_LOCAL _Thread_local
+
+#ifndef __x86_64__
+#error "percpu.c only has x86-64 restartable sequences"
+#endif
+
+/* Each update below is a restartable sequence: a descriptor in `__rseq_cs`
+ * gives its first instruction, its length up to and including the final
+ * store, and the abort handler, which the kernel jumps to when it preempts
+ * or migrates the thread inside. The sequence publishes the descriptor in
+ * `rseq_cs`, checks that it still runs on the CPU it was given, then does
+ * its loads and the single store that commits it. An aborted update is
+ * retried on whichever CPU the thread runs on then. */
+
+/* The signature preceding every abort handler, the one glibc registers */
+#define RSEQ_SIG 0x53053053
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+#define RSEQ_CS_TABLE(start, commit, abort)                                    \
+  ".pushsection __rseq_cs, \"aw\"\n\t"                                         \
+  ".balign 32\n\t"                                                             \
+  "3:\n\t"                                                                     \
+  ".long 0, 0\n\t"                                                             \
+  ".quad " start ", " commit " - " start ", " abort "\n\t"                     \
+  ".popsection\n\t"
+
+#define RSEQ_CS_ENTER(rseq, cpu, abort_label)                                  \
+  "leaq 3b(%%rip), %%rax\n\t"                                                  \
+  "movq %%rax, 8(%[" rseq "])\n\t"                                             \
+  "1:\n\t"                                                                     \
+  "cmpl %[" cpu "], 4(%[" rseq "])\n\t"                                        \
+  "jnz %l[" abort_label "]\n\t"
+
+/* `ud1` with the signature as displacement, so that it disassembles */
+#define RSEQ_CS_ABORT(abort_label)                                             \
+  ".pushsection __rseq_failure, \"ax\"\n\t"                                    \
+  ".byte 0x0f, 0xb9, 0x3d\n\t"                                                 \
+  ".long " STR(RSEQ_SIG) "\n\t"                                                \
+  "4:\n\t"                                                                     \
+  "jmp %l[" abort_label "]\n\t"                                                \
+  ".popsection\n\t"
+
+extern const ptrdiff_t __rseq_offset __attribute__((weak));
+extern const unsigned int __rseq_size __attribute__((weak));
+
+static THREAD_LOCAL struct rseq own_rseq __attribute__((aligned(32))) = {
+    .cpu_id = RSEQ_CPU_ID_UNINITIALIZED};
+
+static struct rseq *rseq_area() {
+  if (&__rseq_size != NULL && __rseq_size > 0) {
+    return (struct rseq *)((char *)__builtin_thread_pointer() +
+                           __rseq_offset);
+  }
+  if ((int)own_rseq.cpu_id == RSEQ_CPU_ID_UNINITIALIZED &&
+      syscall(SYS_rseq, &own_rseq, sizeof(own_rseq), 0, RSEQ_SIG) != 0) {
+    own_rseq.cpu_id = RSEQ_CPU_ID_REGISTRATION_FAILED;
+  }
+  return &own_rseq;
+}
+
+static int rseq_cpu(struct rseq *rseq) {
+  return (int)*(volatile __u32 *)&rseq->cpu_id;
+}
+
+bool percpu_available() { return rseq_cpu(rseq_area()) >= 0; }
+
+uint percpu_cpu_num() { return (uint)sysconf(_SC_NPROCESSORS_CONF); }
+
+/* Adds `value` to the word at `offset` in the slot of the current CPU, the
+ * slots being `CACHE_LINE_SIZE` apart */
+static void percpu_add(void *slots, size_t offset, long value) {
+  struct rseq *rseq = rseq_area();
+  for (;;) {
+    int cpu = rseq_cpu(rseq);
+    long *word = (long *)((char *)slots + (size_t)cpu * CACHE_LINE_SIZE +
+                          offset);
+    __asm__ __volatile__ goto(RSEQ_CS_TABLE("1f", "2f", "4f")
+                              RSEQ_CS_ENTER("rseq", "cpu", "abort")
+                              "addq %[value], %[word]\n\t"
+                              "2:\n\t"
+                              RSEQ_CS_ABORT("abort")
+                              : [word] "+m"(*word)
+                              : [rseq] "r"(rseq), [cpu] "r"(cpu),
+                                [value] "er"(value)
+                              : "memory", "cc", "rax"
+                              : abort);
+    return;
+  abort:;
+  }
+}
+
+int counter_init_percpu(counter_percpu_t *counter) {
+  uint i, cpu_num = percpu_cpu_num();
+  padded_along_t *slots;
+  if (!percpu_available()) {
+    return LIB_INIT_INVALID;
+  }
+  slots = (padded_along_t *)slab_alloc(sizeof(padded_along_t) * cpu_num);
+  if (slots == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < cpu_num; ++i) {
+    atomic_init(&slots[i].value, 0);
+  }
+  counter->slots = slots;
+  counter->cpu_num = cpu_num;
+  return SUCCESS;
+}
+
+void counter_destroy_percpu(counter_percpu_t *counter) {
+  slab_free(counter->slots);
+  counter->slots = NULL;
+}
+
+void counter_add_percpu(counter_percpu_t *counter, long value) {
+  percpu_add(counter->slots, 0, value);
+}
+
+long counter_read_percpu(counter_percpu_t *counter) {
+  uint i;
+  long sum = 0;
+  for (i = 0; i < counter->cpu_num; ++i) {
+    sum += ATOMIC_ACQUIRE(&counter->slots[i].value);
+  }
+  return sum;
+}
+
+/* Reader-writer lock with the readers counted per CPU, otherwise like the
+ * flags lock. A writer sums the departures before the arrivals: a departure
+ * it sees comes after an arrival it will see, so the sums only match once
+ * every reader that arrived before the writer has left. */
+
+/* `mutex` must be initialized already and outlive the reader-writer lock */
+int rwlock_init_percpu(rwlock_percpu_t *rwlock, void *mutex,
+                       const rwlock_mutex_t *operations) {
+  uint i, cpu_num = percpu_cpu_num();
+  padded_percpu_readers_t *readers;
+  if (mutex == NULL || operations == NULL || !percpu_available()) {
+    return LIB_INIT_INVALID;
+  }
+  readers = (padded_percpu_readers_t *)slab_alloc(
+      sizeof(padded_percpu_readers_t) * cpu_num);
+  if (readers == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < cpu_num; ++i) {
+    atomic_init(&readers[i].value.ingress, 0);
+    atomic_init(&readers[i].value.egress, 0);
+  }
+  rwlock->readers = readers;
+  rwlock->cpu_num = cpu_num;
+  atomic_init(&rwlock->writer, false);
+  rwlock->mutex = mutex;
+  rwlock->operations = operations;
+  return SUCCESS;
+}
+
+void rwlock_destroy_percpu(rwlock_percpu_t *rwlock) {
+  slab_free(rwlock->readers);
+  rwlock->readers = NULL;
+}
+
+#define INGRESS offsetof(rwlock_percpu_readers_t, ingress)
+#define EGRESS offsetof(rwlock_percpu_readers_t, egress)
+
+void rwlock_read_lock_percpu(rwlock_percpu_t *rwlock) {
+  for (;;) {
+    percpu_add(rwlock->readers, INGRESS, 1);
+    ATOMIC_FENCE();
+    if (!ATOMIC_ACQUIRE(&rwlock->writer)) {
+      return;
+    }
+    atomic_thread_fence(memory_order_release);
+    percpu_add(rwlock->readers, EGRESS, 1);
+    while (ATOMIC_LOAD(&rwlock->writer)) {
+      delay(0);
+    }
+  }
+}
+
+void rwlock_read_unlock_percpu(rwlock_percpu_t *rwlock) {
+  atomic_thread_fence(memory_order_release);
+  percpu_add(rwlock->readers, EGRESS, 1);
+}
+
+static bool readers_present(rwlock_percpu_t *rwlock) {
+  uint i;
+  unsigned long egress = 0, ingress = 0;
+  for (i = 0; i < rwlock->cpu_num; ++i) {
+    egress += ATOMIC_ACQUIRE(&rwlock->readers[i].value.egress);
+  }
+  for (i = 0; i < rwlock->cpu_num; ++i) {
+    ingress += ATOMIC_ACQUIRE(&rwlock->readers[i].value.ingress);
+  }
+  return ingress != egress;
+}
+
+void rwlock_write_lock_percpu(rwlock_percpu_t *rwlock, void *ownership) {
+  rwlock->operations->lock(rwlock->mutex, ownership);
+  ATOMIC_STORE(&rwlock->writer, true);
+  ATOMIC_FENCE();
+  while (readers_present(rwlock)) {
+    delay(0);
+  }
+}
+
+void rwlock_write_unlock_percpu(rwlock_percpu_t *rwlock, void *ownership) {
+  ATOMIC_RELEASE(&rwlock->writer, false);
+  rwlock->operations->unlock(rwlock->mutex, ownership);
+}
+
+/* Free lists. Only threads on a CPU touch its list, always inside a
+ * sequence, so a pop cannot meet the ABA problem of a lock-free stack: a
+ * thread preempted between reading the head and storing its successor
+ * starts over. */
+
+int list_init_percpu(list_percpu_t *list) {
+  uint i, cpu_num = percpu_cpu_num();
+  padded_aptr_t *heads;
+  if (!percpu_available()) {
+    return LIB_INIT_INVALID;
+  }
+  heads = (padded_aptr_t *)slab_alloc(sizeof(padded_aptr_t) * cpu_num);
+  if (heads == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < cpu_num; ++i) {
+    atomic_init(&heads[i].value, NULL);
+  }
+  list->heads = heads;
+  list->cpu_num = cpu_num;
+  return SUCCESS;
+}
+
+void list_destroy_percpu(list_percpu_t *list, reclaim_function_t reclaim) {
+  uint i;
+  for (i = 0; i < list->cpu_num && reclaim != NULL; ++i) {
+    void *node = ATOMIC_LOAD(&list->heads[i].value);
+    while (node != NULL) {
+      void *next = *(void **)node;
+      reclaim(node);
+      node = next;
+    }
+  }
+  slab_free(list->heads);
+  list->heads = NULL;
+}
+
+void list_push_percpu(list_percpu_t *list, void *node) {
+  struct rseq *rseq = rseq_area();
+  for (;;) {
+    int cpu = rseq_cpu(rseq);
+    void **head = (void **)&list->heads[cpu].value;
+    __asm__ __volatile__ goto(RSEQ_CS_TABLE("1f", "2f", "4f")
+                              RSEQ_CS_ENTER("rseq", "cpu", "abort")
+                              "movq %[head], %%rbx\n\t"
+                              "movq %%rbx, %[next]\n\t"
+                              "movq %[node], %[head]\n\t"
+                              "2:\n\t"
+                              RSEQ_CS_ABORT("abort")
+                              : [head] "+m"(*head), [next] "=m"(*(void **)node)
+                              : [rseq] "r"(rseq), [cpu] "r"(cpu),
+                                [node] "r"(node)
+                              : "memory", "cc", "rax", "rbx"
+                              : abort);
+    return;
+  abort:;
+  }
+}
+
+void *list_pop_percpu(list_percpu_t *list) {
+  struct rseq *rseq = rseq_area();
+  for (;;) {
+    int cpu = rseq_cpu(rseq);
+    void **head = (void **)&list->heads[cpu].value;
+    void *node;
+    __asm__ __volatile__ goto(RSEQ_CS_TABLE("1f", "2f", "4f")
+                              RSEQ_CS_ENTER("rseq", "cpu", "abort")
+                              "movq %[head], %%rbx\n\t"
+                              "movq %%rbx, %[node]\n\t"
+                              "testq %%rbx, %%rbx\n\t"
+                              "jz 2f\n\t"
+                              "movq (%%rbx), %%rbx\n\t"
+                              "movq %%rbx, %[head]\n\t"
+                              "2:\n\t"
+                              RSEQ_CS_ABORT("abort")
+                              : [head] "+m"(*head), [node] "=&r"(node)
+                              : [rseq] "r"(rseq), [cpu] "r"(cpu)
+                              : "memory", "cc", "rax", "rbx"
+                              : abort);
+    return node;
+  abort:;
+  }
+}
@@ -0,0 +1,290 @@
+#include "synchronize.h"
+#include <sched.h>
+
+#define POOL_DEQUE_MASK (POOL_DEQUE_SIZE - 1)
+
+/* Chase-Lev deque with the C11 orderings of Le et al. (PPoPP 2013) */
+
+static bool deque_push(pool_worker_t *worker, pool_task_t *task) {
+  pool_deque_owner_t *owner = &worker->owner.value;
+  long b = ATOMIC_LOAD(&owner->bottom);
+  long t = ATOMIC_ACQUIRE(&worker->top.value);
+  if (b - t > POOL_DEQUE_MASK) {
+    return false;
+  }
+  ATOMIC_STORE(&owner->buffer[b & POOL_DEQUE_MASK], task);
+  atomic_thread_fence(memory_order_release);
+  ATOMIC_STORE(&owner->bottom, b + 1);
+  return true;
+}
+
+static pool_task_t *deque_take(pool_worker_t *worker) {
+  pool_deque_owner_t *owner = &worker->owner.value;
+  pool_task_t *task = NULL;
+  long b = ATOMIC_LOAD(&owner->bottom) - 1;
+  long t;
+  ATOMIC_STORE(&owner->bottom, b);
+  ATOMIC_FENCE();
+  t = ATOMIC_LOAD(&worker->top.value);
+  if (t <= b) {
+    task = ATOMIC_LOAD(&owner->buffer[b & POOL_DEQUE_MASK]);
+    if (t == b) {
+      if (!atomic_compare_exchange_strong(&worker->top.value, &t, t + 1)) {
+        task = NULL;
+      }
+      ATOMIC_STORE(&owner->bottom, b + 1);
+    }
+  } else {
+    ATOMIC_STORE(&owner->bottom, b + 1);
+  }
+  return task;
+}
+
+static pool_task_t *deque_steal(pool_worker_t *worker) {
+  pool_deque_owner_t *owner = &worker->owner.value;
+  long t = ATOMIC_ACQUIRE(&worker->top.value);
+  long b;
+  ATOMIC_FENCE();
+  b = ATOMIC_ACQUIRE(&owner->bottom);
+  if (t < b) {
+    pool_task_t *task = ATOMIC_LOAD(&owner->buffer[t & POOL_DEQUE_MASK]);
+    if (atomic_compare_exchange_strong(&worker->top.value, &t, t + 1)) {
+      return task;
+    }
+  }
+  return NULL;
+}
+
+static void pool_execute(pool_task_t *task) {
+  task->function(task->arg);
+  ATOMIC_RELEASE(&task->done, true);
+}
+
+/* Runs one task from the own deque or, failing that, from a random victim */
+static bool pool_work_once(pool_t *pool) {
+  uint my_id = thread_current_id();
+  pool_worker_t *self = &pool->workers[my_id];
+  pool_task_t *task = deque_take(self);
+  if (task == NULL && pool->thread_num > 1) {
+    uint *seed = &self->owner.value.seed;
+    uint victim;
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    victim = *seed % (pool->thread_num - 1);
+    task = deque_steal(&pool->workers[victim + (victim >= my_id)]);
+  }
+  if (task == NULL) {
+    return false;
+  }
+  pool_execute(task);
+  return true;
+}
+
+static void pool_region(pool_t *pool) {
+  pool->region_function(pool->region_arg);
+  pool->join(pool->barrier);
+}
+
+static void *pool_worker_main(void *args) {
+  pool_t *pool = (pool_t *)args;
+  uint epoch = 0, idle = 0;
+  thread_set_id(ATOMIC_ADD(&pool->started, 1) + 1);
+  while (!ATOMIC_ACQUIRE(&pool->stop)) {
+    uint current = ATOMIC_ACQUIRE(&pool->region_epoch);
+    if (current != epoch) {
+      epoch = current;
+      pool_region(pool);
+      idle = 0;
+    } else if (pool_work_once(pool)) {
+      idle = 0;
+    } else if (++idle == POOL_IDLE_SPINS) {
+      sched_yield();
+      idle = 0;
+    }
+  }
+  return NULL;
+}
+
+/* The calling thread becomes worker 0 and its thread id is reset to 0. */
+int pool_init(pool_t *pool, uint t_num) {
+  uint i;
+  atomic_task_ptr_t *buffers;
+  pool_worker_t *workers =
+      (pool_worker_t *)slab_alloc(sizeof(pool_worker_t) * t_num);
+  if (workers == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  buffers = (atomic_task_ptr_t *)slab_alloc(sizeof(atomic_task_ptr_t) *
+                                            POOL_DEQUE_SIZE * t_num);
+  if (buffers == NULL) {
+    slab_free(workers);
+    return OUT_OF_MEMORY;
+  }
+  pool->threads = (pthread_t *)slab_alloc(sizeof(pthread_t) * t_num);
+  if (pool->threads == NULL ||
+      barrier_init_centralized(&pool->default_barrier, t_num) != SUCCESS) {
+    slab_free(pool->threads);
+    slab_free(buffers);
+    slab_free(workers);
+    return OUT_OF_MEMORY;
+  }
+
+  for (i = 0; i < t_num; ++i) {
+    pool_deque_owner_t *owner = &workers[i].owner.value;
+    atomic_init(&workers[i].top.value, 0);
+    atomic_init(&owner->bottom, 0);
+    owner->buffer = buffers + POOL_DEQUE_SIZE * i;
+    owner->seed = 2463534242u + i;
+  }
+  pool->workers = workers;
+  pool->thread_num = t_num;
+  atomic_init(&pool->started, 0);
+  atomic_init(&pool->region_epoch, 0);
+  atomic_init(&pool->stop, false);
+  thread_set_id(0);
+
+  for (i = 1; i < t_num; ++i) {
+    if (pthread_create(&pool->threads[i], NULL, pool_worker_main, pool) != 0) {
+      break;
+    }
+  }
+  if (i < t_num) {
+    pool->thread_num = i;
+    pool_destroy(pool);
+    return LIB_INIT_INVALID;
+  }
+  return SUCCESS;
+}
+
+void pool_destroy(pool_t *pool) {
+  uint i;
+  ATOMIC_RELEASE(&pool->stop, true);
+  for (i = 1; i < pool->thread_num; ++i) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  barrier_destroy_centralized(&pool->default_barrier);
+  slab_free(pool->workers[0].owner.value.buffer);
+  slab_free(pool->workers);
+  slab_free(pool->threads);
+  pool->workers = NULL;
+  pool->threads = NULL;
+}
+
+/* Runs `function` once on every worker, then joins them at `barrier`. The
+ * join must be a barrier for exactly `thread_num` threads; NULL selects a
+ * centralized barrier owned by the pool. */
+void pool_run(pool_t *pool, pool_function_t function, void *arg,
+              pool_join_t join, void *barrier) {
+  pool->region_function = function;
+  pool->region_arg = arg;
+  if (join == NULL) {
+    pool->join = pool_join_centralized;
+    pool->barrier = &pool->default_barrier;
+  } else {
+    pool->join = join;
+    pool->barrier = barrier;
+  }
+  ATOMIC_RELEASE(&pool->region_epoch, ATOMIC_LOAD(&pool->region_epoch) + 1);
+  pool_region(pool);
+}
+
+/* `task` must stay alive until `pool_sync` on it returns. */
+void pool_spawn(pool_t *pool, pool_task_t *task, pool_function_t function,
+                void *arg) {
+  task->function = function;
+  task->arg = arg;
+  atomic_init(&task->done, false);
+  if (!deque_push(&pool->workers[thread_current_id()], task)) {
+    pool_execute(task);
+  }
+}
+
+/* Waits for `task`, running other tasks meanwhile. */
+void pool_sync(pool_t *pool, pool_task_t *task) {
+  while (!ATOMIC_ACQUIRE(&task->done)) {
+    if (!pool_work_once(pool)) {
+      delay(0);
+    }
+  }
+}
+
+/* Parallel for: every worker starts on its static block and splits it
+ * lazily by fork-join, so idle workers balance the load by stealing. A
+ * worker leaves for the join only once no iteration is left anywhere. */
+
+typedef struct {
+  pool_t *pool;
+  long begin, end, grain;
+  pool_body_t body;
+  void *arg;
+  atomic_long remaining;
+} pool_for_t;
+
+typedef struct {
+  pool_for_t *loop;
+  long begin, end;
+} pool_for_range_t;
+
+static void pool_for_range(pool_for_t *loop, long begin, long end);
+
+static void pool_for_task(void *arg) {
+  pool_for_range_t *range = (pool_for_range_t *)arg;
+  pool_for_range(range->loop, range->begin, range->end);
+}
+
+static void pool_for_range(pool_for_t *loop, long begin, long end) {
+  if (end - begin > loop->grain) {
+    long middle = begin + (end - begin) / 2;
+    pool_for_range_t right = {loop, middle, end};
+    pool_task_t task;
+    pool_spawn(loop->pool, &task, pool_for_task, &right);
+    pool_for_range(loop, begin, middle);
+    pool_sync(loop->pool, &task);
+  } else {
+    loop->body(begin, end, loop->arg);
+    ATOMIC_SUB(&loop->remaining, end - begin);
+  }
+}
+
+static void pool_for_region(void *arg) {
+  pool_for_t *loop = (pool_for_t *)arg;
+  long n = loop->end - loop->begin;
+  long t_num = loop->pool->thread_num, my_id = thread_current_id();
+  long begin = loop->begin + n * my_id / t_num;
+  long end = loop->begin + n * (my_id + 1) / t_num;
+  if (begin < end) {
+    pool_for_range(loop, begin, end);
+  }
+  while (ATOMIC_ACQUIRE(&loop->remaining) > 0) {
+    if (!pool_work_once(loop->pool)) {
+      delay(0);
+    }
+  }
+}
+
+void pool_parallel_for(pool_t *pool, long begin, long end, long grain,
+                       pool_body_t body, void *arg, pool_join_t join,
+                       void *barrier) {
+  pool_for_t loop;
+  loop.pool = pool;
+  loop.begin = begin;
+  loop.end = end;
+  loop.grain = (grain > 0) ? grain : 1;
+  loop.body = body;
+  loop.arg = arg;
+  atomic_init(&loop.remaining, (end > begin) ? end - begin : 0);
+  pool_run(pool, pool_for_region, &loop, join, barrier);
+}
+
+#define CREATE_POOL_JOIN(type)                                                 \
+  void pool_join_##type(void *barrier) {                                       \
+    barrier_wait_##type((barrier_##type##_t *)barrier);                        \
+  }
+
+CREATE_POOL_JOIN(centralized)
+CREATE_POOL_JOIN(combining_tree)
+CREATE_POOL_JOIN(dissemination)
+CREATE_POOL_JOIN(tournament)
+CREATE_POOL_JOIN(dual_tree)
+CREATE_POOL_JOIN(arrival_tree)
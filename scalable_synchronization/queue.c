@@ -0,0 +1,314 @@
+#include "synchronize.h"
+
+static uint ceiling_pow2(uint n) {
+  uint i = 1;
+  while (i < n) {
+    i = i << 1;
+  }
+  return i;
+}
+
+/* Bounded MPMC ring buffer (Vyukov). A cell is free for position `pos` when
+ * its sequence equals `pos`, and holds the element of `pos` when its sequence
+ * equals `pos + 1`. */
+
+int queue_init_ring(queue_ring_t *queue, uint capacity) {
+  uint i, size = ceiling_pow2(capacity);
+  queue_ring_cell_t *cells =
+      (queue_ring_cell_t *)slab_alloc(sizeof(queue_ring_cell_t) * size);
+  if (cells == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < size; ++i) {
+    atomic_init(&cells[i].sequence, i);
+    cells[i].data = NULL;
+  }
+  queue->cells = cells;
+  queue->mask = size - 1;
+  atomic_init(&queue->enqueue_pos.value, 0);
+  atomic_init(&queue->dequeue_pos.value, 0);
+  return SUCCESS;
+}
+
+void queue_destroy_ring(queue_ring_t *queue) {
+  slab_free(queue->cells);
+  queue->cells = NULL;
+}
+
+bool queue_enqueue_ring(queue_ring_t *queue, void *data) {
+  queue_ring_cell_t *cell;
+  uint pos = ATOMIC_LOAD(&queue->enqueue_pos.value);
+  for (;;) {
+    int diff;
+    cell = &queue->cells[pos & queue->mask];
+    diff = (int)(ATOMIC_ACQUIRE(&cell->sequence) - pos);
+    if (diff == 0) {
+      if (ATOMIC_COMPARE_EXCHANGE(&queue->enqueue_pos.value, &pos, pos + 1)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = ATOMIC_LOAD(&queue->enqueue_pos.value);
+    }
+  }
+  cell->data = data;
+  ATOMIC_RELEASE(&cell->sequence, pos + 1);
+  return true;
+}
+
+bool queue_dequeue_ring(queue_ring_t *queue, void **data) {
+  queue_ring_cell_t *cell;
+  uint pos = ATOMIC_LOAD(&queue->dequeue_pos.value);
+  for (;;) {
+    int diff;
+    cell = &queue->cells[pos & queue->mask];
+    diff = (int)(ATOMIC_ACQUIRE(&cell->sequence) - (pos + 1));
+    if (diff == 0) {
+      if (ATOMIC_COMPARE_EXCHANGE(&queue->dequeue_pos.value, &pos, pos + 1)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = ATOMIC_LOAD(&queue->dequeue_pos.value);
+    }
+  }
+  *data = cell->data;
+  ATOMIC_RELEASE(&cell->sequence, pos + queue->mask + 1);
+  return true;
+}
+
+/* Batches claim a run of consecutive ready cells with a single CAS. A cell
+ * seen ready for `pos + i` stays ready until some thread claims `pos + i`,
+ * which the successful CAS rules out. */
+
+uint queue_enqueue_batch_ring(queue_ring_t *queue, void *const *data,
+                              uint n) {
+  uint i, count;
+  uint pos = ATOMIC_LOAD(&queue->enqueue_pos.value);
+  for (;;) {
+    for (count = 0; count < n && count <= queue->mask; ++count) {
+      queue_ring_cell_t *cell = &queue->cells[(pos + count) & queue->mask];
+      if (ATOMIC_ACQUIRE(&cell->sequence) != pos + count) {
+        break;
+      }
+    }
+    if (count > 0) {
+      if (ATOMIC_COMPARE_EXCHANGE(&queue->enqueue_pos.value, &pos,
+                                  pos + count)) {
+        break;
+      }
+    } else {
+      uint current = ATOMIC_LOAD(&queue->enqueue_pos.value);
+      if (current == pos) {
+        return 0;
+      }
+      pos = current;
+    }
+  }
+
+  for (i = 0; i < count; ++i) {
+    queue_ring_cell_t *cell = &queue->cells[(pos + i) & queue->mask];
+    cell->data = data[i];
+    ATOMIC_RELEASE(&cell->sequence, pos + i + 1);
+  }
+  return count;
+}
+
+uint queue_dequeue_batch_ring(queue_ring_t *queue, void **data, uint n) {
+  uint i, count;
+  uint pos = ATOMIC_LOAD(&queue->dequeue_pos.value);
+  for (;;) {
+    for (count = 0; count < n && count <= queue->mask; ++count) {
+      queue_ring_cell_t *cell = &queue->cells[(pos + count) & queue->mask];
+      if (ATOMIC_ACQUIRE(&cell->sequence) != pos + count + 1) {
+        break;
+      }
+    }
+    if (count > 0) {
+      if (ATOMIC_COMPARE_EXCHANGE(&queue->dequeue_pos.value, &pos,
+                                  pos + count)) {
+        break;
+      }
+    } else {
+      uint current = ATOMIC_LOAD(&queue->dequeue_pos.value);
+      if (current == pos) {
+        return 0;
+      }
+      pos = current;
+    }
+  }
+
+  for (i = 0; i < count; ++i) {
+    queue_ring_cell_t *cell = &queue->cells[(pos + i) & queue->mask];
+    data[i] = cell->data;
+    ATOMIC_RELEASE(&cell->sequence, pos + i + queue->mask + 1);
+  }
+  return count;
+}
+
+/* Unbounded MPMC queue (Michael and Scott), with dequeued nodes reclaimed
+ * through hazard pointers. Hazard 0 protects the head or the tail, hazards 1
+ * and 2 protect the nodes visited by a batch dequeue. */
+
+/* Publishes `*source` as hazard `i` and returns it once it is known to have
+ * still been reachable after the publication. */
+static queue_MS_node_t *queue_MS_protect(queue_MS_t *queue, uint i,
+                                         atomic_MS_node_ptr_t *source) {
+  queue_MS_node_t *node = ATOMIC_LOAD(source);
+  for (;;) {
+    queue_MS_node_t *again;
+    reclaim_protect_hazard(&queue->hazards, i, node);
+    again = ATOMIC_ACQUIRE(source);
+    if (again == node) {
+      return node;
+    }
+    node = again;
+  }
+}
+
+int queue_init_MS(queue_MS_t *queue, uint t_num) {
+  queue_MS_node_t *dummy =
+      (queue_MS_node_t *)slab_alloc(sizeof(queue_MS_node_t));
+  if (dummy == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  if (reclaim_init_hazard(&queue->hazards, t_num, slab_free) != SUCCESS) {
+    slab_free(dummy);
+    return OUT_OF_MEMORY;
+  }
+  atomic_init(&dummy->next, NULL);
+  dummy->data = NULL;
+  atomic_init(&queue->head.value, dummy);
+  atomic_init(&queue->tail.value, dummy);
+  return SUCCESS;
+}
+
+void queue_destroy_MS(queue_MS_t *queue) {
+  queue_MS_node_t *node = ATOMIC_LOAD(&queue->head.value);
+  while (node != NULL) {
+    queue_MS_node_t *next = ATOMIC_LOAD(&node->next);
+    slab_free(node);
+    node = next;
+  }
+  reclaim_destroy_hazard(&queue->hazards);
+}
+
+/* Links the private chain `first .. last` after the current tail. */
+static void queue_MS_append(queue_MS_t *queue, queue_MS_node_t *first,
+                            queue_MS_node_t *last) {
+  queue_MS_node_t *tail;
+  for (;;) {
+    queue_MS_node_t *next, *expected = NULL;
+    tail = queue_MS_protect(queue, 0, &queue->tail.value);
+    next = ATOMIC_ACQUIRE(&tail->next);
+    if (next != NULL) {
+      ATOMIC_COMPARE_EXCHANGE_RELEASE(&queue->tail.value, &tail, next);
+      continue;
+    }
+    if (ATOMIC_COMPARE_EXCHANGE_RELEASE(&tail->next, &expected, first)) {
+      break;
+    }
+  }
+  ATOMIC_COMPARE_EXCHANGE_RELEASE(&queue->tail.value, &tail, last);
+  reclaim_release_hazard(&queue->hazards);
+}
+
+bool queue_enqueue_MS(queue_MS_t *queue, void *data) {
+  queue_MS_node_t *node =
+      (queue_MS_node_t *)slab_alloc(sizeof(queue_MS_node_t));
+  if (node == NULL) {
+    return false;
+  }
+  node->data = data;
+  atomic_init(&node->next, NULL);
+  queue_MS_append(queue, node, node);
+  return true;
+}
+
+uint queue_enqueue_batch_MS(queue_MS_t *queue, void *const *data, uint n) {
+  uint i;
+  queue_MS_node_t *first = NULL, *last = NULL;
+  for (i = 0; i < n; ++i) {
+    queue_MS_node_t *node =
+        (queue_MS_node_t *)slab_alloc(sizeof(queue_MS_node_t));
+    if (node == NULL) {
+      break;
+    }
+    node->data = data[i];
+    atomic_init(&node->next, NULL);
+    if (last == NULL) {
+      first = node;
+    } else {
+      atomic_init(&last->next, node);
+    }
+    last = node;
+  }
+  if (i > 0) {
+    queue_MS_append(queue, first, last);
+  }
+  return i;
+}
+
+/* Detaches up to `n` elements with one CAS on the head. Nodes between a
+ * validated head and the tail are not retired yet, so re-validating the head
+ * after publishing a hazard on each visited node keeps the walk safe. The
+ * walk never passes the tail, so the head cannot overtake it. */
+uint queue_dequeue_batch_MS(queue_MS_t *queue, void **data, uint n) {
+  queue_MS_node_t *head, *node;
+  uint count;
+
+  if (n == 0) {
+    return 0;
+  }
+  for (;;) {
+    queue_MS_node_t *tail;
+    head = queue_MS_protect(queue, 0, &queue->head.value);
+    tail = ATOMIC_LOAD(&queue->tail.value);
+    node = head;
+    count = 0;
+    while (count < n) {
+      queue_MS_node_t *next = ATOMIC_ACQUIRE(&node->next);
+      if (next == NULL) {
+        break;
+      }
+      if (node == tail) {
+        if (count == 0) {
+          ATOMIC_COMPARE_EXCHANGE_RELEASE(&queue->tail.value, &tail, next);
+          tail = ATOMIC_LOAD(&queue->tail.value);
+          continue;
+        }
+        break;
+      }
+      reclaim_protect_hazard(&queue->hazards, 1 + count % 2, next);
+      if (ATOMIC_ACQUIRE(&queue->head.value) != head) {
+        break;
+      }
+      data[count++] = next->data;
+      node = next;
+    }
+    if (count == 0) {
+      if (ATOMIC_ACQUIRE(&queue->head.value) == head) {
+        reclaim_release_hazard(&queue->hazards);
+        return 0;
+      }
+      continue;
+    }
+    if (ATOMIC_COMPARE_EXCHANGE(&queue->head.value, &head, node)) {
+      break;
+    }
+  }
+  reclaim_release_hazard(&queue->hazards);
+
+  while (head != node) {
+    queue_MS_node_t *next = ATOMIC_LOAD(&head->next);
+    reclaim_retire_hazard(&queue->hazards, head);
+    head = next;
+  }
+  return count;
+}
+
+bool queue_dequeue_MS(queue_MS_t *queue, void **data) {
+  return queue_dequeue_batch_MS(queue, data, 1) == 1;
+}
@@ -0,0 +1,264 @@
+#include "synchronize.h"
+#include <stdlib.h>
+
+/* Hazard pointers (Michael, 2004). Every thread owns `RECLAIM_HAZARDS`
+ * hazard slots and a retired list of twice the total number of hazards. A
+ * thread scans all hazards only when its list is full, so each scan frees at
+ * least half of the list and costs O(1) amortized per retired node. */
+
+static uint hazard_total(reclaim_hazard_t *domain) {
+  return domain->thread_num * RECLAIM_HAZARDS;
+}
+
+static int compare_pointer(const void *a, const void *b) {
+  const char *x = *(const char *const *)a;
+  const char *y = *(const char *const *)b;
+  return (x > y) - (x < y);
+}
+
+int reclaim_init_hazard(reclaim_hazard_t *domain, uint t_num,
+                        reclaim_function_t reclaim) {
+  uint i, j, h_num = t_num * RECLAIM_HAZARDS;
+  void **lists;
+  padded_hazard_thread_t *threads = (padded_hazard_thread_t *)slab_alloc(
+      sizeof(padded_hazard_thread_t) * t_num);
+  if (threads == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  lists = (void **)slab_alloc(sizeof(void *) * 3 * h_num * t_num);
+  if (lists == NULL) {
+    slab_free(threads);
+    return OUT_OF_MEMORY;
+  }
+
+  for (i = 0; i < t_num; ++i) {
+    reclaim_hazard_thread_t *thread = &threads[i].value;
+    for (j = 0; j < RECLAIM_HAZARDS; ++j) {
+      atomic_init(&thread->hazards[j], NULL);
+    }
+    thread->retired = lists + 3 * h_num * i;
+    thread->protected = thread->retired + 2 * h_num;
+    thread->retired_num = 0;
+  }
+
+  domain->threads = threads;
+  domain->thread_num = t_num;
+  domain->reclaim = (reclaim == NULL) ? free : reclaim;
+  return SUCCESS;
+}
+
+void reclaim_destroy_hazard(reclaim_hazard_t *domain) {
+  uint i, j;
+  for (i = 0; i < domain->thread_num; ++i) {
+    reclaim_hazard_thread_t *thread = &domain->threads[i].value;
+    for (j = 0; j < thread->retired_num; ++j) {
+      domain->reclaim(thread->retired[j]);
+    }
+  }
+  slab_free(domain->threads[0].value.retired);
+  slab_free(domain->threads);
+  domain->threads = NULL;
+}
+
+/* The caller must check that `node` is still reachable after this returns
+ * before dereferencing it. */
+void reclaim_protect_hazard(reclaim_hazard_t *domain, uint i, void *node) {
+  ATOMIC_STORE(&domain->threads[thread_current_id()].value.hazards[i], node);
+  ATOMIC_FENCE();
+}
+
+void reclaim_release_hazard(reclaim_hazard_t *domain) {
+  uint i;
+  reclaim_hazard_thread_t *self = &domain->threads[thread_current_id()].value;
+  for (i = 0; i < RECLAIM_HAZARDS; ++i) {
+    ATOMIC_RELEASE(&self->hazards[i], NULL);
+  }
+}
+
+static void hazard_scan(reclaim_hazard_t *domain,
+                        reclaim_hazard_thread_t *self) {
+  uint i, j, protected_num = 0, kept = 0;
+  ATOMIC_FENCE();
+  for (i = 0; i < domain->thread_num; ++i) {
+    reclaim_hazard_thread_t *other = &domain->threads[i].value;
+    for (j = 0; j < RECLAIM_HAZARDS; ++j) {
+      void *node = ATOMIC_ACQUIRE(&other->hazards[j]);
+      if (node != NULL) {
+        self->protected[protected_num++] = node;
+      }
+    }
+  }
+  qsort(self->protected, protected_num, sizeof(void *), compare_pointer);
+  for (i = 0; i < self->retired_num; ++i) {
+    void *node = self->retired[i];
+    if (bsearch(&node, self->protected, protected_num, sizeof(void *),
+                compare_pointer) != NULL) {
+      self->retired[kept++] = node;
+    } else {
+      domain->reclaim(node);
+    }
+  }
+  self->retired_num = kept;
+}
+
+void reclaim_retire_hazard(reclaim_hazard_t *domain, void *node) {
+  reclaim_hazard_thread_t *self = &domain->threads[thread_current_id()].value;
+  self->retired[self->retired_num++] = node;
+  if (self->retired_num == 2 * hazard_total(domain)) {
+    hazard_scan(domain, self);
+  }
+}
+
+void reclaim_flush_hazard(reclaim_hazard_t *domain) {
+  hazard_scan(domain, &domain->threads[thread_current_id()].value);
+}
+
+/* Epoch-based reclamation (Fraser, 2004). The global epoch is even and
+ * advances by two; a thread inside a critical section publishes `epoch | 1`.
+ * The global epoch advances only when every active thread has observed it,
+ * so a node retired in epoch `e` is unreachable by anyone once the global
+ * epoch reaches `e + 4`. Retired nodes go to one of `RECLAIM_EPOCHS`
+ * growable limbo lists per thread, and a thread tries to advance the epoch
+ * once every `RECLAIM_EPOCH_BATCH` retirements. */
+
+int reclaim_init_epoch(reclaim_epoch_t *domain, uint t_num,
+                       reclaim_function_t reclaim) {
+  uint i, j;
+  reclaim_limbo_t *limbo;
+  padded_epoch_thread_t *threads = (padded_epoch_thread_t *)slab_alloc(
+      sizeof(padded_epoch_thread_t) * t_num);
+  if (threads == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  limbo = (reclaim_limbo_t *)slab_alloc(sizeof(reclaim_limbo_t) *
+                                        RECLAIM_EPOCHS * t_num);
+  if (limbo == NULL) {
+    slab_free(threads);
+    return OUT_OF_MEMORY;
+  }
+
+  for (i = 0; i < t_num; ++i) {
+    reclaim_epoch_thread_t *thread = &threads[i].value;
+    atomic_init(&thread->local_epoch, 0);
+    thread->retire_count = 0;
+    thread->limbo = limbo + RECLAIM_EPOCHS * i;
+    for (j = 0; j < RECLAIM_EPOCHS; ++j) {
+      thread->limbo[j].nodes = NULL;
+      thread->limbo[j].num = 0;
+      thread->limbo[j].size = 0;
+      thread->limbo[j].epoch = 0;
+    }
+  }
+
+  atomic_init(&domain->global_epoch.value, 0);
+  domain->threads = threads;
+  domain->thread_num = t_num;
+  domain->reclaim = (reclaim == NULL) ? free : reclaim;
+  return SUCCESS;
+}
+
+static void limbo_free(reclaim_epoch_t *domain, reclaim_limbo_t *limbo) {
+  uint i;
+  for (i = 0; i < limbo->num; ++i) {
+    domain->reclaim(limbo->nodes[i]);
+  }
+  limbo->num = 0;
+}
+
+void reclaim_destroy_epoch(reclaim_epoch_t *domain) {
+  uint i, j;
+  for (i = 0; i < domain->thread_num; ++i) {
+    reclaim_epoch_thread_t *thread = &domain->threads[i].value;
+    for (j = 0; j < RECLAIM_EPOCHS; ++j) {
+      limbo_free(domain, &thread->limbo[j]);
+      free(thread->limbo[j].nodes);
+    }
+  }
+  slab_free(domain->threads[0].value.limbo);
+  slab_free(domain->threads);
+  domain->threads = NULL;
+}
+
+/* Re-reading the global epoch after the fence keeps a thread that was
+ * delayed between the load and the publication from entering two epochs
+ * behind. */
+void reclaim_enter_epoch(reclaim_epoch_t *domain) {
+  atomic_uint *local = &domain->threads[thread_current_id()].value.local_epoch;
+  uint epoch = ATOMIC_LOAD(&domain->global_epoch.value);
+  for (;;) {
+    uint again;
+    ATOMIC_STORE(local, epoch | 1);
+    ATOMIC_FENCE();
+    again = ATOMIC_ACQUIRE(&domain->global_epoch.value);
+    if (again == epoch) {
+      break;
+    }
+    epoch = again;
+  }
+}
+
+void reclaim_exit_epoch(reclaim_epoch_t *domain) {
+  ATOMIC_RELEASE(&domain->threads[thread_current_id()].value.local_epoch, 0);
+}
+
+static uint epoch_try_advance(reclaim_epoch_t *domain) {
+  uint i, epoch;
+  ATOMIC_FENCE();
+  epoch = ATOMIC_ACQUIRE(&domain->global_epoch.value);
+  for (i = 0; i < domain->thread_num; ++i) {
+    uint local = ATOMIC_ACQUIRE(&domain->threads[i].value.local_epoch);
+    if ((local & 1) && (local & ~1u) != epoch) {
+      return epoch;
+    }
+  }
+  if (ATOMIC_COMPARE_EXCHANGE_RELEASE(&domain->global_epoch.value, &epoch,
+                                      epoch + 2)) {
+    return epoch + 2;
+  }
+  return epoch;
+}
+
+static void epoch_collect(reclaim_epoch_t *domain,
+                          reclaim_epoch_thread_t *self, uint epoch) {
+  uint i;
+  for (i = 0; i < RECLAIM_EPOCHS; ++i) {
+    reclaim_limbo_t *limbo = &self->limbo[i];
+    if (limbo->num > 0 && epoch - limbo->epoch >= 4) {
+      limbo_free(domain, limbo);
+    }
+  }
+}
+
+/* Must be called inside a critical section. */
+int reclaim_retire_epoch(reclaim_epoch_t *domain, void *node) {
+  reclaim_epoch_thread_t *self = &domain->threads[thread_current_id()].value;
+  uint epoch = ATOMIC_LOAD(&self->local_epoch) & ~1u;
+  reclaim_limbo_t *limbo = &self->limbo[(epoch >> 1) % RECLAIM_EPOCHS];
+
+  if (limbo->epoch != epoch) {
+    limbo_free(domain, limbo);
+    limbo->epoch = epoch;
+  }
+  if (limbo->num == limbo->size) {
+    uint size = (limbo->size == 0) ? RECLAIM_EPOCH_BATCH : 2 * limbo->size;
+    void **nodes = (void **)realloc(limbo->nodes, sizeof(void *) * size);
+    if (nodes == NULL) {
+      return OUT_OF_MEMORY;
+    }
+    limbo->nodes = nodes;
+    limbo->size = size;
+  }
+  limbo->nodes[limbo->num++] = node;
+
+  if (++self->retire_count >= RECLAIM_EPOCH_BATCH) {
+    self->retire_count = 0;
+    epoch_collect(domain, self, epoch_try_advance(domain));
+  }
+  return SUCCESS;
+}
+
+/* Must be called outside of any critical section. */
+void reclaim_flush_epoch(reclaim_epoch_t *domain) {
+  reclaim_epoch_thread_t *self = &domain->threads[thread_current_id()].value;
+  epoch_collect(domain, self, epoch_try_advance(domain));
+}
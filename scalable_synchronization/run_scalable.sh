@@ -12,3 +12,134 @@ for THREAD_NUM in {2..4..2}
 do
     ${O}/test_small_section ${THREAD_NUM} ${REP}
 done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_fairness ${THREAD_NUM} ${REP}
+done
+
+# Oversubscribed: twice as many threads as cores
+${O}/test_small_section $((2 * $(nproc))) ${REP}
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_counter ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    for PRODUCERS in $(seq 1 $((THREAD_NUM - 1)))
+    do
+        ${O}/test_queue ${THREAD_NUM} ${REP} ${PRODUCERS}
+    done
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_reclaim ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_pool ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_seqlock ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_cond ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_rwlock ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_shuffle ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_slot_pool ${THREAD_NUM} ${REP}
+done
+
+for MUTEX in test_and_set ticket MCS Malthusian
+do
+    for THREAD_NUM in {2..4..2}
+    do
+        ${O}/test_hashmap_${MUTEX} ${THREAD_NUM} ${REP}
+    done
+done
+
+for MUTEX in test_and_set ticket MCS
+do
+    for THREAD_NUM in {2..4..2}
+    do
+        ${O}/test_skiplist_${MUTEX} ${THREAD_NUM} ${REP}
+    done
+done
+
+for PRIMITIVE in ticket partitioned_ticket TWA MCS
+do
+    ${O}/test_trace 16 100 ${PRIMITIVE} ${O}/${PRIMITIVE}.trace
+    ${O}/coherence_sim ${O}/${PRIMITIVE}.trace 16 1
+done
+
+for PRIMITIVE in rwlock_flags rwlock_NUMA_one_node rwlock_NUMA_writer \
+    rwlock_NUMA_neutral
+do
+    ${O}/test_trace 16 1000 ${PRIMITIVE} ${O}/${PRIMITIVE}.trace
+    ${O}/coherence_sim ${O}/${PRIMITIVE}.trace 16 2
+done
+
+for PRIMITIVE in tournament dissemination arrival_tree wide_tree
+do
+    ${O}/test_trace 256 100 ${PRIMITIVE} ${O}/${PRIMITIVE}.trace
+    for SOCKETS in 1 2 4
+    do
+        ${O}/coherence_sim ${O}/${PRIMITIVE}.trace 256 ${SOCKETS}
+    done
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_async ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_multilock ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_bsp ${THREAD_NUM} 100
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_shared ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2}
+do
+    ${O}/test_slab ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in {2..4..2} 64
+do
+    ${O}/test_percpu ${THREAD_NUM} ${REP}
+done
+
+for THREAD_NUM in 4 8 16 64
+do
+    ${O}/test_fixed_${THREAD_NUM} ${REP}
+done
+
+${O}/commuter
@@ -0,0 +1,302 @@
+#include "synchronize.h"
+#include <time.h>
+
+/* BRAVO (Dice and Kogan, ATC 2019). While the lock is read-biased, a reader
+ * publishes the lock's address in a slot of a global visible readers table
+ * and never touches the lock itself. A writer takes the underlying lock,
+ * clears the bias and waits until no slot names the lock any more. Readers
+ * that find the bias off, or their slot taken, take the underlying lock like
+ * a writer, and re-enable the bias once the inhibition period is over. */
+
+static padded_aptr_t visible_readers[RWLOCK_BRAVO_TABLE];
+
+static unsigned long long now_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long long)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static padded_aptr_t *reader_slot(rwlock_BRAVO_t *rwlock) {
+  uint64_t h = (uint64_t)(uintptr_t)rwlock ^ thread_current_id();
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return &visible_readers[h % RWLOCK_BRAVO_TABLE];
+}
+
+#define CREATE_RWLOCK_MUTEX(type)                                              \
+  static void rwlock_lock_##type(void *mutex, void *ownership) {               \
+    mutex_lock_##type((mutex_##type##_t *)mutex);                              \
+  }                                                                            \
+                                                                               \
+  static void rwlock_unlock_##type(void *mutex, void *ownership) {             \
+    mutex_unlock_##type((mutex_##type##_t *)mutex);                            \
+  }                                                                            \
+                                                                               \
+  const rwlock_mutex_t rwlock_mutex_##type = {rwlock_lock_##type,              \
+                                              rwlock_unlock_##type};
+
+#define CREATE_RWLOCK_MUTEX_OWNERSHIP(type)                                    \
+  static void rwlock_lock_##type(void *mutex, void *ownership) {               \
+    mutex_lock_##type((mutex_##type##_t *)mutex,                               \
+                      (mutex_##type##_ownership_t *)ownership);                \
+  }                                                                            \
+                                                                               \
+  static void rwlock_unlock_##type(void *mutex, void *ownership) {             \
+    mutex_unlock_##type((mutex_##type##_t *)mutex,                             \
+                        (mutex_##type##_ownership_t *)ownership);              \
+  }                                                                            \
+                                                                               \
+  const rwlock_mutex_t rwlock_mutex_##type = {rwlock_lock_##type,              \
+                                              rwlock_unlock_##type};
+
+CREATE_RWLOCK_MUTEX(test_and_set)
+CREATE_RWLOCK_MUTEX(ticket)
+CREATE_RWLOCK_MUTEX_OWNERSHIP(Anderson)
+CREATE_RWLOCK_MUTEX(GT)
+CREATE_RWLOCK_MUTEX_OWNERSHIP(MCS)
+CREATE_RWLOCK_MUTEX(CLH)
+
+/* `mutex` must be initialized already and outlive the reader-writer lock */
+int rwlock_init_BRAVO(rwlock_BRAVO_t *rwlock, void *mutex,
+                      const rwlock_mutex_t *operations) {
+  if (mutex == NULL || operations == NULL) {
+    return LIB_INIT_INVALID;
+  }
+  atomic_init(&rwlock->read_bias, true);
+  atomic_init(&rwlock->inhibit_until, 0);
+  rwlock->mutex = mutex;
+  rwlock->operations = operations;
+  return SUCCESS;
+}
+
+void rwlock_read_lock_BRAVO(rwlock_BRAVO_t *rwlock,
+                            rwlock_BRAVO_token_t *token) {
+  if (ATOMIC_LOAD(&rwlock->read_bias)) {
+    padded_aptr_t *slot = reader_slot(rwlock);
+    void *expected = NULL;
+    if (ATOMIC_COMPARE_EXCHANGE(&slot->value, &expected, rwlock)) {
+      ATOMIC_FENCE();
+      if (ATOMIC_ACQUIRE(&rwlock->read_bias)) {
+        token->slot = slot;
+        return;
+      }
+      ATOMIC_STORE(&slot->value, NULL);
+    }
+  }
+
+  token->slot = NULL;
+  rwlock->operations->lock(rwlock->mutex, token->ownership);
+  if (!ATOMIC_LOAD(&rwlock->read_bias) &&
+      now_ns() >= ATOMIC_LOAD(&rwlock->inhibit_until)) {
+    ATOMIC_RELEASE(&rwlock->read_bias, true);
+  }
+}
+
+void rwlock_read_unlock_BRAVO(rwlock_BRAVO_t *rwlock,
+                              rwlock_BRAVO_token_t *token) {
+  if (token->slot != NULL) {
+    ATOMIC_RELEASE(&token->slot->value, NULL);
+  } else {
+    rwlock->operations->unlock(rwlock->mutex, token->ownership);
+  }
+}
+
+void rwlock_write_lock_BRAVO(rwlock_BRAVO_t *rwlock, void *ownership) {
+  rwlock->operations->lock(rwlock->mutex, ownership);
+  if (ATOMIC_LOAD(&rwlock->read_bias)) {
+    uint i;
+    unsigned long long start, end;
+    ATOMIC_STORE(&rwlock->read_bias, false);
+    ATOMIC_FENCE();
+    start = now_ns();
+    for (i = 0; i < RWLOCK_BRAVO_TABLE; ++i) {
+      while (ATOMIC_ACQUIRE(&visible_readers[i].value) == rwlock) {
+        delay(0);
+      }
+    }
+    end = now_ns();
+    ATOMIC_STORE(&rwlock->inhibit_until,
+                 end + (end - start) * RWLOCK_BRAVO_INHIBIT);
+  }
+}
+
+void rwlock_write_unlock_BRAVO(rwlock_BRAVO_t *rwlock, void *ownership) {
+  rwlock->operations->unlock(rwlock->mutex, ownership);
+}
+
+/* Reader-indicator lock: a reader sets its own flag and backs off while a
+ * writer is present; a writer takes the underlying lock, announces itself
+ * and drains the readers by polling their flags a vector at a time. The
+ * flags of up to 32 readers share a vector, so readers trade some cache
+ * line bouncing among themselves for a fast drain. */
+
+/* `mutex` must be initialized already and outlive the reader-writer lock */
+int rwlock_init_flags(rwlock_flags_t *rwlock, uint t_num, void *mutex,
+                      const rwlock_mutex_t *operations) {
+  if (mutex == NULL || operations == NULL) {
+    return LIB_INIT_INVALID;
+  }
+  atomic_init(&rwlock->writer, false);
+  rwlock->mutex = mutex;
+  rwlock->operations = operations;
+  return flag_array_init(&rwlock->readers, t_num);
+}
+
+void rwlock_destroy_flags(rwlock_flags_t *rwlock) {
+  flag_array_destroy(&rwlock->readers);
+}
+
+void rwlock_read_lock_flags(rwlock_flags_t *rwlock) {
+  atomic_bool *flag = &rwlock->readers.flags[thread_current_id()];
+  for (;;) {
+    ATOMIC_STORE(flag, true);
+    ATOMIC_FENCE();
+    if (!ATOMIC_ACQUIRE(&rwlock->writer)) {
+      return;
+    }
+    ATOMIC_RELEASE(flag, false);
+    while (ATOMIC_LOAD(&rwlock->writer)) {
+      delay(0);
+    }
+  }
+}
+
+void rwlock_read_unlock_flags(rwlock_flags_t *rwlock) {
+  ATOMIC_RELEASE(&rwlock->readers.flags[thread_current_id()], false);
+}
+
+void rwlock_write_lock_flags(rwlock_flags_t *rwlock, void *ownership) {
+  rwlock->operations->lock(rwlock->mutex, ownership);
+  ATOMIC_STORE(&rwlock->writer, true);
+  ATOMIC_FENCE();
+  while (flags_any(rwlock->readers.flags, rwlock->readers.vectors)) {
+    delay(0);
+  }
+}
+
+void rwlock_write_unlock_flags(rwlock_flags_t *rwlock, void *ownership) {
+  ATOMIC_RELEASE(&rwlock->writer, false);
+  rwlock->operations->unlock(rwlock->mutex, ownership);
+}
+
+/* NUMA-aware reader-writer lock (Calciu et al., PPoPP 2013). Readers count
+ * themselves on their node's indicator only, so a read never touches a line
+ * of another node. Writers are serialized by a cohort lock: a global ticket
+ * lock taken on behalf of a whole node, and an MCS lock per node whose
+ * holder may pass the global lock on to its local successor. With writer
+ * preference a reader backs off while a writer is present, like the flags
+ * lock; otherwise readers take the cohort lock for their arrival, so that
+ * readers and writers are served in cohort order. */
+
+int rwlock_init_NUMA(rwlock_NUMA_t *rwlock, uint t_num, uint nodes,
+                     bool writer_preference) {
+  uint i;
+  if (t_num == 0 || nodes == 0) {
+    return LIB_INIT_INVALID;
+  }
+  rwlock->readers =
+      (padded_auint_t *)slab_alloc(sizeof(padded_auint_t) * nodes);
+  rwlock->nodes =
+      (padded_NUMA_node_t *)slab_alloc(sizeof(padded_NUMA_node_t) * nodes);
+  if (rwlock->readers == NULL || rwlock->nodes == NULL) {
+    slab_free(rwlock->readers);
+    slab_free(rwlock->nodes);
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < nodes; ++i) {
+    atomic_init(&rwlock->readers[i].value, 0);
+    mutex_init_MCS(&rwlock->nodes[i].value.local);
+    rwlock->nodes[i].value.global_held = false;
+    rwlock->nodes[i].value.batch = 0;
+  }
+  rwlock->node_num = nodes;
+  rwlock->threads_per_node = (t_num + nodes - 1) / nodes;
+  mutex_init_ticket(&rwlock->global);
+  atomic_init(&rwlock->writer, false);
+  rwlock->writer_preference = writer_preference;
+  return SUCCESS;
+}
+
+void rwlock_destroy_NUMA(rwlock_NUMA_t *rwlock) {
+  slab_free(rwlock->readers);
+  slab_free(rwlock->nodes);
+  rwlock->readers = NULL;
+  rwlock->nodes = NULL;
+}
+
+static uint current_node(rwlock_NUMA_t *rwlock) {
+  return thread_current_id() / rwlock->threads_per_node;
+}
+
+static void cohort_lock(rwlock_NUMA_t *rwlock,
+                        mutex_MCS_ownership_t *ownership) {
+  rwlock_NUMA_node_t *node = &rwlock->nodes[current_node(rwlock)].value;
+  mutex_lock_MCS(&node->local, ownership);
+  if (!node->global_held) {
+    mutex_lock_ticket(&rwlock->global);
+    node->global_held = true;
+    node->batch = 0;
+  }
+}
+
+static void cohort_unlock(rwlock_NUMA_t *rwlock,
+                          mutex_MCS_ownership_t *ownership) {
+  rwlock_NUMA_node_t *node = &rwlock->nodes[current_node(rwlock)].value;
+  if (ATOMIC_LOAD(&ownership->next) == NULL ||
+      ++node->batch >= RWLOCK_NUMA_BATCH) {
+    node->global_held = false;
+    mutex_unlock_ticket(&rwlock->global);
+  }
+  mutex_unlock_MCS(&node->local, ownership);
+}
+
+void rwlock_read_lock_NUMA(rwlock_NUMA_t *rwlock,
+                           mutex_MCS_ownership_t *ownership) {
+  atomic_uint *readers = &rwlock->readers[current_node(rwlock)].value;
+  if (!rwlock->writer_preference) {
+    cohort_lock(rwlock, ownership);
+    ATOMIC_ADD(readers, 1);
+    cohort_unlock(rwlock, ownership);
+    return;
+  }
+  for (;;) {
+    ATOMIC_ADD(readers, 1);
+    ATOMIC_FENCE();
+    if (!ATOMIC_ACQUIRE(&rwlock->writer)) {
+      return;
+    }
+    ATOMIC_SUB(readers, 1);
+    while (ATOMIC_LOAD(&rwlock->writer)) {
+      delay(0);
+    }
+  }
+}
+
+void rwlock_read_unlock_NUMA(rwlock_NUMA_t *rwlock) {
+  atomic_thread_fence(memory_order_release);
+  ATOMIC_SUB(&rwlock->readers[current_node(rwlock)].value, 1);
+}
+
+void rwlock_write_lock_NUMA(rwlock_NUMA_t *rwlock,
+                            mutex_MCS_ownership_t *ownership) {
+  uint i;
+  cohort_lock(rwlock, ownership);
+  if (rwlock->writer_preference) {
+    ATOMIC_STORE(&rwlock->writer, true);
+    ATOMIC_FENCE();
+  }
+  for (i = 0; i < rwlock->node_num; ++i) {
+    while (ATOMIC_ACQUIRE(&rwlock->readers[i].value) != 0) {
+      delay(0);
+    }
+  }
+}
+
+void rwlock_write_unlock_NUMA(rwlock_NUMA_t *rwlock,
+                              mutex_MCS_ownership_t *ownership) {
+  if (rwlock->writer_preference) {
+    ATOMIC_RELEASE(&rwlock->writer, false);
+  }
+  cohort_unlock(rwlock, ownership);
+}
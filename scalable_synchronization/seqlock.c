@@ -0,0 +1,97 @@
+#include "synchronize.h"
+
+/* Sequence lock: the sequence is odd while a writer is inside, and writers
+ * are serialized by a ticket lock. */
+
+int seqlock_init_ticket(seqlock_ticket_t *lock) {
+  atomic_init(&lock->sequence, 0);
+  return mutex_init_ticket(&lock->writer);
+}
+
+uint seqlock_read_begin_ticket(seqlock_ticket_t *lock) {
+  uint start;
+  while ((start = ATOMIC_ACQUIRE(&lock->sequence)) & 1) {
+    delay(0);
+  }
+  return start;
+}
+
+bool seqlock_read_retry_ticket(seqlock_ticket_t *lock, uint start) {
+  atomic_thread_fence(memory_order_acquire);
+  return ATOMIC_LOAD(&lock->sequence) != start;
+}
+
+void seqlock_write_lock_ticket(seqlock_ticket_t *lock) {
+  mutex_lock_ticket(&lock->writer);
+  ATOMIC_STORE(&lock->sequence, ATOMIC_LOAD(&lock->sequence) + 1);
+  atomic_thread_fence(memory_order_release);
+}
+
+void seqlock_write_unlock_ticket(seqlock_ticket_t *lock) {
+  ATOMIC_RELEASE(&lock->sequence, ATOMIC_LOAD(&lock->sequence) + 1);
+  mutex_unlock_ticket(&lock->writer);
+}
+
+/* Versioned lock: one word holds both the lock bit and the version. Writers
+ * bump the version on unlock. A pessimistic reader takes the lock bit but
+ * restores the old version, so concurrent optimistic readers still
+ * validate. */
+
+int seqlock_init_versioned(seqlock_versioned_t *lock) {
+  atomic_init(&lock->word, 0);
+  return SUCCESS;
+}
+
+bool seqlock_read_begin_versioned(seqlock_versioned_t *lock, uint *version) {
+  *version = ATOMIC_ACQUIRE(&lock->word);
+  return (*version & 1) == 0;
+}
+
+bool seqlock_read_validate_versioned(seqlock_versioned_t *lock,
+                                     uint version) {
+  atomic_thread_fence(memory_order_acquire);
+  return ATOMIC_LOAD(&lock->word) == version;
+}
+
+uint seqlock_read_lock_versioned(seqlock_versioned_t *lock) {
+  for (;;) {
+    uint version = ATOMIC_LOAD(&lock->word);
+    if ((version & 1) == 0 &&
+        ATOMIC_COMPARE_EXCHANGE_ACQUIRE(&lock->word, &version, version | 1)) {
+      return version;
+    }
+    delay(0);
+  }
+}
+
+void seqlock_read_unlock_versioned(seqlock_versioned_t *lock, uint version) {
+  ATOMIC_RELEASE(&lock->word, version);
+}
+
+/* Runs `reader` optimistically at most `SEQLOCK_OPTIMISTIC_RETRIES` times,
+ * then under the lock. */
+void seqlock_read_versioned(seqlock_versioned_t *lock, seqlock_reader_t reader,
+                            void *arg) {
+  uint i, version;
+  for (i = 0; i < SEQLOCK_OPTIMISTIC_RETRIES; ++i) {
+    if (seqlock_read_begin_versioned(lock, &version)) {
+      reader(arg);
+      if (seqlock_read_validate_versioned(lock, version)) {
+        return;
+      }
+    }
+    delay(0);
+  }
+  version = seqlock_read_lock_versioned(lock);
+  reader(arg);
+  seqlock_read_unlock_versioned(lock, version);
+}
+
+void seqlock_write_lock_versioned(seqlock_versioned_t *lock) {
+  seqlock_read_lock_versioned(lock);
+  atomic_thread_fence(memory_order_release);
+}
+
+void seqlock_write_unlock_versioned(seqlock_versioned_t *lock) {
+  ATOMIC_RELEASE(&lock->word, ATOMIC_LOAD(&lock->word) + 1);
+}
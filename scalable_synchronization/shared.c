@@ -0,0 +1,230 @@
+#include "synchronize.h"
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define THREAD_LOCAL _Thread_local
+
+/* Futex operations without `FUTEX_PRIVATE_FLAG`, so that the kernel keys
+ * them by the shared page and a wake reaches waiters in other processes */
+static void futex_wait(atomic_uint *word, uint value) {
+  syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+static void futex_wake(atomic_uint *word, int count) {
+  syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+static uint ceiling_2(uint n) {
+  uint i = 2;
+  while (i < n) {
+    i = i << 1;
+  }
+  return i;
+}
+
+static THREAD_LOCAL uint shared_id;
+
+int shared_registry_init(shared_registry_t *registry, uint capacity) {
+  if (capacity == 0) {
+    return LIB_INIT_INVALID;
+  }
+  atomic_init(&registry->next_id, 0);
+  registry->capacity = capacity;
+  return SUCCESS;
+}
+
+int shared_registry_join(shared_registry_t *registry) {
+  uint id = ATOMIC_ADD(&registry->next_id, 1);
+  if (id >= registry->capacity) {
+    return LIB_INIT_INVALID;
+  }
+  shared_id = id;
+  return SUCCESS;
+}
+
+uint shared_current_id() { return shared_id; }
+
+/* MCS lock whose queue links hold participant indices. A waiter spins for a
+ * while, then marks its node sleeping and waits on the node's state; the
+ * releaser only makes the system call for a sleeping successor. */
+
+#define SHARED_GRANTED 0
+#define SHARED_WAITING 1
+#define SHARED_SLEEPING 2
+
+size_t mutex_size_shared_MCS(uint capacity) {
+  return sizeof(mutex_shared_MCS_t) +
+         sizeof(padded_shared_MCS_node_t) * capacity;
+}
+
+int mutex_init_shared_MCS(mutex_shared_MCS_t *mutex, uint capacity) {
+  uint i;
+  if (capacity == 0) {
+    return LIB_INIT_INVALID;
+  }
+  for (i = 0; i < capacity; ++i) {
+    atomic_init(&mutex->nodes[i].value.next, 0);
+    atomic_init(&mutex->nodes[i].value.state, SHARED_GRANTED);
+  }
+  atomic_init(&mutex->tail, 0);
+  mutex->capacity = capacity;
+  return SUCCESS;
+}
+
+void mutex_lock_shared_MCS(mutex_shared_MCS_t *mutex) {
+  uint me = shared_current_id() + 1, predecessor;
+  shared_MCS_node_t *node = &mutex->nodes[me - 1].value;
+  ATOMIC_STORE(&node->next, 0);
+  ATOMIC_STORE(&node->state, SHARED_WAITING);
+  predecessor = ATOMIC_ACQUIRE_EXCHANGE(&mutex->tail, me);
+  if (predecessor != 0) {
+    uint state, spins = 0;
+    ATOMIC_RELEASE(&mutex->nodes[predecessor - 1].value.next, me);
+    while ((state = ATOMIC_ACQUIRE(&node->state)) != SHARED_GRANTED) {
+      if (spins < SHARED_SPIN) {
+        ++spins;
+        delay(0);
+      } else if (state == SHARED_SLEEPING ||
+                 ATOMIC_COMPARE_EXCHANGE(&node->state, &state,
+                                         SHARED_SLEEPING)) {
+        futex_wait(&node->state, SHARED_SLEEPING);
+      }
+    }
+  }
+}
+
+void mutex_unlock_shared_MCS(mutex_shared_MCS_t *mutex) {
+  uint me = shared_current_id() + 1, successor;
+  shared_MCS_node_t *node = &mutex->nodes[me - 1].value, *next;
+  if (ATOMIC_LOAD(&node->next) == 0) {
+    uint expected = me;
+    if (ATOMIC_COMPARE_EXCHANGE_RELEASE(&mutex->tail, &expected, 0)) {
+      return;
+    }
+    while (ATOMIC_ACQUIRE(&node->next) == 0) {
+      delay(0);
+    }
+  }
+  successor = ATOMIC_ACQUIRE(&node->next);
+  next = &mutex->nodes[successor - 1].value;
+  atomic_thread_fence(memory_order_release);
+  if (ATOMIC_EXCHANGE(&next->state, SHARED_GRANTED) == SHARED_SLEEPING) {
+    futex_wake(&next->state, 1);
+  }
+}
+
+/* Anderson and CLH locks with their arrays inline. Both spin only. */
+
+size_t mutex_size_shared_Anderson(uint capacity) {
+  return sizeof(mutex_shared_Anderson_t) +
+         sizeof(padded_abool_t) * ceiling_2(capacity);
+}
+
+int mutex_init_shared_Anderson(mutex_shared_Anderson_t *mutex,
+                               uint capacity) {
+  uint i, slots = ceiling_2(capacity);
+  if (capacity == 0) {
+    return LIB_INIT_INVALID;
+  }
+  atomic_init(&mutex->slots[0].value, false);
+  for (i = 1; i < slots; ++i) {
+    atomic_init(&mutex->slots[i].value, true);
+  }
+  atomic_init(&mutex->next_slot, 0);
+  mutex->mask = slots - 1;
+  return SUCCESS;
+}
+
+void mutex_lock_shared_Anderson(mutex_shared_Anderson_t *mutex,
+                                mutex_Anderson_ownership_t *ownership) {
+  uint my_place = ATOMIC_ADD(&mutex->next_slot, 1) & mutex->mask;
+  while (ATOMIC_ACQUIRE(&mutex->slots[my_place].value)) {
+    delay(0);
+  }
+  ATOMIC_STORE(&mutex->slots[my_place].value, true);
+  ownership->my_place = my_place;
+}
+
+void mutex_unlock_shared_Anderson(mutex_shared_Anderson_t *mutex,
+                                  mutex_Anderson_ownership_t *ownership) {
+  ATOMIC_RELEASE(&mutex->slots[(ownership->my_place + 1) & mutex->mask].value,
+                 false);
+}
+
+static padded_abool_t *CLH_slots(mutex_shared_CLH_t *mutex) {
+  return (padded_abool_t *)&mutex->states[mutex->capacity];
+}
+
+size_t mutex_size_shared_CLH(uint capacity) {
+  return sizeof(mutex_shared_CLH_t) + sizeof(padded_CLH_state_t) * capacity +
+         sizeof(padded_abool_t) * (capacity + 1);
+}
+
+int mutex_init_shared_CLH(mutex_shared_CLH_t *mutex, uint capacity) {
+  uint i;
+  padded_abool_t *slots;
+  if (capacity == 0) {
+    return LIB_INIT_INVALID;
+  }
+  mutex->capacity = capacity;
+  slots = CLH_slots(mutex);
+  for (i = 0; i < capacity; ++i) {
+    mutex->states[i].value.my_id = i;
+    atomic_init(&slots[i].value, false);
+  }
+  atomic_init(&slots[capacity].value, true);
+  atomic_init(&mutex->tail, capacity);
+  return SUCCESS;
+}
+
+void mutex_lock_shared_CLH(mutex_shared_CLH_t *mutex) {
+  mutex_CLH_state_t *current_state = &mutex->states[shared_current_id()].value;
+  padded_abool_t *slots = CLH_slots(mutex);
+  uint node_id = current_state->my_id;
+  ATOMIC_STORE(&slots[node_id].value, false);
+  current_state->watching = ATOMIC_EXCHANGE(&mutex->tail, node_id);
+  while (!ATOMIC_ACQUIRE(&slots[current_state->watching].value)) {
+    delay(0);
+  }
+}
+
+void mutex_unlock_shared_CLH(mutex_shared_CLH_t *mutex) {
+  mutex_CLH_state_t *current_state = &mutex->states[shared_current_id()].value;
+  ATOMIC_RELEASE(&CLH_slots(mutex)[current_state->my_id].value, true);
+  current_state->my_id = current_state->watching;
+}
+
+/* Centralized barrier counting episodes in `generation`, which is also the
+ * futex word its waiters sleep on after spinning */
+
+int barrier_init_shared_futex(barrier_shared_futex_t *barrier,
+                              uint participants) {
+  if (participants == 0) {
+    return LIB_INIT_INVALID;
+  }
+  atomic_init(&barrier->count, participants);
+  atomic_init(&barrier->generation, 0);
+  barrier->participants = participants;
+  return SUCCESS;
+}
+
+void barrier_wait_shared_futex(barrier_shared_futex_t *barrier) {
+  uint generation = ATOMIC_ACQUIRE(&barrier->generation);
+  if (atomic_fetch_sub_explicit(&barrier->count, 1, memory_order_acq_rel) ==
+      1) {
+    ATOMIC_STORE(&barrier->count, barrier->participants);
+    ATOMIC_RELEASE(&barrier->generation, generation + 1);
+    futex_wake(&barrier->generation, INT_MAX);
+  } else {
+    uint spins = 0;
+    while (ATOMIC_ACQUIRE(&barrier->generation) == generation) {
+      if (spins < SHARED_SPIN) {
+        ++spins;
+        delay(0);
+      } else {
+        futex_wait(&barrier->generation, generation);
+      }
+    }
+  }
+}
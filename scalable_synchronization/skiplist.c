@@ -0,0 +1,311 @@
+#include "synchronize.h"
+#define THREAD_LOCAL _Thread_local
+
+/* Lazy skip list (Herlihy, Lev, Luchangco and Shavit, 2007). Searches take
+ * no lock and never restart. Writers search first, then lock only the
+ * predecessors they link or unlink and validate that those are unmarked and
+ * still point where the search saw them, starting over otherwise. A node is
+ * in the set once fully linked and until marked, so readers decide on those
+ * two flags alone; removed nodes go to the epochs, which keep them alive for
+ * searches still walking them.
+ *
+ * Locks are always taken in descending key order, predecessors bottom-up
+ * after the node being removed, so writers cannot deadlock. The same
+ * predecessor on several consecutive levels is only locked once. */
+
+#ifdef SKIPLIST_MUTEX_OWNERSHIP
+typedef SKIPLIST_NAME(mutex_, SKIPLIST_MUTEX, _ownership_t) node_ownership_t;
+#define node_lock(node, ownership)                                             \
+  SKIPLIST_NAME(mutex_lock_, SKIPLIST_MUTEX, )(&(node)->lock, ownership)
+#define node_unlock(node, ownership)                                           \
+  SKIPLIST_NAME(mutex_unlock_, SKIPLIST_MUTEX, )(&(node)->lock, ownership)
+#else
+typedef char node_ownership_t;
+#define node_lock(node, ownership)                                             \
+  SKIPLIST_NAME(mutex_lock_, SKIPLIST_MUTEX, )(&(node)->lock)
+#define node_unlock(node, ownership)                                           \
+  SKIPLIST_NAME(mutex_unlock_, SKIPLIST_MUTEX, )(&(node)->lock)
+#endif
+
+static THREAD_LOCAL uint64_t seed;
+
+static uint random_level() {
+  uint64_t r;
+  if (seed == 0) {
+    seed = 0x9e3779b97f4a7c15ull * (thread_current_id() + 1);
+  }
+  seed ^= seed << 13;
+  seed ^= seed >> 7;
+  seed ^= seed << 17;
+  r = seed | (1ull << (SKIPLIST_MAX_LEVEL - 1));
+  return (uint)__builtin_ctzll(r);
+}
+
+static skiplist_node_t *node_create(unsigned long key, unsigned long value,
+                                    uint top_level) {
+  skiplist_node_t *node = (skiplist_node_t *)slab_alloc(
+      sizeof(skiplist_node_t) + sizeof(skiplist_node_ptr_t) * (top_level + 1));
+  if (node == NULL) {
+    return NULL;
+  }
+  node->key = key;
+  atomic_init(&node->value, value);
+  SKIPLIST_NAME(mutex_init_, SKIPLIST_MUTEX, )(&node->lock);
+  node->top_level = top_level;
+  atomic_init(&node->marked, false);
+  atomic_init(&node->fully_linked, false);
+  return node;
+}
+
+int skiplist_init(skiplist_t *list, uint t_num) {
+  uint i;
+  skiplist_node_t *head = node_create(0, 0, SKIPLIST_MAX_LEVEL - 1);
+  if (head == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  if (reclaim_init_epoch(&list->epochs, t_num, slab_free) != SUCCESS) {
+    slab_free(head);
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < SKIPLIST_MAX_LEVEL; ++i) {
+    atomic_init(&head->next[i], NULL);
+  }
+  atomic_init(&head->fully_linked, true);
+  list->head = head;
+  return SUCCESS;
+}
+
+void skiplist_destroy(skiplist_t *list) {
+  skiplist_node_t *node = list->head;
+  reclaim_destroy_epoch(&list->epochs);
+  while (node != NULL) {
+    skiplist_node_t *next = ATOMIC_LOAD(&node->next[0]);
+    slab_free(node);
+    node = next;
+  }
+  list->head = NULL;
+}
+
+/* Fills the predecessors and successors of `key` on every level and returns
+ * the highest level the key was found on, or -1. With `finger`, a level
+ * starts from `finger[l]` when it is further along: any unmarked node
+ * before `key` will do, validation catches the stale ones. */
+static int find(skiplist_t *list, unsigned long key,
+                skiplist_node_t *const *finger, skiplist_node_t **preds,
+                skiplist_node_t **succs) {
+  int l, found = -1;
+  skiplist_node_t *pred = list->head;
+  for (l = SKIPLIST_MAX_LEVEL - 1; l >= 0; --l) {
+    skiplist_node_t *curr;
+    if (finger != NULL && finger[l] != list->head && finger[l]->key < key &&
+        (pred == list->head || finger[l]->key > pred->key) &&
+        !ATOMIC_LOAD(&finger[l]->marked)) {
+      pred = finger[l];
+    }
+    curr = ATOMIC_ACQUIRE(&pred->next[l]);
+    while (curr != NULL && curr->key < key) {
+      pred = curr;
+      curr = ATOMIC_ACQUIRE(&pred->next[l]);
+    }
+    if (found == -1 && curr != NULL && curr->key == key) {
+      found = l;
+    }
+    preds[l] = pred;
+    succs[l] = curr;
+  }
+  return found;
+}
+
+static void unlock_preds(skiplist_node_t **preds, node_ownership_t *ownership,
+                         int highest) {
+  int l;
+  for (l = 0; l <= highest; ++l) {
+    if (l == 0 || preds[l] != preds[l - 1]) {
+      node_unlock(preds[l], &ownership[l]);
+    }
+  }
+}
+
+/* Locks the predecessors of levels 0 to `top_level` and checks that each
+ * still links to `succs[l]`; unlocks them again if not */
+static bool lock_preds(skiplist_node_t **preds, skiplist_node_t **succs,
+                       node_ownership_t *ownership, int top_level,
+                       bool check_succs) {
+  int l;
+  for (l = 0; l <= top_level; ++l) {
+    skiplist_node_t *pred = preds[l], *succ = succs[l];
+    if (l == 0 || pred != preds[l - 1]) {
+      node_lock(pred, &ownership[l]);
+    }
+    if (ATOMIC_LOAD(&pred->marked) ||
+        (check_succs && succ != NULL && ATOMIC_LOAD(&succ->marked)) ||
+        ATOMIC_LOAD(&pred->next[l]) != succ) {
+      unlock_preds(preds, ownership, l);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool skiplist_get(skiplist_t *list, unsigned long key, unsigned long *value) {
+  int l;
+  bool found = false;
+  skiplist_node_t *pred, *curr = NULL;
+  reclaim_enter_epoch(&list->epochs);
+  pred = list->head;
+  for (l = SKIPLIST_MAX_LEVEL - 1; l >= 0; --l) {
+    curr = ATOMIC_ACQUIRE(&pred->next[l]);
+    while (curr != NULL && curr->key < key) {
+      pred = curr;
+      curr = ATOMIC_ACQUIRE(&pred->next[l]);
+    }
+    if (curr != NULL && curr->key == key) {
+      break;
+    }
+  }
+  if (curr != NULL && curr->key == key &&
+      ATOMIC_ACQUIRE(&curr->fully_linked) && !ATOMIC_LOAD(&curr->marked)) {
+    *value = ATOMIC_ACQUIRE(&curr->value);
+    found = true;
+  }
+  reclaim_exit_epoch(&list->epochs);
+  return found;
+}
+
+/* With the caller's epoch held; `preds` is also the finger when `finger` */
+static bool put(skiplist_t *list, unsigned long key, unsigned long value,
+                skiplist_node_t **preds, bool finger) {
+  skiplist_node_t *succs[SKIPLIST_MAX_LEVEL], *node = NULL;
+  node_ownership_t ownership[SKIPLIST_MAX_LEVEL];
+  uint top_level = random_level();
+  int l;
+
+  for (;;) {
+    int found = find(list, key, finger ? preds : NULL, preds, succs);
+    finger = false;
+    if (found >= 0) {
+      skiplist_node_t *present = succs[found];
+      if (!ATOMIC_ACQUIRE(&present->marked)) {
+        while (!ATOMIC_ACQUIRE(&present->fully_linked)) {
+          delay(0);
+        }
+        ATOMIC_RELEASE(&present->value, value);
+        slab_free(node);
+        return false;
+      }
+      continue;
+    }
+    /* Allocated out of the critical section, and only once */
+    if (node == NULL &&
+        (node = node_create(key, value, top_level)) == NULL) {
+      return false;
+    }
+    if (!lock_preds(preds, succs, ownership, top_level, true)) {
+      continue;
+    }
+    for (l = 0; l <= (int)top_level; ++l) {
+      atomic_init(&node->next[l], succs[l]);
+    }
+    for (l = 0; l <= (int)top_level; ++l) {
+      ATOMIC_RELEASE(&preds[l]->next[l], node);
+    }
+    ATOMIC_RELEASE(&node->fully_linked, true);
+    unlock_preds(preds, ownership, top_level);
+    return true;
+  }
+}
+
+bool skiplist_put(skiplist_t *list, unsigned long key, unsigned long value) {
+  skiplist_node_t *preds[SKIPLIST_MAX_LEVEL];
+  bool inserted;
+  reclaim_enter_epoch(&list->epochs);
+  inserted = put(list, key, value, preds, false);
+  reclaim_exit_epoch(&list->epochs);
+  return inserted;
+}
+
+/* One epoch for the whole batch keeps the finger alive */
+uint skiplist_put_batch(skiplist_t *list, const unsigned long *keys,
+                        const unsigned long *values, uint n) {
+  skiplist_node_t *preds[SKIPLIST_MAX_LEVEL];
+  uint i, inserted = 0;
+  reclaim_enter_epoch(&list->epochs);
+  for (i = 0; i < n; ++i) {
+    inserted += put(list, keys[i], values[i], preds, i > 0);
+  }
+  reclaim_exit_epoch(&list->epochs);
+  return inserted;
+}
+
+/* Only a node found on its top level, fully linked and unmarked, is
+ * removed; the remover marks it under its lock, then unlinks it top-down */
+bool skiplist_remove(skiplist_t *list, unsigned long key) {
+  skiplist_node_t *preds[SKIPLIST_MAX_LEVEL], *succs[SKIPLIST_MAX_LEVEL];
+  skiplist_node_t *victim = NULL;
+  node_ownership_t ownership[SKIPLIST_MAX_LEVEL], victim_ownership;
+  int l, top_level = -1;
+  bool removed = false;
+
+  reclaim_enter_epoch(&list->epochs);
+  for (;;) {
+    int found = find(list, key, NULL, preds, succs);
+    if (victim == NULL) {
+      skiplist_node_t *candidate = (found >= 0) ? succs[found] : NULL;
+      if (candidate == NULL || !ATOMIC_ACQUIRE(&candidate->fully_linked) ||
+          (int)candidate->top_level != found ||
+          ATOMIC_LOAD(&candidate->marked)) {
+        break;
+      }
+      node_lock(candidate, &victim_ownership);
+      if (ATOMIC_LOAD(&candidate->marked)) {
+        node_unlock(candidate, &victim_ownership);
+        break;
+      }
+      ATOMIC_STORE(&candidate->marked, true);
+      victim = candidate;
+      top_level = (int)victim->top_level;
+    }
+    for (l = 0; l <= top_level; ++l) {
+      succs[l] = victim;
+    }
+    if (!lock_preds(preds, succs, ownership, top_level, false)) {
+      continue;
+    }
+    for (l = top_level; l >= 0; --l) {
+      ATOMIC_RELEASE(&preds[l]->next[l], ATOMIC_LOAD(&victim->next[l]));
+    }
+    node_unlock(victim, &victim_ownership);
+    unlock_preds(preds, ownership, top_level);
+    reclaim_retire_epoch(&list->epochs, victim);
+    removed = true;
+    break;
+  }
+  reclaim_exit_epoch(&list->epochs);
+  return removed;
+}
+
+uint skiplist_range(skiplist_t *list, unsigned long low, unsigned long high,
+                    unsigned long *keys, unsigned long *values, uint max) {
+  int l;
+  uint count = 0;
+  skiplist_node_t *pred, *curr = NULL;
+  reclaim_enter_epoch(&list->epochs);
+  pred = list->head;
+  for (l = SKIPLIST_MAX_LEVEL - 1; l >= 0; --l) {
+    curr = ATOMIC_ACQUIRE(&pred->next[l]);
+    while (curr != NULL && curr->key < low) {
+      pred = curr;
+      curr = ATOMIC_ACQUIRE(&pred->next[l]);
+    }
+  }
+  while (curr != NULL && curr->key <= high && count < max) {
+    if (ATOMIC_ACQUIRE(&curr->fully_linked) && !ATOMIC_LOAD(&curr->marked)) {
+      keys[count] = curr->key;
+      values[count] = ATOMIC_ACQUIRE(&curr->value);
+      ++count;
+    }
+    curr = ATOMIC_ACQUIRE(&curr->next[0]);
+  }
+  reclaim_exit_epoch(&list->epochs);
+  return count;
+}
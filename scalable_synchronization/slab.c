@@ -0,0 +1,127 @@
+#include "synchronize.h"
+#include <limits.h>
+#include <stdlib.h>
+
+/* Every thread carves blocks out of its own slabs and keeps a free list per
+ * size class, so allocating and freeing on one thread touch no shared line.
+ * A block freed by another thread is pushed onto a remote list of its
+ * owner, which the owner takes whole once its local list runs dry: pushes
+ * never race with pops of single blocks, hence no ABA. The atomics bypass
+ * the `ATOMIC_*` macros, so that traces only show the callers' accesses. */
+
+#define SLAB_LARGE UINT_MAX
+#define SLAB_MASK ((uintptr_t)SLAB_SIZE - 1)
+
+typedef struct slab_block { struct slab_block *next; } slab_block_t;
+
+typedef _Atomic(slab_block_t *) atomic_block_ptr_t;
+
+/* First cache line of every slab */
+typedef struct {
+  uint owner;
+  uint lines;
+} slab_header_t;
+
+typedef struct {
+  slab_block_t *free[SLAB_CLASSES];
+  /* Uncarved part of the newest slab of each class */
+  char *next[SLAB_CLASSES], *end[SLAB_CLASSES];
+  /* Written by other threads, so on lines of their own */
+  _Alignas(CACHE_LINE_SIZE) atomic_block_ptr_t remote[SLAB_CLASSES];
+} slab_heap_t;
+
+static slab_heap_t heaps[SLAB_THREADS];
+
+static uint slab_class(size_t size) {
+  uint i = 0;
+  size_t lines = (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+  while ((1u << i) < lines) {
+    ++i;
+  }
+  return i;
+}
+
+static slab_header_t *slab_of(void *block) {
+  return (slab_header_t *)((uintptr_t)block & ~SLAB_MASK);
+}
+
+static void *slab_alloc_large(size_t size) {
+  size_t bytes = (size + CACHE_LINE_SIZE + SLAB_MASK) & ~SLAB_MASK;
+  slab_header_t *slab = (slab_header_t *)aligned_alloc(SLAB_SIZE, bytes);
+  if (slab == NULL) {
+    return NULL;
+  }
+  slab->owner = SLAB_LARGE;
+  slab->lines = 0;
+  return (char *)slab + CACHE_LINE_SIZE;
+}
+
+static bool slab_refill(slab_heap_t *heap, uint owner, uint i) {
+  slab_header_t *slab = (slab_header_t *)aligned_alloc(SLAB_SIZE, SLAB_SIZE);
+  if (slab == NULL) {
+    return false;
+  }
+  slab->owner = owner;
+  slab->lines = 1u << i;
+  heap->next[i] = (char *)slab + CACHE_LINE_SIZE;
+  heap->end[i] = (char *)slab + SLAB_SIZE;
+  return true;
+}
+
+void *slab_alloc(size_t size) {
+  uint owner = thread_current_id(), i = slab_class(size);
+  slab_heap_t *heap;
+  slab_block_t *block;
+  size_t bytes;
+
+  if (i >= SLAB_CLASSES || owner >= SLAB_THREADS) {
+    return slab_alloc_large(size);
+  }
+  heap = &heaps[owner];
+  block = heap->free[i];
+  if (block == NULL &&
+      atomic_load_explicit(&heap->remote[i], memory_order_relaxed) != NULL) {
+    block = atomic_exchange_explicit(&heap->remote[i], NULL,
+                                     memory_order_acquire);
+  }
+  if (block != NULL) {
+    heap->free[i] = block->next;
+    return block;
+  }
+  bytes = (size_t)CACHE_LINE_SIZE << i;
+  if ((size_t)(heap->end[i] - heap->next[i]) < bytes &&
+      !slab_refill(heap, owner, i)) {
+    return NULL;
+  }
+  block = (slab_block_t *)heap->next[i];
+  heap->next[i] += bytes;
+  return block;
+}
+
+/* Slabs are never returned to the system, only large blocks are */
+void slab_free(void *ptr) {
+  slab_header_t *slab;
+  slab_block_t *block = (slab_block_t *)ptr;
+  uint i;
+
+  if (block == NULL) {
+    return;
+  }
+  slab = slab_of(block);
+  if (slab->owner == SLAB_LARGE) {
+    free(slab);
+    return;
+  }
+  i = slab_class((size_t)slab->lines * CACHE_LINE_SIZE);
+  if (slab->owner == thread_current_id()) {
+    block->next = heaps[slab->owner].free[i];
+    heaps[slab->owner].free[i] = block;
+  } else {
+    atomic_block_ptr_t *remote = &heaps[slab->owner].remote[i];
+    slab_block_t *head = atomic_load_explicit(remote, memory_order_relaxed);
+    do {
+      block->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(
+        remote, &head, block, memory_order_release, memory_order_relaxed));
+  }
+}
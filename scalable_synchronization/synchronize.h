@@ -1,8 +1,11 @@
 #ifndef SYNCHRONIZE_H_INCLUDED
 #define SYNCHRONIZE_H_INCLUDED 1
 
+#include <pthread.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define delay(time)
 
@@ -18,29 +21,83 @@ typedef unsigned int uint;
 
 AVOID_FALSE_SHARING(bool, padded_bool_t)
 AVOID_FALSE_SHARING(atomic_bool, padded_abool_t)
+AVOID_FALSE_SHARING(atomic_uint, padded_auint_t)
 
 #define LIB_INIT_INVALID -1
 #define OUT_OF_MEMORY -2
 #define SUCCESS 0
 
 /* Atomics */
-#define ATOMIC_LOAD(x_) atomic_load_explicit((x_), memory_order_relaxed)
+
+#ifdef ATOMIC_TRACE
+/* Trace mode: every access through the `ATOMIC_*` macros is logged with the
+ * calling thread, the address and the kind of access, to be replayed by
+ * `coherence_sim`. Spinning yields, so that traces of more threads than
+ * cores still make progress. */
+#include <sched.h>
+#undef delay
+#define delay(time) sched_yield()
+
+#define ATOMIC_TRACE_READ 'R'
+#define ATOMIC_TRACE_WRITE 'W'
+#define ATOMIC_TRACE_RMW 'X'
+#define ATOMIC_TRACE_FENCE 'F'
+/* Marks the end of a lock acquire or barrier episode */
+#define ATOMIC_TRACE_EPISODE 'E'
+
+typedef void (*atomic_trace_visitor_t)(uint thread, char operation,
+                                       const void *address, void *arg);
+
+int atomic_trace_start(unsigned long capacity);
+void atomic_trace(const void *address, char operation);
+/* Both end the trace and return the number of records that were dropped */
+int atomic_trace_stop(atomic_trace_visitor_t visitor, void *arg);
+int atomic_trace_dump(const char *path);
+
+#define ATOMIC_TRACED(x_, op_, e_) (atomic_trace((const void *)(x_), op_), e_)
+#else
+#define ATOMIC_TRACED(x_, op_, e_) (e_)
+#endif
+
+#define ATOMIC_LOAD(x_)                                                        \
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_READ,                                         \
+                atomic_load_explicit((x_), memory_order_relaxed))
 #define ATOMIC_STORE(x_, v_)                                                   \
-  atomic_store_explicit((x_), (v_), memory_order_relaxed)
-#define ATOMIC_ACQUIRE(x_) atomic_load_explicit((x_), memory_order_acquire)
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_WRITE,                                        \
+                atomic_store_explicit((x_), (v_), memory_order_relaxed))
+#define ATOMIC_ACQUIRE(x_)                                                     \
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_READ,                                         \
+                atomic_load_explicit((x_), memory_order_acquire))
 #define ATOMIC_RELEASE(x_, v_)                                                 \
-  atomic_store_explicit((x_), (v_), memory_order_release)
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_WRITE,                                        \
+                atomic_store_explicit((x_), (v_), memory_order_release))
 #define ATOMIC_EXCHANGE(x_, v_)                                                \
-  atomic_exchange_explicit((x_), (v_), memory_order_relaxed)
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_RMW,                                          \
+                atomic_exchange_explicit((x_), (v_), memory_order_relaxed))
 #define ATOMIC_ACQUIRE_EXCHANGE(x_, v_)                                        \
-  atomic_exchange_explicit((x_), (v_), memory_order_acquire)
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_RMW,                                          \
+                atomic_exchange_explicit((x_), (v_), memory_order_acquire))
 #define ATOMIC_ADD(x_, v_)                                                     \
-  atomic_fetch_add_explicit((x_), (v_), memory_order_relaxed)
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_RMW,                                          \
+                atomic_fetch_add_explicit((x_), (v_), memory_order_relaxed))
 #define ATOMIC_SUB(x_, v_)                                                     \
-  atomic_fetch_sub_explicit((x_), (v_), memory_order_relaxed)
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_RMW,                                          \
+                atomic_fetch_sub_explicit((x_), (v_), memory_order_relaxed))
+#define ATOMIC_FENCE()                                                         \
+  ATOMIC_TRACED(NULL, ATOMIC_TRACE_FENCE,                                      \
+                atomic_thread_fence(memory_order_seq_cst))
+#define ATOMIC_COMPARE_EXCHANGE(x_, e_, v_)                                    \
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_RMW,                                          \
+                atomic_compare_exchange_strong_explicit(                       \
+                    x_, e_, v_, memory_order_relaxed, memory_order_relaxed))
+#define ATOMIC_COMPARE_EXCHANGE_ACQUIRE(x_, e_, v_)                            \
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_RMW,                                          \
+                atomic_compare_exchange_strong_explicit(                       \
+                    x_, e_, v_, memory_order_acquire, memory_order_relaxed))
 #define ATOMIC_COMPARE_EXCHANGE_RELEASE(x_, e_, v_)                            \
-  atomic_compare_exchange_strong_explicit(x_, e_, v_, memory_order_release,    \
-                                          memory_order_relaxed)
+  ATOMIC_TRACED(x_, ATOMIC_TRACE_RMW,                                          \
+                atomic_compare_exchange_strong_explicit(                       \
+                    x_, e_, v_, memory_order_release, memory_order_relaxed))
 
 /* Mutex types declaration */
 
@@ -48,6 +105,22 @@ typedef struct { atomic_bool locked; } mutex_test_and_set_t;
 
 typedef struct { atomic_uint new_ticket, now_serving; } mutex_ticket_t;
 
+/* Ticket `t` waits on `grants[t & mask]`, so a release only invalidates the
+ * waiters of one slot. `now_serving` is only touched by the holder. */
+typedef struct {
+  atomic_uint new_ticket, now_serving;
+  padded_auint_t *grants;
+  uint mask;
+} mutex_partitioned_ticket_t;
+
+/* Ticket lock with a waiting array (Dice and Kogan, 2019): only the next
+ * waiter spins on `grant`, the others wait on a slot of a waiting array
+ * shared by all TWA locks and hashed by lock address and ticket */
+#define MUTEX_TWA_SLOTS 4096
+#define MUTEX_TWA_LONG_TERM 1
+
+typedef struct { atomic_uint ticket, grant; } mutex_TWA_t;
+
 typedef struct {
   padded_abool_t *slots;
   atomic_uint next_slot;
@@ -76,6 +149,120 @@ struct QNODE {
 
 typedef struct { _Atomic mutex_MCS_ownership_ptr_t tail; } mutex_MCS_t;
 
+/* Asynchronous MCS waiter: instead of spinning, it is granted the lock by
+ * its predecessor, which calls `callback(arg)`. Its predecessor links it
+ * with `MUTEX_MCS_ASYNC` set in the `next` pointer. */
+#define MUTEX_MCS_ASYNC ((uintptr_t)1)
+
+typedef void (*mutex_MCS_callback_t)(void *arg);
+
+typedef struct MUTEX_MCS_ASYNC_OWNERSHIP {
+  mutex_MCS_ownership_t qnode; /* must stay the first member */
+  mutex_MCS_callback_t callback;
+  void *arg;
+  /* Granted waiters whose callback is still to run on this thread */
+  struct MUTEX_MCS_ASYNC_OWNERSHIP *next_ready;
+} mutex_MCS_async_ownership_t;
+
+/* One passive waiter re-enters the queue every `MALTHUSIAN_FAIRNESS`
+ * handoffs */
+#define MALTHUSIAN_FAIRNESS 256
+
+typedef mutex_MCS_ownership_t mutex_Malthusian_ownership_t;
+
+typedef struct {
+  _Atomic mutex_MCS_ownership_ptr_t tail;
+  /* Culled waiters, only touched by the lock holder */
+  mutex_MCS_ownership_t *passive_head;
+  mutex_MCS_ownership_t *passive_tail;
+  uint handoffs;
+} mutex_Malthusian_t;
+
+/* A shuffling waiter scans at most `MUTEX_SHUFFLE_SCAN` nodes per pass and
+ * lets at most `MUTEX_SHUFFLE_BATCH` waiters of one group jump the queue */
+#define MUTEX_SHUFFLE_SCAN 32
+#define MUTEX_SHUFFLE_BATCH 64
+
+typedef struct {
+  mutex_MCS_ownership_t qnode; /* must stay the first member */
+  uint key;
+  uint batch;
+  atomic_bool shuffler;
+} mutex_shuffle_ownership_t;
+
+/* Whether `waiter` should be moved up into the group of `shuffler` */
+typedef bool (*mutex_shuffle_policy_t)(
+    const mutex_shuffle_ownership_t *shuffler,
+    const mutex_shuffle_ownership_t *waiter);
+
+typedef struct {
+  mutex_MCS_t queue;
+  atomic_bool shuffling;
+  mutex_shuffle_policy_t policy;
+} mutex_shuffle_t;
+
+/* Shared slot pool: the pooled Anderson, GT and CLH locks spin on per-thread
+ * cells and nodes taken from one pool, instead of owning `t_num` padded
+ * slots each. A thread may wait for or hold at most `MUTEX_POOL_DEPTH`
+ * pooled locks at once. */
+#define MUTEX_POOL_DEPTH 8
+#define MUTEX_POOL_NONE UINT32_MAX
+
+typedef struct {
+  atomic_bool locked;
+  void *next_free;
+} mutex_CLH_node_t;
+
+AVOID_FALSE_SHARING(mutex_CLH_node_t, padded_CLH_node_t)
+
+typedef struct {
+  uint free_cells[MUTEX_POOL_DEPTH];
+  uint free_cell_num;
+  padded_CLH_node_t *free_nodes;
+} mutex_pool_thread_t;
+
+AVOID_FALSE_SHARING(mutex_pool_thread_t, padded_pool_thread_t)
+
+typedef struct {
+  padded_auint_t *cells;
+  padded_pool_thread_t *threads;
+  uint thread_num;
+} mutex_pool_t;
+
+/* Entries are `MUTEX_POOL_NONE`, `MUTEX_POOL_GRANTED` or a waiter's cell */
+#define MUTEX_POOL_GRANTED (UINT32_MAX - 1)
+
+typedef struct {
+  mutex_pool_t *pool;
+  atomic_uint *ring;
+  atomic_uint next_slot;
+  uint mask;
+} mutex_Anderson_pooled_t;
+
+typedef struct { uint my_place; } mutex_Anderson_pooled_ownership_t;
+
+typedef struct {
+  uint cell;
+  uint value;
+} mutex_GT_pooled_tail_t;
+
+typedef struct {
+  mutex_pool_t *pool;
+  _Atomic mutex_GT_pooled_tail_t tail;
+} mutex_GT_pooled_t;
+
+typedef struct { uint cell; } mutex_GT_pooled_ownership_t;
+
+typedef struct {
+  mutex_pool_t *pool;
+  _Atomic(padded_CLH_node_t *) tail;
+} mutex_CLH_pooled_t;
+
+typedef struct {
+  padded_CLH_node_t *node;
+  padded_CLH_node_t *predecessor;
+} mutex_CLH_pooled_ownership_t;
+
 typedef struct {
   uint my_id;
   uint watching;
@@ -99,6 +286,16 @@ int mutex_init_ticket(mutex_ticket_t *mutex);
 void mutex_lock_ticket(mutex_ticket_t *mutex);
 void mutex_unlock_ticket(mutex_ticket_t *mutex);
 
+int mutex_init_partitioned_ticket(mutex_partitioned_ticket_t *mutex,
+                                  uint t_num);
+void mutex_destroy_partitioned_ticket(mutex_partitioned_ticket_t *mutex);
+void mutex_lock_partitioned_ticket(mutex_partitioned_ticket_t *mutex);
+void mutex_unlock_partitioned_ticket(mutex_partitioned_ticket_t *mutex);
+
+int mutex_init_TWA(mutex_TWA_t *mutex);
+void mutex_lock_TWA(mutex_TWA_t *mutex);
+void mutex_unlock_TWA(mutex_TWA_t *mutex);
+
 int mutex_init_Anderson(mutex_Anderson_t *mutex, uint t_num);
 void mutex_destroy_Anderson(mutex_Anderson_t *mutex);
 void mutex_lock_Anderson(mutex_Anderson_t *mutex,
@@ -120,6 +317,197 @@ void mutex_destroy_CLH(mutex_CLH_t *mutex);
 void mutex_lock_CLH(mutex_CLH_t *mutex);
 void mutex_unlock_CLH(mutex_CLH_t *mutex);
 
+int mutex_init_Malthusian(mutex_Malthusian_t *mutex);
+void mutex_lock_Malthusian(mutex_Malthusian_t *mutex,
+                           mutex_Malthusian_ownership_t *ownership);
+void mutex_unlock_Malthusian(mutex_Malthusian_t *mutex,
+                             mutex_Malthusian_ownership_t *ownership);
+
+/* `ownership->key` is read by the policy and must be set before locking */
+int mutex_init_shuffle(mutex_shuffle_t *mutex, mutex_shuffle_policy_t policy);
+void mutex_lock_shuffle(mutex_shuffle_t *mutex,
+                        mutex_shuffle_ownership_t *ownership);
+void mutex_unlock_shuffle(mutex_shuffle_t *mutex,
+                          mutex_shuffle_ownership_t *ownership);
+
+bool mutex_shuffle_same_key(const mutex_shuffle_ownership_t *shuffler,
+                            const mutex_shuffle_ownership_t *waiter);
+bool mutex_shuffle_priority(const mutex_shuffle_ownership_t *shuffler,
+                            const mutex_shuffle_ownership_t *waiter);
+
+int mutex_pool_init(mutex_pool_t *pool, uint t_num);
+void mutex_pool_destroy(mutex_pool_t *pool);
+
+int mutex_init_Anderson_pooled(mutex_Anderson_pooled_t *mutex,
+                               mutex_pool_t *pool);
+void mutex_destroy_Anderson_pooled(mutex_Anderson_pooled_t *mutex);
+void mutex_lock_Anderson_pooled(mutex_Anderson_pooled_t *mutex,
+                                mutex_Anderson_pooled_ownership_t *ownership);
+void mutex_unlock_Anderson_pooled(
+    mutex_Anderson_pooled_t *mutex,
+    mutex_Anderson_pooled_ownership_t *ownership);
+
+int mutex_init_GT_pooled(mutex_GT_pooled_t *mutex, mutex_pool_t *pool);
+void mutex_lock_GT_pooled(mutex_GT_pooled_t *mutex,
+                          mutex_GT_pooled_ownership_t *ownership);
+void mutex_unlock_GT_pooled(mutex_GT_pooled_t *mutex,
+                            mutex_GT_pooled_ownership_t *ownership);
+
+int mutex_init_CLH_pooled(mutex_CLH_pooled_t *mutex, mutex_pool_t *pool);
+void mutex_destroy_CLH_pooled(mutex_CLH_pooled_t *mutex);
+void mutex_lock_CLH_pooled(mutex_CLH_pooled_t *mutex,
+                           mutex_CLH_pooled_ownership_t *ownership);
+void mutex_unlock_CLH_pooled(mutex_CLH_pooled_t *mutex,
+                             mutex_CLH_pooled_ownership_t *ownership);
+
+/* Split-phase acquisition: `mutex_enqueue_*` may run on behalf of another
+ * thread, `mutex_wait_*` completes the acquisition on the owning thread. */
+
+uint mutex_enqueue_ticket(mutex_ticket_t *mutex);
+void mutex_wait_ticket(mutex_ticket_t *mutex, uint ticket);
+
+void mutex_enqueue_Anderson(mutex_Anderson_t *mutex,
+                            mutex_Anderson_ownership_t *ownership);
+void mutex_wait_Anderson(mutex_Anderson_t *mutex,
+                         mutex_Anderson_ownership_t *ownership);
+
+mutex_GT_tail_t mutex_enqueue_GT(mutex_GT_t *mutex, uint tid);
+void mutex_wait_GT(mutex_GT_t *mutex, mutex_GT_tail_t last);
+
+bool mutex_enqueue_MCS(mutex_MCS_t *mutex, mutex_MCS_ownership_t *ownership);
+void mutex_wait_MCS(mutex_MCS_t *mutex, mutex_MCS_ownership_t *ownership);
+
+void mutex_enqueue_CLH(mutex_CLH_t *mutex, uint tid);
+void mutex_wait_CLH(mutex_CLH_t *mutex, uint tid);
+
+/* Asynchronous acquisition: returns true if the lock was free and is now
+ * held, without calling `callback`. Otherwise returns false at once, and
+ * `callback(arg)` later runs on the thread releasing the lock to this
+ * waiter, with the lock held on its behalf. The callback should only hand
+ * the continuation over, e.g. to an event loop, which releases the lock
+ * with `mutex_unlock_MCS(mutex, &ownership->qnode)`. Callbacks granted
+ * from within a callback are deferred until it returns, so chains of
+ * handoffs do not grow the stack. */
+bool mutex_lock_async_MCS(mutex_MCS_t *mutex,
+                          mutex_MCS_async_ownership_t *ownership,
+                          mutex_MCS_callback_t callback, void *arg);
+
+/* Condition variable and semaphore types declaration */
+
+typedef struct COND_WAITER {
+  atomic_uint state;
+  struct COND_WAITER *next;
+  struct COND_WAITER *next_morphed;
+  void *ownership;
+  uint tid;
+  uint ticket;
+  mutex_GT_tail_t last;
+} cond_waiter_t;
+
+/* The waiter list is protected by the mutex associated with the condition */
+typedef struct { cond_waiter_t *head, *tail; } cond_t;
+
+typedef struct {
+  atomic_uint count;
+  atomic_uint waiters;
+} semaphore_futex_t;
+
+/* Condition variable and semaphore routines declaration */
+
+/* Signal and broadcast must be called with the mutex held. Except for
+ * `test_and_set`, which has no queue, they move waiters straight onto the
+ * mutex's queue instead of waking them to contend for it. */
+
+int cond_init(cond_t *cond);
+
+void cond_wait_test_and_set(cond_t *cond, mutex_test_and_set_t *mutex);
+void cond_signal_test_and_set(cond_t *cond, mutex_test_and_set_t *mutex);
+void cond_broadcast_test_and_set(cond_t *cond, mutex_test_and_set_t *mutex);
+
+void cond_wait_ticket(cond_t *cond, mutex_ticket_t *mutex);
+void cond_signal_ticket(cond_t *cond, mutex_ticket_t *mutex);
+void cond_broadcast_ticket(cond_t *cond, mutex_ticket_t *mutex);
+
+void cond_wait_Anderson(cond_t *cond, mutex_Anderson_t *mutex,
+                        mutex_Anderson_ownership_t *ownership);
+void cond_signal_Anderson(cond_t *cond, mutex_Anderson_t *mutex);
+void cond_broadcast_Anderson(cond_t *cond, mutex_Anderson_t *mutex);
+
+void cond_wait_GT(cond_t *cond, mutex_GT_t *mutex);
+void cond_signal_GT(cond_t *cond, mutex_GT_t *mutex);
+void cond_broadcast_GT(cond_t *cond, mutex_GT_t *mutex);
+
+void cond_wait_MCS(cond_t *cond, mutex_MCS_t *mutex,
+                   mutex_MCS_ownership_t *ownership);
+void cond_signal_MCS(cond_t *cond, mutex_MCS_t *mutex);
+void cond_broadcast_MCS(cond_t *cond, mutex_MCS_t *mutex);
+
+void cond_wait_CLH(cond_t *cond, mutex_CLH_t *mutex);
+void cond_signal_CLH(cond_t *cond, mutex_CLH_t *mutex);
+void cond_broadcast_CLH(cond_t *cond, mutex_CLH_t *mutex);
+
+int semaphore_init_futex(semaphore_futex_t *semaphore, uint value);
+void semaphore_wait_futex(semaphore_futex_t *semaphore);
+bool semaphore_try_wait_futex(semaphore_futex_t *semaphore);
+void semaphore_post_futex(semaphore_futex_t *semaphore);
+
+/* Sequence lock types declaration */
+
+#define SEQLOCK_OPTIMISTIC_RETRIES 8
+
+typedef void (*seqlock_reader_t)(void *arg);
+
+typedef struct {
+  atomic_uint sequence;
+  mutex_ticket_t writer;
+} seqlock_ticket_t;
+
+/* Lock bit in bit 0, version in the other bits */
+typedef struct { atomic_uint word; } seqlock_versioned_t;
+
+/* Sequence lock routines declaration */
+
+/* Data protected by a sequence lock must be accessed through `ATOMIC_LOAD`
+ * and `ATOMIC_STORE`, since readers race with the writer. */
+
+int seqlock_init_ticket(seqlock_ticket_t *lock);
+uint seqlock_read_begin_ticket(seqlock_ticket_t *lock);
+bool seqlock_read_retry_ticket(seqlock_ticket_t *lock, uint start);
+void seqlock_write_lock_ticket(seqlock_ticket_t *lock);
+void seqlock_write_unlock_ticket(seqlock_ticket_t *lock);
+
+int seqlock_init_versioned(seqlock_versioned_t *lock);
+bool seqlock_read_begin_versioned(seqlock_versioned_t *lock, uint *version);
+bool seqlock_read_validate_versioned(seqlock_versioned_t *lock, uint version);
+uint seqlock_read_lock_versioned(seqlock_versioned_t *lock);
+void seqlock_read_unlock_versioned(seqlock_versioned_t *lock, uint version);
+void seqlock_read_versioned(seqlock_versioned_t *lock, seqlock_reader_t reader,
+                            void *arg);
+void seqlock_write_lock_versioned(seqlock_versioned_t *lock);
+void seqlock_write_unlock_versioned(seqlock_versioned_t *lock);
+
+/* Flag array types declaration */
+
+/* Byte flags polled a whole vector at a time: AVX2 checks the 32 flags of a
+ * vector with one load, with a scalar fallback when CPUID reports no AVX2.
+ * Arrays are made of whole vectors, and flags past the used ones stay
+ * false. */
+#define FLAGS_PER_VECTOR 32
+
+typedef struct {
+  atomic_bool *flags;
+  uint vectors;
+} flag_array_t;
+
+/* Flag array routines declaration */
+
+int flag_array_init(flag_array_t *array, uint size);
+void flag_array_destroy(flag_array_t *array);
+/* Whether any of the `vectors * FLAGS_PER_VECTOR` flags is set. Has acquire
+ * semantics when it returns false. */
+bool flags_any(const atomic_bool *flags, uint vectors);
+bool flags_vectorized();
+
 /* Barrier types declaration */
 
 #define COMBINING_TREE_FAN_IN 4
@@ -207,6 +595,23 @@ typedef struct {
   atomic_bool sense;
 } barrier_arrival_tree_t;
 
+/* Arrival tree whose nodes gather one flag vector of children each */
+#define WIDE_TREE_FAN_IN FLAGS_PER_VECTOR
+
+typedef struct {
+  atomic_bool child_not_ready[WIDE_TREE_FAN_IN];
+  atomic_bool *parent_flag;
+  uint children;
+  bool local_sense;
+} wide_tree_node_t;
+
+AVOID_FALSE_SHARING(wide_tree_node_t, padded_wide_tree_node_t)
+
+typedef struct {
+  padded_wide_tree_node_t *nodes;
+  atomic_bool sense;
+} barrier_wide_tree_t;
+
 int barrier_init_centralized(barrier_centralized_t *barrier, uint t_num);
 void barrier_destroy_centralized(barrier_centralized_t *barrier);
 void barrier_wait_centralized(barrier_centralized_t *barrier);
@@ -231,8 +636,692 @@ int barrier_init_arrival_tree(barrier_arrival_tree_t *barrier, uint t_num);
 void barrier_destroy_arrival_tree(barrier_arrival_tree_t *barrier);
 void barrier_wait_arrival_tree(barrier_arrival_tree_t *barrier);
 
+int barrier_init_wide_tree(barrier_wide_tree_t *barrier, uint t_num);
+void barrier_destroy_wide_tree(barrier_wide_tree_t *barrier);
+void barrier_wait_wide_tree(barrier_wide_tree_t *barrier);
+
+#ifdef BARRIER_FIXED_THREADS
+
+/* Fixed-size barrier types declaration */
+
+/* Dissemination and tournament barriers for exactly `BARRIER_FIXED_THREADS`
+ * threads, set when compiling `barrier_fixed.c` and its users. Every thread
+ * runs its own copy of the wait with the rounds unrolled, and its partners
+ * and roles folded into constants. */
+#if BARRIER_FIXED_THREADS < 1 || BARRIER_FIXED_THREADS > 64
+#error "BARRIER_FIXED_THREADS must be between 1 and 64"
+#endif
+
+#define BARRIER_FIXED_LOG                                                      \
+  ((BARRIER_FIXED_THREADS > 1) + (BARRIER_FIXED_THREADS > 2) +                 \
+   (BARRIER_FIXED_THREADS > 4) + (BARRIER_FIXED_THREADS > 8) +                 \
+   (BARRIER_FIXED_THREADS > 16) + (BARRIER_FIXED_THREADS > 32))
+
+/* One spare round keeps the arrays non-empty for a single thread */
+typedef struct {
+  atomic_bool my_flags[2][BARRIER_FIXED_LOG + 1];
+  uint parity;
+  bool sense;
+} fixed_dissemination_flags_t;
+
+AVOID_FALSE_SHARING(fixed_dissemination_flags_t,
+                    padded_fixed_dissemination_flags_t)
+
+typedef struct {
+  _Alignas(CACHE_LINE_SIZE)
+      padded_fixed_dissemination_flags_t flags[BARRIER_FIXED_THREADS];
+} barrier_fixed_dissemination_t;
+
+typedef struct {
+  atomic_bool my_flags[BARRIER_FIXED_LOG + 1];
+  bool sense;
+} fixed_tournament_flags_t;
+
+AVOID_FALSE_SHARING(fixed_tournament_flags_t, padded_fixed_tournament_flags_t)
+
+typedef struct {
+  _Alignas(CACHE_LINE_SIZE)
+      padded_fixed_tournament_flags_t flags[BARRIER_FIXED_THREADS];
+} barrier_fixed_tournament_t;
+
+/* Fixed-size barrier routines declaration */
+
+int barrier_init_fixed_dissemination(barrier_fixed_dissemination_t *barrier);
+void barrier_wait_fixed_dissemination(barrier_fixed_dissemination_t *barrier);
+
+int barrier_init_fixed_tournament(barrier_fixed_tournament_t *barrier);
+void barrier_wait_fixed_tournament(barrier_fixed_tournament_t *barrier);
+
+#endif
+
+/* Counter types declaration */
+
+#define SNZI_FAN_IN 4
+
+AVOID_FALSE_SHARING(atomic_long, padded_along_t)
+
+typedef struct {
+  padded_along_t *slots;
+  uint thread_num;
+} counter_distributed_t;
+
+typedef struct {
+  padded_along_t *local;
+  uint thread_num;
+  long threshold;
+  atomic_long global;
+} counter_sloppy_t;
+
+/* Leaf state packs a version in the high half and twice the surplus in the
+ * low half, so that the intermediate surplus 1/2 is representable. */
+typedef struct { _Atomic uint64_t state; } indicator_SNZI_node_t;
+
+AVOID_FALSE_SHARING(indicator_SNZI_node_t, padded_SNZI_node_t)
+
+typedef struct {
+  padded_SNZI_node_t *leaves;
+  padded_along_t root;
+} indicator_SNZI_t;
+
+/* Counter routines declaration */
+
+int counter_init_distributed(counter_distributed_t *counter, uint t_num);
+void counter_destroy_distributed(counter_distributed_t *counter);
+void counter_add_distributed(counter_distributed_t *counter, long value);
+long counter_read_distributed(counter_distributed_t *counter);
+
+int counter_init_sloppy(counter_sloppy_t *counter, uint t_num, long threshold);
+void counter_destroy_sloppy(counter_sloppy_t *counter);
+void counter_add_sloppy(counter_sloppy_t *counter, long value);
+void counter_flush_sloppy(counter_sloppy_t *counter);
+long counter_read_sloppy(counter_sloppy_t *counter);
+long counter_read_exact_sloppy(counter_sloppy_t *counter);
+
+int indicator_init_SNZI(indicator_SNZI_t *indicator, uint t_num);
+void indicator_destroy_SNZI(indicator_SNZI_t *indicator);
+void indicator_arrive_SNZI(indicator_SNZI_t *indicator);
+void indicator_depart_SNZI(indicator_SNZI_t *indicator);
+bool indicator_query_SNZI(indicator_SNZI_t *indicator);
+
+/* Memory reclamation types declaration */
+
+#define RECLAIM_HAZARDS 3
+#define RECLAIM_EPOCHS 3
+#define RECLAIM_EPOCH_BATCH 64
+
+typedef void (*reclaim_function_t)(void *node);
+typedef _Atomic(void *) atomic_ptr_t;
+
+typedef struct {
+  atomic_ptr_t hazards[RECLAIM_HAZARDS];
+  void **retired;
+  void **protected;
+  uint retired_num;
+} reclaim_hazard_thread_t;
+
+AVOID_FALSE_SHARING(reclaim_hazard_thread_t, padded_hazard_thread_t)
+
+typedef struct {
+  padded_hazard_thread_t *threads;
+  uint thread_num;
+  reclaim_function_t reclaim;
+} reclaim_hazard_t;
+
+typedef struct {
+  void **nodes;
+  uint num, size, epoch;
+} reclaim_limbo_t;
+
+typedef struct {
+  atomic_uint local_epoch;
+  uint retire_count;
+  reclaim_limbo_t *limbo;
+} reclaim_epoch_thread_t;
+
+AVOID_FALSE_SHARING(reclaim_epoch_thread_t, padded_epoch_thread_t)
+
+typedef struct {
+  padded_auint_t global_epoch;
+  padded_epoch_thread_t *threads;
+  uint thread_num;
+  reclaim_function_t reclaim;
+} reclaim_epoch_t;
+
+/* Memory reclamation routines declaration */
+
+int reclaim_init_hazard(reclaim_hazard_t *domain, uint t_num,
+                        reclaim_function_t reclaim);
+void reclaim_destroy_hazard(reclaim_hazard_t *domain);
+void reclaim_protect_hazard(reclaim_hazard_t *domain, uint i, void *node);
+void reclaim_release_hazard(reclaim_hazard_t *domain);
+void reclaim_retire_hazard(reclaim_hazard_t *domain, void *node);
+void reclaim_flush_hazard(reclaim_hazard_t *domain);
+
+int reclaim_init_epoch(reclaim_epoch_t *domain, uint t_num,
+                       reclaim_function_t reclaim);
+void reclaim_destroy_epoch(reclaim_epoch_t *domain);
+void reclaim_enter_epoch(reclaim_epoch_t *domain);
+void reclaim_exit_epoch(reclaim_epoch_t *domain);
+int reclaim_retire_epoch(reclaim_epoch_t *domain, void *node);
+void reclaim_flush_epoch(reclaim_epoch_t *domain);
+
+/* Queue types declaration */
+
+typedef struct {
+  atomic_uint sequence;
+  void *data;
+} queue_ring_cell_t;
+
+typedef struct {
+  queue_ring_cell_t *cells;
+  uint mask;
+  padded_auint_t enqueue_pos;
+  padded_auint_t dequeue_pos;
+} queue_ring_t;
+
+typedef struct QUEUE_MS_NODE queue_MS_node_t;
+typedef queue_MS_node_t *queue_MS_node_ptr_t;
+typedef _Atomic queue_MS_node_ptr_t atomic_MS_node_ptr_t;
+
+struct QUEUE_MS_NODE {
+  atomic_MS_node_ptr_t next;
+  void *data;
+};
+
+AVOID_FALSE_SHARING(atomic_MS_node_ptr_t, padded_MS_node_ptr_t)
+
+typedef struct {
+  padded_MS_node_ptr_t head;
+  padded_MS_node_ptr_t tail;
+  reclaim_hazard_t hazards;
+} queue_MS_t;
+
+/* Queue routines declaration */
+
+int queue_init_ring(queue_ring_t *queue, uint capacity);
+void queue_destroy_ring(queue_ring_t *queue);
+bool queue_enqueue_ring(queue_ring_t *queue, void *data);
+bool queue_dequeue_ring(queue_ring_t *queue, void **data);
+uint queue_enqueue_batch_ring(queue_ring_t *queue, void *const *data, uint n);
+uint queue_dequeue_batch_ring(queue_ring_t *queue, void **data, uint n);
+
+int queue_init_MS(queue_MS_t *queue, uint t_num);
+void queue_destroy_MS(queue_MS_t *queue);
+bool queue_enqueue_MS(queue_MS_t *queue, void *data);
+bool queue_dequeue_MS(queue_MS_t *queue, void **data);
+uint queue_enqueue_batch_MS(queue_MS_t *queue, void *const *data, uint n);
+uint queue_dequeue_batch_MS(queue_MS_t *queue, void **data, uint n);
+
+/* Thread pool types declaration */
+
+#define POOL_DEQUE_SIZE 1024
+#define POOL_IDLE_SPINS 1024
+
+typedef void (*pool_function_t)(void *arg);
+typedef void (*pool_join_t)(void *barrier);
+typedef void (*pool_body_t)(long begin, long end, void *arg);
+
+typedef struct {
+  pool_function_t function;
+  void *arg;
+  atomic_bool done;
+} pool_task_t;
+
+typedef pool_task_t *pool_task_ptr_t;
+typedef _Atomic pool_task_ptr_t atomic_task_ptr_t;
+
+typedef struct {
+  atomic_long bottom;
+  atomic_task_ptr_t *buffer;
+  uint seed;
+} pool_deque_owner_t;
+
+AVOID_FALSE_SHARING(pool_deque_owner_t, padded_deque_owner_t)
+
+/* Chase-Lev deque: the owner pushes and takes at `bottom`, thieves steal at
+ * `top`. */
+typedef struct {
+  padded_along_t top;
+  padded_deque_owner_t owner;
+} pool_worker_t;
+
+typedef struct {
+  pool_worker_t *workers;
+  pthread_t *threads;
+  uint thread_num;
+  atomic_uint started;
+  atomic_uint region_epoch;
+  atomic_bool stop;
+  pool_function_t region_function;
+  void *region_arg;
+  pool_join_t join;
+  void *barrier;
+  barrier_centralized_t default_barrier;
+} pool_t;
+
+/* Thread pool routines declaration */
+
+int pool_init(pool_t *pool, uint t_num);
+void pool_destroy(pool_t *pool);
+void pool_run(pool_t *pool, pool_function_t function, void *arg,
+              pool_join_t join, void *barrier);
+void pool_spawn(pool_t *pool, pool_task_t *task, pool_function_t function,
+                void *arg);
+void pool_sync(pool_t *pool, pool_task_t *task);
+void pool_parallel_for(pool_t *pool, long begin, long end, long grain,
+                       pool_body_t body, void *arg, pool_join_t join,
+                       void *barrier);
+
+void pool_join_centralized(void *barrier);
+void pool_join_combining_tree(void *barrier);
+void pool_join_dissemination(void *barrier);
+void pool_join_tournament(void *barrier);
+void pool_join_dual_tree(void *barrier);
+void pool_join_arrival_tree(void *barrier);
+
+/* Reader-writer lock types declaration */
+
+/* Visible readers table shared by all BRAVO locks; one slot per cache line */
+#define RWLOCK_BRAVO_TABLE 1024
+/* After a revocation the read bias stays off for this many times the time the
+ * revocation took, bounding the writer slowdown */
+#define RWLOCK_BRAVO_INHIBIT 9
+
+AVOID_FALSE_SHARING(atomic_ptr_t, padded_aptr_t)
+
+typedef void (*rwlock_acquire_t)(void *mutex, void *ownership);
+
+/* Adapts an exclusive lock of `mutex.c`; `ownership` is ignored by the locks
+ * that do not take one. */
+typedef struct {
+  rwlock_acquire_t lock;
+  rwlock_acquire_t unlock;
+} rwlock_mutex_t;
+
+typedef struct {
+  atomic_bool read_bias;
+  atomic_ullong inhibit_until;
+  void *mutex;
+  const rwlock_mutex_t *operations;
+} rwlock_BRAVO_t;
+
+typedef struct {
+  padded_aptr_t *slot;
+  void *ownership;
+} rwlock_BRAVO_token_t;
+
+/* Readers announce themselves in one byte flag per thread, and a writer
+ * holding the underlying lock waits until it polls them all clear. */
+typedef struct {
+  flag_array_t readers;
+  atomic_bool writer;
+  void *mutex;
+  const rwlock_mutex_t *operations;
+} rwlock_flags_t;
+
+/* A writer holding the cohort lock passes it to a waiter of its own node at
+ * most this many times in a row before releasing the global lock */
+#define RWLOCK_NUMA_BATCH 64
+
+typedef struct {
+  mutex_MCS_t local;
+  /* Only touched by the holder of `local` */
+  bool global_held;
+  uint batch;
+} rwlock_NUMA_node_t;
+
+AVOID_FALSE_SHARING(rwlock_NUMA_node_t, padded_NUMA_node_t)
+
+/* One reader counter and one local lock per NUMA node. Thread ids are
+ * mapped to nodes compactly, `threads_per_node` consecutive ids a node. */
+typedef struct {
+  padded_auint_t *readers;
+  padded_NUMA_node_t *nodes;
+  uint node_num, threads_per_node;
+  mutex_ticket_t global;
+  atomic_bool writer;
+  bool writer_preference;
+} rwlock_NUMA_t;
+
+/* Reader-writer lock routines declaration */
+
+extern const rwlock_mutex_t rwlock_mutex_test_and_set;
+extern const rwlock_mutex_t rwlock_mutex_ticket;
+extern const rwlock_mutex_t rwlock_mutex_Anderson;
+extern const rwlock_mutex_t rwlock_mutex_GT;
+extern const rwlock_mutex_t rwlock_mutex_MCS;
+extern const rwlock_mutex_t rwlock_mutex_CLH;
+
+int rwlock_init_BRAVO(rwlock_BRAVO_t *rwlock, void *mutex,
+                      const rwlock_mutex_t *operations);
+/* `token->ownership` must be set when the underlying lock takes one */
+void rwlock_read_lock_BRAVO(rwlock_BRAVO_t *rwlock,
+                            rwlock_BRAVO_token_t *token);
+void rwlock_read_unlock_BRAVO(rwlock_BRAVO_t *rwlock,
+                              rwlock_BRAVO_token_t *token);
+void rwlock_write_lock_BRAVO(rwlock_BRAVO_t *rwlock, void *ownership);
+void rwlock_write_unlock_BRAVO(rwlock_BRAVO_t *rwlock, void *ownership);
+
+int rwlock_init_flags(rwlock_flags_t *rwlock, uint t_num, void *mutex,
+                      const rwlock_mutex_t *operations);
+void rwlock_destroy_flags(rwlock_flags_t *rwlock);
+void rwlock_read_lock_flags(rwlock_flags_t *rwlock);
+void rwlock_read_unlock_flags(rwlock_flags_t *rwlock);
+void rwlock_write_lock_flags(rwlock_flags_t *rwlock, void *ownership);
+void rwlock_write_unlock_flags(rwlock_flags_t *rwlock, void *ownership);
+
+int rwlock_init_NUMA(rwlock_NUMA_t *rwlock, uint t_num, uint nodes,
+                     bool writer_preference);
+void rwlock_destroy_NUMA(rwlock_NUMA_t *rwlock);
+/* Readers only take `ownership` without writer preference */
+void rwlock_read_lock_NUMA(rwlock_NUMA_t *rwlock,
+                           mutex_MCS_ownership_t *ownership);
+void rwlock_read_unlock_NUMA(rwlock_NUMA_t *rwlock);
+void rwlock_write_lock_NUMA(rwlock_NUMA_t *rwlock,
+                            mutex_MCS_ownership_t *ownership);
+void rwlock_write_unlock_NUMA(rwlock_NUMA_t *rwlock,
+                              mutex_MCS_ownership_t *ownership);
+
+/* Per-CPU types declaration */
+
+/* Slots indexed by the CPU a thread runs on, one per configured CPU, and
+ * updated in restartable sequences (rseq): the kernel restarts an update
+ * that was preempted or migrated before its final store, so a slot never
+ * sees two updaters at once and plain loads and stores suffice. */
+typedef struct {
+  padded_along_t *slots;
+  uint cpu_num;
+} counter_percpu_t;
+
+/* A reader may arrive on one CPU and depart on another, so each CPU counts
+ * both; only the sums over all CPUs match */
+typedef struct { atomic_ulong ingress, egress; } rwlock_percpu_readers_t;
+
+AVOID_FALSE_SHARING(rwlock_percpu_readers_t, padded_percpu_readers_t)
+
+typedef struct {
+  padded_percpu_readers_t *readers;
+  uint cpu_num;
+  atomic_bool writer;
+  void *mutex;
+  const rwlock_mutex_t *operations;
+} rwlock_percpu_t;
+
+/* LIFO free list per CPU. A node's first word holds its link. */
+typedef struct {
+  padded_aptr_t *heads;
+  uint cpu_num;
+} list_percpu_t;
+
+/* Per-CPU routines declaration */
+
+/* Whether the calling thread has an rseq area, registering one if the C
+ * library did not. The init routines below fail without it. */
+bool percpu_available();
+uint percpu_cpu_num();
+
+int counter_init_percpu(counter_percpu_t *counter);
+void counter_destroy_percpu(counter_percpu_t *counter);
+void counter_add_percpu(counter_percpu_t *counter, long value);
+long counter_read_percpu(counter_percpu_t *counter);
+
+int rwlock_init_percpu(rwlock_percpu_t *rwlock, void *mutex,
+                       const rwlock_mutex_t *operations);
+void rwlock_destroy_percpu(rwlock_percpu_t *rwlock);
+void rwlock_read_lock_percpu(rwlock_percpu_t *rwlock);
+void rwlock_read_unlock_percpu(rwlock_percpu_t *rwlock);
+void rwlock_write_lock_percpu(rwlock_percpu_t *rwlock, void *ownership);
+void rwlock_write_unlock_percpu(rwlock_percpu_t *rwlock, void *ownership);
+
+int list_init_percpu(list_percpu_t *list);
+/* Passes the nodes still in the lists to `reclaim` unless it is NULL */
+void list_destroy_percpu(list_percpu_t *list, reclaim_function_t reclaim);
+void list_push_percpu(list_percpu_t *list, void *node);
+/* NULL when the list of the current CPU is empty */
+void *list_pop_percpu(list_percpu_t *list);
+
+/* Multi-lock types declaration */
+
+/* Multi-lock acquisitions of one domain enqueue on all their queues under
+ * `enqueue`, so that any two of them are queued in the same order on every
+ * lock they share. A lock may be taken alone as well, but not while holding
+ * another lock of the domain. */
+typedef struct { mutex_ticket_t enqueue; } mutex_multi_t;
+
+/* Multi-lock routines declaration */
+
+/* `mutexes` is sorted by address in place, and `ownerships[i]` goes with
+ * the i-th lock after sorting. A lock listed twice is taken once. */
+void mutex_lock_multi(const rwlock_mutex_t *operations, void **mutexes,
+                      void **ownerships, uint n);
+void mutex_unlock_multi(const rwlock_mutex_t *operations, void **mutexes,
+                        void **ownerships, uint n);
+
+int mutex_init_multi(mutex_multi_t *domain);
+void mutex_lock_multi_MCS(mutex_multi_t *domain, mutex_MCS_t **mutexes,
+                          mutex_MCS_ownership_t *ownerships, uint n);
+void mutex_unlock_multi_MCS(mutex_MCS_t **mutexes,
+                            mutex_MCS_ownership_t *ownerships, uint n);
+void mutex_lock_multi_CLH(mutex_multi_t *domain, mutex_CLH_t **mutexes,
+                          uint n);
+void mutex_unlock_multi_CLH(mutex_CLH_t **mutexes, uint n);
+
+/* Process-shared types declaration */
+
+/* These live in a segment shared by several processes, such as a
+ * `MAP_SHARED` mapping, and work wherever each process maps it: queues link
+ * participants by index instead of by pointer, and the per-participant parts
+ * follow their header inside the `mutex_size_shared_*` bytes reserved by the
+ * caller, at a cache line aligned address. Participants are numbered by a
+ * registry kept in the segment. */
+
+typedef struct {
+  atomic_uint next_id;
+  uint capacity;
+} shared_registry_t;
+
+/* A waiter spins this many times before sleeping on a shared futex */
+#define SHARED_SPIN 1024
+
+typedef struct {
+  atomic_uint next; /* participant index + 1, 0 for none */
+  atomic_uint state;
+} shared_MCS_node_t;
+
+AVOID_FALSE_SHARING(shared_MCS_node_t, padded_shared_MCS_node_t)
+
+typedef struct {
+  atomic_uint tail; /* participant index + 1, 0 for none */
+  uint capacity;
+  _Alignas(CACHE_LINE_SIZE) padded_shared_MCS_node_t nodes[];
+} mutex_shared_MCS_t;
+
+typedef struct {
+  atomic_uint next_slot;
+  uint mask;
+  _Alignas(CACHE_LINE_SIZE) padded_abool_t slots[];
+} mutex_shared_Anderson_t;
+
+/* `capacity + 1` slots follow the states */
+typedef struct {
+  atomic_uint tail;
+  uint capacity;
+  _Alignas(CACHE_LINE_SIZE) padded_CLH_state_t states[];
+} mutex_shared_CLH_t;
+
+typedef struct {
+  atomic_uint count;
+  atomic_uint generation;
+  uint participants;
+} barrier_shared_futex_t;
+
+/* Process-shared routines declaration */
+
+int shared_registry_init(shared_registry_t *registry, uint capacity);
+/* Numbers the calling thread, or returns `LIB_INIT_INVALID` once the
+ * registry is full. A forked child must join on its own. */
+int shared_registry_join(shared_registry_t *registry);
+uint shared_current_id();
+
+size_t mutex_size_shared_MCS(uint capacity);
+int mutex_init_shared_MCS(mutex_shared_MCS_t *mutex, uint capacity);
+void mutex_lock_shared_MCS(mutex_shared_MCS_t *mutex);
+void mutex_unlock_shared_MCS(mutex_shared_MCS_t *mutex);
+
+size_t mutex_size_shared_Anderson(uint capacity);
+int mutex_init_shared_Anderson(mutex_shared_Anderson_t *mutex, uint capacity);
+void mutex_lock_shared_Anderson(mutex_shared_Anderson_t *mutex,
+                                mutex_Anderson_ownership_t *ownership);
+void mutex_unlock_shared_Anderson(mutex_shared_Anderson_t *mutex,
+                                  mutex_Anderson_ownership_t *ownership);
+
+size_t mutex_size_shared_CLH(uint capacity);
+int mutex_init_shared_CLH(mutex_shared_CLH_t *mutex, uint capacity);
+void mutex_lock_shared_CLH(mutex_shared_CLH_t *mutex);
+void mutex_unlock_shared_CLH(mutex_shared_CLH_t *mutex);
+
+int barrier_init_shared_futex(barrier_shared_futex_t *barrier,
+                              uint participants);
+void barrier_wait_shared_futex(barrier_shared_futex_t *barrier);
+
+/* Hash map types declaration */
+
+/* The stripe lock is chosen at compile time: any mutex whose init routine
+ * takes no argument, with `HASHMAP_MUTEX_OWNERSHIP` defined for the ones
+ * that take an ownership record. Objects built with different choices must
+ * not be linked together. */
+#ifndef HASHMAP_MUTEX
+#define HASHMAP_MUTEX ticket
+#endif
+#define HASHMAP_PASTE(a_, b_, c_) a_##b_##c_
+#define HASHMAP_NAME(a_, b_, c_) HASHMAP_PASTE(a_, b_, c_)
+
+/* The table doubles once a stripe averages this many keys per bucket */
+#define HASHMAP_LOAD_FACTOR 2
+/* Buckets a writer migrates on behalf of an ongoing resize */
+#define HASHMAP_MIGRATE_BATCH 4
+
+typedef struct {
+  unsigned long key;
+  atomic_ulong value;
+  atomic_ptr_t next;
+} hashmap_node_t;
+
+typedef struct HASHMAP_TABLE hashmap_table_t;
+typedef hashmap_table_t *hashmap_table_ptr_t;
+
+/* Each bucket header fills a cache line. During a resize `next` is the
+ * table being filled, and migrated buckets of this one are marked moved. */
+struct HASHMAP_TABLE {
+  uint mask;
+  _Atomic hashmap_table_ptr_t next;
+  padded_auint_t claimed;
+  padded_auint_t migrated;
+  padded_aptr_t buckets[];
+};
+
+typedef struct {
+  HASHMAP_NAME(mutex_, HASHMAP_MUTEX, _t) mutex;
+  uint count;
+} hashmap_stripe_t;
+
+AVOID_FALSE_SHARING(hashmap_stripe_t, padded_hashmap_stripe_t)
+
+typedef struct {
+  _Atomic hashmap_table_ptr_t table;
+  padded_hashmap_stripe_t *stripes;
+  uint stripe_mask;
+  reclaim_epoch_t epochs;
+} hashmap_t;
+
+/* Hash map routines declaration */
+
+/* Both counts are rounded up to powers of 2, with at least one bucket per
+ * stripe. Get, put and remove take the calling thread's epoch, so `t_num`
+ * must cover every thread numbered by `thread_init`. */
+int hashmap_init(hashmap_t *map, uint t_num, uint stripes, uint capacity);
+void hashmap_destroy(hashmap_t *map);
+bool hashmap_get(hashmap_t *map, unsigned long key, unsigned long *value);
+/* Returns whether `key` was not in the map yet */
+bool hashmap_put(hashmap_t *map, unsigned long key, unsigned long value);
+bool hashmap_remove(hashmap_t *map, unsigned long key);
+
+/* Skip list types declaration */
+
+/* The node lock is chosen at compile time as for the hash map, with
+ * `SKIPLIST_MUTEX_OWNERSHIP` defined for the locks that take an ownership
+ * record. Objects built with different choices must not be linked
+ * together. */
+#ifndef SKIPLIST_MUTEX
+#define SKIPLIST_MUTEX ticket
+#endif
+#define SKIPLIST_PASTE(a_, b_, c_) a_##b_##c_
+#define SKIPLIST_NAME(a_, b_, c_) SKIPLIST_PASTE(a_, b_, c_)
+
+/* A node is on levels 0 to `top_level`, each one with probability 1/2 of
+ * the one below */
+#define SKIPLIST_MAX_LEVEL 24
+
+typedef struct SKIPLIST_NODE skiplist_node_t;
+typedef skiplist_node_t *skiplist_node_ptr_t;
+
+struct SKIPLIST_NODE {
+  unsigned long key;
+  atomic_ulong value;
+  SKIPLIST_NAME(mutex_, SKIPLIST_MUTEX, _t) lock;
+  uint top_level;
+  /* Logically removed, and linked on all its levels */
+  atomic_bool marked, fully_linked;
+  _Atomic skiplist_node_ptr_t next[];
+};
+
+typedef struct {
+  skiplist_node_t *head;
+  reclaim_epoch_t epochs;
+} skiplist_t;
+
+/* Skip list routines declaration */
+
+/* All routines take the calling thread's epoch, so `t_num` must cover every
+ * thread numbered by `thread_init` */
+int skiplist_init(skiplist_t *list, uint t_num);
+void skiplist_destroy(skiplist_t *list);
+bool skiplist_get(skiplist_t *list, unsigned long key, unsigned long *value);
+/* Returns whether `key` was not in the list yet */
+bool skiplist_put(skiplist_t *list, unsigned long key, unsigned long value);
+bool skiplist_remove(skiplist_t *list, unsigned long key);
+/* Returns how many keys were not in the list yet. Each search starts where
+ * the previous one ended, so ascending keys are the fastest. */
+uint skiplist_put_batch(skiplist_t *list, const unsigned long *keys,
+                        const unsigned long *values, uint n);
+/* Stores up to `max` keys between `low` and `high` included, ascending, with
+ * their values, and returns their number. Each of them was in the list at
+ * some point during the scan, which is not a snapshot. */
+uint skiplist_range(skiplist_t *list, unsigned long low, unsigned long high,
+                    unsigned long *keys, unsigned long *values, uint max);
+
+/* Slab allocator types declaration */
+
+/* Blocks come from `SLAB_SIZE` aligned slabs, each serving one power of two
+ * number of cache lines up to `SLAB_MAX_LINES`; larger blocks get a slab of
+ * their own. Threads numbered `SLAB_THREADS` or beyond always take that
+ * path. */
+#define SLAB_SIZE (64 * 1024)
+#define SLAB_CLASSES 9
+#define SLAB_MAX_LINES (1u << (SLAB_CLASSES - 1))
+#define SLAB_THREADS 256
+
+/* Slab allocator routines declaration */
+
+/* Cache line aligned, NULL when out of memory. A block goes back to the
+ * heap of the thread that allocated it, through a queue if another thread
+ * frees it; two live threads must not share a `thread_current_id`. */
+void *slab_alloc(size_t size);
+void slab_free(void *block);
+
 void thread_init(int thread_num);
 uint thread_total_number();
 uint thread_current_id();
+void thread_set_id(uint id);
 
 #endif
\ No newline at end of file
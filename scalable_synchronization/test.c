@@ -1,10 +1,14 @@
 #include "synchronize.h"
+#include "test_utils.h"
 #include <assert.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/time.h>
+#ifdef FAIRNESS
+#include <sched.h>
+#include <time.h>
+#endif
 
 int max_int_2(int a, int b) { return (a > b) ? a : b; }
 
@@ -21,33 +25,6 @@ void print_atomic_info() {
   printf("Atomic MCS mutex node pointer is %s lock-free.\n", key[lf_MCS_nodep]);
 }
 
-void print_help(const char *argv0) {
-  printf("USAGE:\n\t%s <#threads> <#repetitions>\n", argv0);
-}
-
-typedef struct timeval my_time_t;
-
-void tic(my_time_t *start, pthread_barrier_t *barrier) {
-  pthread_barrier_wait(barrier);
-  if (thread_current_id() == 0) {
-    gettimeofday(start, NULL);
-  }
-}
-
-void toc(my_time_t *start, pthread_barrier_t *barrier, int repetitions,
-         const char *name) {
-  pthread_barrier_wait(barrier);
-  if (thread_current_id() == 0) {
-    my_time_t end;
-    double t;
-    gettimeofday(&end, NULL);
-    t = (double)(end.tv_sec - start->tv_sec) +
-        1e-6 * (double)(end.tv_usec - start->tv_usec);
-    printf("\t\t%s: total %lfs, average %lfus \n", name, t,
-           t / (double)repetitions * 1e9);
-  }
-}
-
 #ifdef TEST_UNSYNC
 /* If `TEST_UNSYNC` is defined, then an assertion failure is expected when
  * running this program */
@@ -122,6 +99,129 @@ void check_shared_for_barrier(int repetitions, int *test_shared) {
 
 #endif
 
+#ifdef FAIRNESS
+/* Fairness mode: threads share a budget of `thread_num * repetitions`
+ * acquisitions instead of each doing `repetitions`, so an unfair lock shows
+ * up as skewed per-thread counts. */
+
+typedef struct {
+  unsigned long acquisitions;
+  double longest_wait;
+  int socket;
+} fairness_thread_t;
+
+AVOID_FALSE_SHARING(fairness_thread_t, padded_fairness_thread_t)
+
+static padded_fairness_thread_t *fairness;
+/* Only accessed while holding the lock under test */
+static unsigned long fairness_total, same_thread, same_socket;
+static int last_owner = -1;
+
+static double fairness_now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+}
+
+static int current_socket() {
+  char path[96];
+  int socket = 0;
+  FILE *file;
+  sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/physical_package_id",
+          sched_getcpu());
+  file = fopen(path, "r");
+  if (file != NULL) {
+    if (fscanf(file, "%d", &socket) != 1) {
+      socket = 0;
+    }
+    fclose(file);
+  }
+  return socket;
+}
+
+/* Called with the lock held; returns false once the budget is spent */
+static bool fairness_acquired(double start, unsigned long budget) {
+  uint tid = thread_current_id();
+  fairness_thread_t *self = &fairness[tid].value;
+  double wait = fairness_now() - start;
+  if (fairness_total == budget) {
+    return false;
+  }
+  ++fairness_total;
+  ++self->acquisitions;
+  if (wait > self->longest_wait) {
+    self->longest_wait = wait;
+  }
+  if (last_owner >= 0) {
+    same_thread += (last_owner == (int)tid);
+    same_socket += (fairness[last_owner].value.socket == self->socket);
+  }
+  last_owner = tid;
+  return true;
+}
+
+static void fairness_report(pthread_barrier_t *barrier) {
+  pthread_barrier_wait(barrier);
+  if (thread_current_id() == 0) {
+    uint i, n = thread_total_number();
+    unsigned long min = fairness[0].value.acquisitions, max = min;
+    double sum = 0.0, square_sum = 0.0, longest_wait = 0.0;
+    for (i = 0; i < n; ++i) {
+      fairness_thread_t *thread = &fairness[i].value;
+      double x = (double)thread->acquisitions;
+      sum += x;
+      square_sum += x * x;
+      min = (thread->acquisitions < min) ? thread->acquisitions : min;
+      max = (thread->acquisitions > max) ? thread->acquisitions : max;
+      if (thread->longest_wait > longest_wait) {
+        longest_wait = thread->longest_wait;
+      }
+      thread->acquisitions = 0;
+      thread->longest_wait = 0.0;
+    }
+    printf("\t\t\tJain index %lf, max/min ", sum * sum / (n * square_sum));
+    if (min > 0) {
+      printf("%lf", (double)max / min);
+    } else {
+      printf("inf");
+    }
+    printf(", longest wait %lfus, same thread %.1f%%, same socket %.1f%%\n",
+           longest_wait * 1e6, 100.0 * same_thread / (sum - 1),
+           100.0 * same_socket / (sum - 1));
+    fairness_total = same_thread = same_socket = 0;
+    last_owner = -1;
+  }
+  pthread_barrier_wait(barrier);
+}
+
+#define CREATE_FAIRNESS_TESTER(type, own_decl, ...)                            \
+  void test_mutex_##type(mutex_##type##_t *mutex, pthread_barrier_t *barrier,  \
+                         int repetitions, int *test_shared) {                  \
+    my_time_t t;                                                               \
+    unsigned long budget =                                                     \
+        (unsigned long)thread_total_number() * repetitions;                    \
+    bool more = true;                                                          \
+    own_decl;                                                                  \
+    fairness[thread_current_id()].value.socket = current_socket();             \
+    tic(&t, barrier);                                                          \
+    while (more) {                                                             \
+      double start = fairness_now();                                           \
+      mutex_lock(type, __VA_ARGS__);                                           \
+      more = fairness_acquired(start, budget);                                 \
+      if (more) {                                                              \
+        CRITICAL_SECTION(test_shared)                                          \
+      }                                                                        \
+      mutex_unlock(type, __VA_ARGS__);                                         \
+    }                                                                          \
+    toc(&t, barrier, repetitions, #type);                                      \
+    fairness_report(barrier);                                                  \
+  }
+
+#define CREATE_MUTEX_TESTER_1(type) CREATE_FAIRNESS_TESTER(type, , mutex)
+#define CREATE_MUTEX_TESTER_2(type)                                            \
+  CREATE_FAIRNESS_TESTER(type, mutex_##type##_ownership_t ownership, mutex,    \
+                         &ownership)
+#else
 #define CREATE_MUTEX_TESTER_1(type)                                            \
   \
 void test_mutex_##type(mutex_##type##_t *mutex, pthread_barrier_t *barrier,    \
@@ -157,12 +257,17 @@ void test_mutex_##type(mutex_##type##_t *mutex, pthread_barrier_t *barrier,    \
   \
 }
 
+#endif
+
 CREATE_MUTEX_TESTER_1(test_and_set)
 CREATE_MUTEX_TESTER_1(ticket)
+CREATE_MUTEX_TESTER_1(partitioned_ticket)
+CREATE_MUTEX_TESTER_1(TWA)
 CREATE_MUTEX_TESTER_2(Anderson)
 CREATE_MUTEX_TESTER_1(GT)
 CREATE_MUTEX_TESTER_2(MCS)
 CREATE_MUTEX_TESTER_1(CLH)
+CREATE_MUTEX_TESTER_2(Malthusian)
 CREATE_MUTEX_TESTER_1(pthread)
 
 #define CREATE_BARRIER_TESTER(type)                                            \
@@ -187,6 +292,7 @@ CREATE_BARRIER_TESTER(dissemination)
 CREATE_BARRIER_TESTER(tournament)
 CREATE_BARRIER_TESTER(dual_tree)
 CREATE_BARRIER_TESTER(arrival_tree)
+CREATE_BARRIER_TESTER(wide_tree)
 CREATE_BARRIER_TESTER(pthread)
 
 typedef struct {
@@ -195,10 +301,13 @@ typedef struct {
   int test_shared[4];
   mutex_test_and_set_t mutex_test_and_set;
   mutex_ticket_t mutex_ticket;
+  mutex_partitioned_ticket_t mutex_partitioned_ticket;
+  mutex_TWA_t mutex_TWA;
   mutex_Anderson_t mutex_Anderson;
   mutex_GT_t mutex_GT;
   mutex_MCS_t mutex_MCS;
   mutex_CLH_t mutex_CLH;
+  mutex_Malthusian_t mutex_Malthusian;
   pthread_mutex_t mutex_pthread;
   barrier_centralized_t barrier_centralized;
   barrier_combining_tree_t barrier_combining_tree;
@@ -206,6 +315,7 @@ typedef struct {
   barrier_tournament_t barrier_tournament;
   barrier_dual_tree_t barrier_dual_tree;
   barrier_arrival_tree_t barrier_arrival_tree;
+  barrier_wide_tree_t barrier_wide_tree;
   pthread_barrier_t barrier_pthread;
   pthread_barrier_t barrier_aux;
 } pthread_subroutine_args_t;
@@ -223,6 +333,13 @@ void *pthread_subroutine(void *args) {
   test_mutex_ticket(&obj->mutex_ticket, &obj->barrier_aux, obj->repetitions,
                     obj->test_shared);
   check_shared_for_mutex(obj->repetitions, obj->test_shared);
+  test_mutex_partitioned_ticket(&obj->mutex_partitioned_ticket,
+                                &obj->barrier_aux, obj->repetitions,
+                                obj->test_shared);
+  check_shared_for_mutex(obj->repetitions, obj->test_shared);
+  test_mutex_TWA(&obj->mutex_TWA, &obj->barrier_aux, obj->repetitions,
+                 obj->test_shared);
+  check_shared_for_mutex(obj->repetitions, obj->test_shared);
   test_mutex_Anderson(&obj->mutex_Anderson, &obj->barrier_aux, obj->repetitions,
                       obj->test_shared);
   check_shared_for_mutex(obj->repetitions, obj->test_shared);
@@ -235,15 +352,21 @@ void *pthread_subroutine(void *args) {
   test_mutex_CLH(&obj->mutex_CLH, &obj->barrier_aux, obj->repetitions,
                  obj->test_shared);
   check_shared_for_mutex(obj->repetitions, obj->test_shared);
+  test_mutex_Malthusian(&obj->mutex_Malthusian, &obj->barrier_aux,
+                        obj->repetitions, obj->test_shared);
+  check_shared_for_mutex(obj->repetitions, obj->test_shared);
 #ifdef TEST_PTHREAD
   test_mutex_pthread(&obj->mutex_pthread, &obj->barrier_aux, obj->repetitions,
                      obj->test_shared);
   check_shared_for_mutex(obj->repetitions, obj->test_shared);
 #endif
 
+#ifndef FAIRNESS
   if (thread_current_id() == 0) {
-    memset(obj->test_shared, 0, sizeof(int) * obj->thread_num);
+    memset(obj->test_shared, 0, sizeof(int) * 4);
     puts("\tTesting barriers...");
+    printf("\t\twide tree flags polled with %s\n",
+           flags_vectorized() ? "AVX2" : "scalar loads");
   }
   test_barrier_centralized(&obj->barrier_centralized, &obj->barrier_aux,
                            obj->repetitions, obj->test_shared);
@@ -263,38 +386,18 @@ void *pthread_subroutine(void *args) {
   test_barrier_arrival_tree(&obj->barrier_arrival_tree, &obj->barrier_aux,
                             obj->repetitions, obj->test_shared);
   check_shared_for_barrier(obj->repetitions, obj->test_shared);
+  test_barrier_wide_tree(&obj->barrier_wide_tree, &obj->barrier_aux,
+                         obj->repetitions, obj->test_shared);
+  check_shared_for_barrier(obj->repetitions, obj->test_shared);
 #ifdef TEST_PTHREAD
   test_barrier_pthread(&obj->barrier_pthread, &obj->barrier_aux,
                        obj->test_shared);
   check_shared_for_barrier(obj->repetitions, obj->test_shared);
+#endif
 #endif
   return NULL;
 }
 
-int parallel_execute(void *(*routine)(void *), void *args, int thread_num) {
-  int created_tnum = 0;
-  int i;
-  pthread_t *threads =
-      (pthread_t *)malloc(sizeof(pthread_t) * (thread_num - 1));
-  if (threads == NULL) {
-    return -1;
-  }
-
-  for (i = 0; i < thread_num - 1; ++i) {
-    if (pthread_create(&threads[i], NULL, routine, args) != 0) {
-      break;
-    }
-  }
-  created_tnum = i;
-  routine(args);
-  for (i = 0; i < created_tnum; ++i) {
-    pthread_join(threads[i], NULL);
-  }
-
-  free(threads);
-  return (thread_num - 1 == created_tnum) ? 0 : -2;
-}
-
 int main(int argc, char **argv) {
   int i;
   pthread_subroutine_args_t obj;
@@ -317,18 +420,28 @@ int main(int argc, char **argv) {
       barrier_init_tournament(&obj.barrier_tournament, t_num);
       barrier_init_dual_tree(&obj.barrier_dual_tree, t_num);
       barrier_init_arrival_tree(&obj.barrier_arrival_tree, t_num);
+      barrier_init_wide_tree(&obj.barrier_wide_tree, t_num);
       mutex_init_ticket(&obj.mutex_ticket);
       pthread_mutex_init(&obj.mutex_pthread, NULL);
       mutex_init_test_and_set(&obj.mutex_test_and_set);
       mutex_init_ticket(&obj.mutex_ticket);
+      mutex_init_partitioned_ticket(&obj.mutex_partitioned_ticket, t_num);
+      mutex_init_TWA(&obj.mutex_TWA);
       mutex_init_Anderson(&obj.mutex_Anderson, t_num);
       mutex_init_GT(&obj.mutex_GT, t_num);
       mutex_init_MCS(&obj.mutex_MCS);
       mutex_init_CLH(&obj.mutex_CLH, t_num);
+      mutex_init_Malthusian(&obj.mutex_Malthusian);
+#ifdef FAIRNESS
+      fairness = (padded_fairness_thread_t *)calloc(
+          t_num, sizeof(padded_fairness_thread_t));
+      assert(fairness != NULL);
+#endif
 
       retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
 
       mutex_destroy_CLH(&obj.mutex_CLH);
+      mutex_destroy_partitioned_ticket(&obj.mutex_partitioned_ticket);
       mutex_destroy_Anderson(&obj.mutex_Anderson);
       mutex_destroy_GT(&obj.mutex_GT);
       pthread_mutex_destroy(&obj.mutex_pthread);
@@ -338,8 +451,12 @@ int main(int argc, char **argv) {
       barrier_destroy_tournament(&obj.barrier_tournament);
       barrier_destroy_dual_tree(&obj.barrier_dual_tree);
       barrier_destroy_arrival_tree(&obj.barrier_arrival_tree);
+      barrier_destroy_wide_tree(&obj.barrier_wide_tree);
       pthread_barrier_destroy(&obj.barrier_pthread);
       pthread_barrier_destroy(&obj.barrier_aux);
+#ifdef FAIRNESS
+      free(fairness);
+#endif
       return retval;
     } else {
       print_help(argv[0]);
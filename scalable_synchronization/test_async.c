@@ -0,0 +1,143 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Every thread runs an event loop around one MCS lock. Asynchronous
+ * acquisitions post their continuation to the loop's inbox, and the loop
+ * keeps counting other events until it arrives. In the mixed test, even
+ * threads acquire the same lock synchronously. */
+
+typedef struct {
+  queue_ring_t inbox;
+  mutex_MCS_async_ownership_t ownership;
+  unsigned long other_events;
+} event_loop_t;
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  int test_shared[2];
+  event_loop_t *loops;
+  mutex_MCS_t mutex_MCS;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static void critical_section(pthread_subroutine_args_t *obj) {
+  ++obj->test_shared[1];
+  assert(obj->test_shared[1] == 1);
+  ++obj->test_shared[0];
+  --obj->test_shared[1];
+}
+
+static void post(void *arg) {
+  event_loop_t *loop = (event_loop_t *)arg;
+  bool posted = queue_enqueue_ring(&loop->inbox, &loop->ownership);
+  assert(posted);
+}
+
+static void run_async(pthread_subroutine_args_t *obj, event_loop_t *loop) {
+  if (!mutex_lock_async_MCS(&obj->mutex_MCS, &loop->ownership, post, loop)) {
+    void *ready;
+    while (!queue_dequeue_ring(&loop->inbox, &ready)) {
+      ++loop->other_events;
+      delay(0);
+    }
+    assert(ready == &loop->ownership);
+  }
+  critical_section(obj);
+  mutex_unlock_MCS(&obj->mutex_MCS, &loop->ownership.qnode);
+}
+
+static void run_sync(pthread_subroutine_args_t *obj, event_loop_t *loop) {
+  mutex_lock_MCS(&obj->mutex_MCS, &loop->ownership.qnode);
+  critical_section(obj);
+  mutex_unlock_MCS(&obj->mutex_MCS, &loop->ownership.qnode);
+}
+
+static void report(pthread_subroutine_args_t *obj, int async_threads) {
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    int i;
+    unsigned long other_events = 0;
+    assert(obj->test_shared[0] == obj->thread_num * obj->repetitions);
+    for (i = 0; i < obj->thread_num; ++i) {
+      other_events += obj->loops[i].other_events;
+      obj->loops[i].other_events = 0;
+    }
+    printf("\t\t\tother events per asynchronous acquisition %.2lf\n",
+           (async_threads > 0)
+               ? (double)other_events / async_threads / obj->repetitions
+               : 0.0);
+    obj->test_shared[0] = 0;
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+}
+
+static void test_async(pthread_subroutine_args_t *obj, bool mixed) {
+  my_time_t t;
+  int i;
+  uint tid = thread_current_id();
+  event_loop_t *loop = &obj->loops[tid];
+  bool async = !mixed || tid % 2 == 1;
+  tic(&t, &obj->barrier_aux);
+  for (i = 0; i < obj->repetitions; ++i) {
+    if (async) {
+      run_async(obj, loop);
+    } else {
+      run_sync(obj, loop);
+    }
+  }
+  toc(&t, &obj->barrier_aux, obj->repetitions,
+      mixed ? "MCS_async_mixed" : "MCS_async");
+  report(obj, mixed ? obj->thread_num / 2 : obj->thread_num);
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  test_async(obj, false);
+  test_async(obj, true);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int i, retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      obj.loops = (event_loop_t *)calloc(t_num, sizeof(event_loop_t));
+      assert(obj.loops != NULL);
+      for (i = 0; i < t_num; ++i) {
+        queue_init_ring(&obj.loops[i].inbox, 2);
+      }
+      obj.test_shared[0] = obj.test_shared[1] = 0;
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      mutex_init_MCS(&obj.mutex_MCS);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      pthread_barrier_destroy(&obj.barrier_aux);
+      for (i = 0; i < t_num; ++i) {
+        queue_destroy_ring(&obj.loops[i].inbox);
+      }
+      free(obj.loops);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
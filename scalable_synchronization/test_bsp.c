@@ -0,0 +1,485 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Bulk-synchronous kernels between barrier episodes: a Jacobi stencil over
+ * a size x size grid, an inclusive prefix sum over size^2 numbers and a
+ * level-synchronous BFS over a size x size grid graph with one random
+ * shortcut per vertex. Every thread times its barrier waits, and the
+ * results are checked against a sequential run. */
+
+#define DEFAULT_SIZE 256
+#define UNVISITED UINT_MAX
+
+typedef struct {
+  double wait;
+  double total;
+} bsp_stats_t;
+
+AVOID_FALSE_SHARING(bsp_stats_t, padded_bsp_stats_t)
+AVOID_FALSE_SHARING(long, padded_long_t)
+
+typedef void (*bsp_wait_t)(void *barrier);
+
+typedef struct {
+  const char *name;
+  void *barrier;
+  bsp_wait_t wait;
+} bsp_barrier_t;
+
+typedef struct BSP_ARGS pthread_subroutine_args_t;
+
+typedef void (*bsp_kernel_t)(pthread_subroutine_args_t *obj,
+                             const bsp_barrier_t *barrier, uint tid);
+
+typedef struct {
+  const char *name;
+  bsp_kernel_t run;
+  void (*check)(pthread_subroutine_args_t *obj);
+} bsp_kernel_entry_t;
+
+#define BARRIERS 8
+
+struct BSP_ARGS {
+  int thread_num;
+  int iterations;
+  uint size;
+  const char *kernel;
+  const char *barrier;
+  padded_bsp_stats_t *stats;
+  /* Jacobi */
+  double *grid[2];
+  double *grid_expected;
+  /* Prefix sum */
+  long *input, *output, *output_expected;
+  padded_long_t *chunk_sums;
+  /* BFS */
+  uint *offsets, *edges;
+  atomic_uint *levels;
+  uint *levels_expected;
+  atomic_bool changed[3];
+  bsp_barrier_t barriers[BARRIERS];
+  barrier_centralized_t barrier_centralized;
+  barrier_combining_tree_t barrier_combining_tree;
+  barrier_dissemination_t barrier_dissemination;
+  barrier_tournament_t barrier_tournament;
+  barrier_dual_tree_t barrier_dual_tree;
+  barrier_arrival_tree_t barrier_arrival_tree;
+  barrier_wide_tree_t barrier_wide_tree;
+  pthread_barrier_t barrier_pthread;
+  pthread_barrier_t barrier_aux;
+};
+
+#define CREATE_BSP_WAIT(type)                                                  \
+  static void bsp_wait_##type(void *barrier) {                                 \
+    barrier_wait_##type((barrier_##type##_t *)barrier);                        \
+  }
+
+CREATE_BSP_WAIT(centralized)
+CREATE_BSP_WAIT(combining_tree)
+CREATE_BSP_WAIT(dissemination)
+CREATE_BSP_WAIT(tournament)
+CREATE_BSP_WAIT(dual_tree)
+CREATE_BSP_WAIT(arrival_tree)
+CREATE_BSP_WAIT(wide_tree)
+
+static void bsp_wait_pthread(void *barrier) {
+  pthread_barrier_wait((pthread_barrier_t *)barrier);
+}
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+}
+
+static void timed_wait(pthread_subroutine_args_t *obj,
+                       const bsp_barrier_t *barrier, uint tid) {
+  double start = now();
+  barrier->wait(barrier->barrier);
+  obj->stats[tid].value.wait += now() - start;
+}
+
+/* The share [lo, hi) of `n` items that thread `tid` works on */
+static void partition(pthread_subroutine_args_t *obj, uint n, uint tid,
+                      uint *lo, uint *hi) {
+  *lo = (uint)((unsigned long)n * tid / obj->thread_num);
+  *hi = (uint)((unsigned long)n * (tid + 1) / obj->thread_num);
+}
+
+/* Jacobi: the top row is held at 1, the other borders at 0 */
+
+static void jacobi_reset(double *grid, uint size) {
+  uint i;
+  memset(grid, 0, sizeof(double) * size * size);
+  for (i = 0; i < size; ++i) {
+    grid[i] = 1.0;
+  }
+}
+
+static void jacobi_rows(const double *src, double *dst, uint size, uint lo,
+                        uint hi) {
+  uint i, j;
+  for (i = lo; i < hi; ++i) {
+    for (j = 1; j + 1 < size; ++j) {
+      dst[i * size + j] =
+          0.25 * (src[(i - 1) * size + j] + src[(i + 1) * size + j] +
+                  src[i * size + j - 1] + src[i * size + j + 1]);
+    }
+  }
+}
+
+static void jacobi_expected(pthread_subroutine_args_t *obj) {
+  uint size = obj->size;
+  int it;
+  double *scratch = (double *)malloc(sizeof(double) * size * size);
+  assert(scratch != NULL);
+  jacobi_reset(obj->grid_expected, size);
+  jacobi_reset(scratch, size);
+  for (it = 0; it < obj->iterations; ++it) {
+    if (it % 2 == 0) {
+      jacobi_rows(obj->grid_expected, scratch, size, 1, size - 1);
+    } else {
+      jacobi_rows(scratch, obj->grid_expected, size, 1, size - 1);
+    }
+  }
+  if (obj->iterations % 2 == 1) {
+    memcpy(obj->grid_expected, scratch, sizeof(double) * size * size);
+  }
+  free(scratch);
+}
+
+static void run_jacobi(pthread_subroutine_args_t *obj,
+                       const bsp_barrier_t *barrier, uint tid) {
+  uint lo, hi;
+  int it;
+  partition(obj, obj->size - 2, tid, &lo, &hi);
+  for (it = 0; it < obj->iterations; ++it) {
+    jacobi_rows(obj->grid[it % 2], obj->grid[(it + 1) % 2], obj->size,
+                lo + 1, hi + 1);
+    timed_wait(obj, barrier, tid);
+  }
+}
+
+static void check_jacobi(pthread_subroutine_args_t *obj) {
+  assert(memcmp(obj->grid[obj->iterations % 2], obj->grid_expected,
+                sizeof(double) * obj->size * obj->size) == 0);
+  jacobi_reset(obj->grid[0], obj->size);
+  jacobi_reset(obj->grid[1], obj->size);
+}
+
+/* Prefix sum: each thread scans its chunk, then adds the sums of the
+ * chunks before it */
+
+static void run_prefix_sum(pthread_subroutine_args_t *obj,
+                           const bsp_barrier_t *barrier, uint tid) {
+  uint i, lo, hi;
+  int it;
+  partition(obj, obj->size * obj->size, tid, &lo, &hi);
+  for (it = 0; it < obj->iterations; ++it) {
+    long sum = 0, offset = 0;
+    for (i = lo; i < hi; ++i) {
+      sum += obj->input[i];
+      obj->output[i] = sum;
+    }
+    obj->chunk_sums[tid].value = sum;
+    timed_wait(obj, barrier, tid);
+    for (i = 0; i < tid; ++i) {
+      offset += obj->chunk_sums[i].value;
+    }
+    for (i = lo; i < hi; ++i) {
+      obj->output[i] += offset;
+    }
+    timed_wait(obj, barrier, tid);
+  }
+}
+
+static void check_prefix_sum(pthread_subroutine_args_t *obj) {
+  assert(memcmp(obj->output, obj->output_expected,
+                sizeof(long) * obj->size * obj->size) == 0);
+}
+
+/* BFS from vertex 0. `changed[level % 3]` tells whether `level` found new
+ * vertices; thread 0 clears the flag of the next level before the barrier
+ * that ends this one, when nobody reads or writes it. */
+
+static void run_bfs(pthread_subroutine_args_t *obj,
+                    const bsp_barrier_t *barrier, uint tid) {
+  uint v, e, lo, hi, level;
+  int it;
+  partition(obj, obj->size * obj->size, tid, &lo, &hi);
+  for (it = 0; it < obj->iterations; ++it) {
+    for (v = lo; v < hi; ++v) {
+      ATOMIC_STORE(&obj->levels[v], UNVISITED);
+    }
+    if (tid == 0) {
+      ATOMIC_STORE(&obj->levels[0], 0);
+      ATOMIC_STORE(&obj->changed[0], false);
+    }
+    timed_wait(obj, barrier, tid);
+    for (level = 0;; ++level) {
+      bool found = false;
+      if (tid == 0) {
+        ATOMIC_STORE(&obj->changed[(level + 1) % 3], false);
+      }
+      for (v = lo; v < hi; ++v) {
+        if (ATOMIC_LOAD(&obj->levels[v]) != level) {
+          continue;
+        }
+        for (e = obj->offsets[v]; e < obj->offsets[v + 1]; ++e) {
+          uint expected = UNVISITED;
+          found |= ATOMIC_COMPARE_EXCHANGE(&obj->levels[obj->edges[e]],
+                                           &expected, level + 1);
+        }
+      }
+      if (found) {
+        ATOMIC_STORE(&obj->changed[level % 3], true);
+      }
+      timed_wait(obj, barrier, tid);
+      if (!ATOMIC_LOAD(&obj->changed[level % 3])) {
+        break;
+      }
+    }
+  }
+}
+
+static void check_bfs(pthread_subroutine_args_t *obj) {
+  uint v;
+  for (v = 0; v < obj->size * obj->size; ++v) {
+    assert(ATOMIC_LOAD(&obj->levels[v]) == obj->levels_expected[v]);
+  }
+}
+
+static const bsp_kernel_entry_t kernels[] = {
+    {"jacobi", run_jacobi, check_jacobi},
+    {"prefix_sum", run_prefix_sum, check_prefix_sum},
+    {"bfs", run_bfs, check_bfs},
+};
+
+#define KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+static void report(pthread_subroutine_args_t *obj, const char *name) {
+  int i;
+  double total = 0.0, wait = 0.0;
+  for (i = 0; i < obj->thread_num; ++i) {
+    total += obj->stats[i].value.total;
+    wait += obj->stats[i].value.wait;
+    obj->stats[i].value.total = obj->stats[i].value.wait = 0.0;
+  }
+  printf("\t\t%s: %lfus per iteration, %.1lf%% of the time at barriers\n",
+         name, total / obj->thread_num / obj->iterations * 1e6,
+         (total > 0.0) ? 100.0 * wait / total : 0.0);
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  uint k, b, tid;
+  thread_init(obj->thread_num);
+  tid = thread_current_id();
+  for (k = 0; k < KERNELS; ++k) {
+    if (obj->kernel != NULL && strcmp(obj->kernel, kernels[k].name) != 0) {
+      continue;
+    }
+    if (tid == 0) {
+      printf("\tRunning %s...\n", kernels[k].name);
+    }
+    for (b = 0; b < BARRIERS; ++b) {
+      const bsp_barrier_t *barrier = &obj->barriers[b];
+      double start;
+      if (obj->barrier != NULL && strcmp(obj->barrier, barrier->name) != 0) {
+        continue;
+      }
+      pthread_barrier_wait(&obj->barrier_aux);
+      start = now();
+      kernels[k].run(obj, barrier, tid);
+      obj->stats[tid].value.total = now() - start;
+      pthread_barrier_wait(&obj->barrier_aux);
+      if (tid == 0) {
+        kernels[k].check(obj);
+        report(obj, barrier->name);
+      }
+    }
+  }
+  return NULL;
+}
+
+static void init_workloads(pthread_subroutine_args_t *obj) {
+  uint size = obj->size, n = size * size, v, e, level, head, tail;
+  uint64_t seed = 88172645463325252ull;
+  uint *queue;
+  long sum = 0;
+
+  obj->grid[0] = (double *)malloc(sizeof(double) * n);
+  obj->grid[1] = (double *)malloc(sizeof(double) * n);
+  obj->grid_expected = (double *)malloc(sizeof(double) * n);
+  obj->input = (long *)malloc(sizeof(long) * n);
+  obj->output = (long *)malloc(sizeof(long) * n);
+  obj->output_expected = (long *)malloc(sizeof(long) * n);
+  obj->chunk_sums =
+      (padded_long_t *)malloc(sizeof(padded_long_t) * obj->thread_num);
+  obj->offsets = (uint *)malloc(sizeof(uint) * (n + 1));
+  obj->edges = (uint *)malloc(sizeof(uint) * 5 * n);
+  obj->levels = (atomic_uint *)malloc(sizeof(atomic_uint) * n);
+  obj->levels_expected = (uint *)malloc(sizeof(uint) * n);
+  queue = (uint *)malloc(sizeof(uint) * n);
+  assert(obj->grid[0] != NULL && obj->grid[1] != NULL &&
+         obj->grid_expected != NULL && obj->input != NULL &&
+         obj->output != NULL && obj->output_expected != NULL &&
+         obj->chunk_sums != NULL && obj->offsets != NULL &&
+         obj->edges != NULL && obj->levels != NULL &&
+         obj->levels_expected != NULL && queue != NULL);
+
+  jacobi_reset(obj->grid[0], size);
+  jacobi_reset(obj->grid[1], size);
+  jacobi_expected(obj);
+
+  for (v = 0; v < n; ++v) {
+    obj->input[v] = (long)(next_random(&seed) % 1000);
+    sum += obj->input[v];
+    obj->output_expected[v] = sum;
+  }
+
+  for (v = 0, e = 0; v < n; ++v) {
+    uint row = v / size, column = v % size;
+    obj->offsets[v] = e;
+    if (row > 0) {
+      obj->edges[e++] = v - size;
+    }
+    if (row + 1 < size) {
+      obj->edges[e++] = v + size;
+    }
+    if (column > 0) {
+      obj->edges[e++] = v - 1;
+    }
+    if (column + 1 < size) {
+      obj->edges[e++] = v + 1;
+    }
+    obj->edges[e++] = (uint)(next_random(&seed) % n);
+    atomic_init(&obj->levels[v], UNVISITED);
+    obj->levels_expected[v] = UNVISITED;
+  }
+  obj->offsets[n] = e;
+  for (level = 0; level < 3; ++level) {
+    atomic_init(&obj->changed[level], false);
+  }
+
+  obj->levels_expected[0] = 0;
+  queue[0] = 0;
+  for (head = 0, tail = 1; head < tail; ++head) {
+    v = queue[head];
+    for (e = obj->offsets[v]; e < obj->offsets[v + 1]; ++e) {
+      uint w = obj->edges[e];
+      if (obj->levels_expected[w] == UNVISITED) {
+        obj->levels_expected[w] = obj->levels_expected[v] + 1;
+        queue[tail++] = w;
+      }
+    }
+  }
+  free(queue);
+}
+
+static void destroy_workloads(pthread_subroutine_args_t *obj) {
+  free(obj->grid[0]);
+  free(obj->grid[1]);
+  free(obj->grid_expected);
+  free(obj->input);
+  free(obj->output);
+  free(obj->output_expected);
+  free(obj->chunk_sums);
+  free(obj->offsets);
+  free(obj->edges);
+  free(obj->levels);
+  free(obj->levels_expected);
+}
+
+static void init_barriers(pthread_subroutine_args_t *obj, uint t_num) {
+  bsp_barrier_t barriers[BARRIERS] = {
+      {"centralized", &obj->barrier_centralized, bsp_wait_centralized},
+      {"combining_tree", &obj->barrier_combining_tree,
+       bsp_wait_combining_tree},
+      {"dissemination", &obj->barrier_dissemination, bsp_wait_dissemination},
+      {"tournament", &obj->barrier_tournament, bsp_wait_tournament},
+      {"dual_tree", &obj->barrier_dual_tree, bsp_wait_dual_tree},
+      {"arrival_tree", &obj->barrier_arrival_tree, bsp_wait_arrival_tree},
+      {"wide_tree", &obj->barrier_wide_tree, bsp_wait_wide_tree},
+      {"pthread", &obj->barrier_pthread, bsp_wait_pthread},
+  };
+  memcpy(obj->barriers, barriers, sizeof(barriers));
+  barrier_init_centralized(&obj->barrier_centralized, t_num);
+  barrier_init_combining_tree(&obj->barrier_combining_tree, t_num);
+  barrier_init_dissemination(&obj->barrier_dissemination, t_num);
+  barrier_init_tournament(&obj->barrier_tournament, t_num);
+  barrier_init_dual_tree(&obj->barrier_dual_tree, t_num);
+  barrier_init_arrival_tree(&obj->barrier_arrival_tree, t_num);
+  barrier_init_wide_tree(&obj->barrier_wide_tree, t_num);
+  pthread_barrier_init(&obj->barrier_pthread, NULL, t_num);
+}
+
+static void destroy_barriers(pthread_subroutine_args_t *obj) {
+  barrier_destroy_centralized(&obj->barrier_centralized);
+  barrier_destroy_combining_tree(&obj->barrier_combining_tree);
+  barrier_destroy_dissemination(&obj->barrier_dissemination);
+  barrier_destroy_tournament(&obj->barrier_tournament);
+  barrier_destroy_dual_tree(&obj->barrier_dual_tree);
+  barrier_destroy_arrival_tree(&obj->barrier_arrival_tree);
+  barrier_destroy_wide_tree(&obj->barrier_wide_tree);
+  pthread_barrier_destroy(&obj->barrier_pthread);
+}
+
+static void print_usage(const char *argv0) {
+  uint i;
+  printf("USAGE:\n\t%s <#threads> <#iterations> [size] [kernel] [barrier]\n",
+         argv0);
+  printf("\tkernels:");
+  for (i = 0; i < KERNELS; ++i) {
+    printf(" %s", kernels[i].name);
+  }
+  printf("\n\tbarriers: centralized combining_tree dissemination tournament "
+         "dual_tree arrival_tree wide_tree pthread\n");
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int iterations = atoi(argv[2]);
+    int size = (argc > 3) ? atoi(argv[3]) : DEFAULT_SIZE;
+    if (t_num > 0 && iterations > 0 && size >= 3) {
+      int retval;
+      obj.thread_num = t_num;
+      obj.iterations = iterations;
+      obj.size = size;
+      obj.kernel = (argc > 4 && strcmp(argv[4], "all") != 0) ? argv[4] : NULL;
+      obj.barrier = (argc > 5) ? argv[5] : NULL;
+      printf("Testing with %d threads, %d iterations, size %d...\n", t_num,
+             iterations, size);
+
+      obj.stats =
+          (padded_bsp_stats_t *)calloc(t_num, sizeof(padded_bsp_stats_t));
+      assert(obj.stats != NULL);
+      init_workloads(&obj);
+      init_barriers(&obj, t_num);
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      pthread_barrier_destroy(&obj.barrier_aux);
+      destroy_barriers(&obj);
+      destroy_workloads(&obj);
+      free(obj.stats);
+      return retval;
+    } else {
+      print_usage(argv[0]);
+      return -3;
+    }
+  } else {
+    print_usage(argv[0]);
+    return -3;
+  }
+}
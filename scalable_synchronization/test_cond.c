@@ -0,0 +1,280 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BUFFER_SIZE 16
+/* Every thread waits for all others once per `GATHER_PERIOD` items */
+#define GATHER_PERIOD 256
+
+enum { NOT_FULL, NOT_EMPTY, ALL_ARRIVED, CONDS };
+
+/* Bounded buffer: every lock guards the same ring with its own conditions.
+ * A gathering phase, where the last thread to arrive broadcasts, exercises
+ * the requeue of many waiters at once. */
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  uint producers;
+  unsigned long long checksum;
+  unsigned long long items[BUFFER_SIZE];
+  uint head, count;
+  uint arrived, generation;
+  cond_t conds[CONDS];
+  pthread_cond_t conds_pthread[CONDS];
+  semaphore_futex_t slots, filled;
+  mutex_test_and_set_t mutex_test_and_set;
+  mutex_ticket_t mutex_ticket;
+  mutex_Anderson_t mutex_Anderson;
+  mutex_GT_t mutex_GT;
+  mutex_MCS_t mutex_MCS;
+  mutex_CLH_t mutex_CLH;
+  pthread_mutex_t mutex_pthread;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+/* Consumers split the items of all producers evenly */
+static uint consumer_share(pthread_subroutine_args_t *obj) {
+  uint consumers = obj->thread_num - obj->producers;
+  uint total = obj->producers * obj->repetitions;
+  uint c = thread_current_id() - obj->producers;
+  return total / consumers + (c < total % consumers ? 1 : 0);
+}
+
+static unsigned long long item_of(uint producer, int i, int repetitions) {
+  return (unsigned long long)producer * repetitions + i + 1;
+}
+
+static void buffer_put(pthread_subroutine_args_t *obj,
+                       unsigned long long item) {
+  obj->items[(obj->head + obj->count++) % BUFFER_SIZE] = item;
+}
+
+static unsigned long long buffer_take(pthread_subroutine_args_t *obj) {
+  unsigned long long item = obj->items[obj->head];
+  obj->head = (obj->head + 1) % BUFFER_SIZE;
+  --obj->count;
+  return item;
+}
+
+static void check_checksum(pthread_subroutine_args_t *obj) {
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    unsigned long long n =
+        (unsigned long long)obj->producers * obj->repetitions;
+    assert(obj->checksum == n * (n + 1) / 2);
+    assert(obj->count == 0);
+    obj->checksum = 0;
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+}
+
+/* `wait`, `signal` and `broadcast` refer to the condition index `c` */
+#define CREATE_COND_TESTER(name, own_decl, lock, unlock, wait, signal,         \
+                           broadcast)                                          \
+  void test_cond_##name(pthread_subroutine_args_t *obj) {                      \
+    my_time_t t;                                                               \
+    uint tid = thread_current_id();                                            \
+    uint i, c, n;                                                              \
+    unsigned long long sum = 0;                                                \
+    own_decl;                                                                  \
+    n = (tid < obj->producers) ? obj->repetitions : consumer_share(obj);       \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < n; ++i) {                                                  \
+      lock;                                                                    \
+      if (tid < obj->producers) {                                              \
+        c = NOT_FULL;                                                          \
+        while (obj->count == BUFFER_SIZE) {                                    \
+          wait;                                                                \
+        }                                                                      \
+        buffer_put(obj, item_of(tid, i, obj->repetitions));                    \
+        c = NOT_EMPTY;                                                         \
+        signal;                                                                \
+      } else {                                                                 \
+        c = NOT_EMPTY;                                                         \
+        while (obj->count == 0) {                                              \
+          wait;                                                                \
+        }                                                                      \
+        sum += buffer_take(obj);                                               \
+        c = NOT_FULL;                                                          \
+        signal;                                                                \
+      }                                                                        \
+      unlock;                                                                  \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, "buffer " #name);             \
+    lock;                                                                      \
+    obj->checksum += sum;                                                      \
+    unlock;                                                                    \
+    check_checksum(obj);                                                       \
+                                                                               \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < (uint)obj->repetitions / GATHER_PERIOD; ++i) {             \
+      lock;                                                                    \
+      c = ALL_ARRIVED;                                                         \
+      if (++obj->arrived == (uint)obj->thread_num) {                           \
+        obj->arrived = 0;                                                      \
+        ++obj->generation;                                                     \
+        broadcast;                                                             \
+      } else {                                                                 \
+        uint generation = obj->generation;                                     \
+        while (obj->generation == generation) {                                \
+          wait;                                                                \
+        }                                                                      \
+      }                                                                        \
+      unlock;                                                                  \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions / GATHER_PERIOD,               \
+        "gather " #name);                                                      \
+  }
+
+CREATE_COND_TESTER(test_and_set, ,
+                   mutex_lock_test_and_set(&obj->mutex_test_and_set),
+                   mutex_unlock_test_and_set(&obj->mutex_test_and_set),
+                   cond_wait_test_and_set(&obj->conds[c],
+                                          &obj->mutex_test_and_set),
+                   cond_signal_test_and_set(&obj->conds[c],
+                                            &obj->mutex_test_and_set),
+                   cond_broadcast_test_and_set(&obj->conds[c],
+                                               &obj->mutex_test_and_set))
+CREATE_COND_TESTER(ticket, , mutex_lock_ticket(&obj->mutex_ticket),
+                   mutex_unlock_ticket(&obj->mutex_ticket),
+                   cond_wait_ticket(&obj->conds[c], &obj->mutex_ticket),
+                   cond_signal_ticket(&obj->conds[c], &obj->mutex_ticket),
+                   cond_broadcast_ticket(&obj->conds[c], &obj->mutex_ticket))
+CREATE_COND_TESTER(Anderson, mutex_Anderson_ownership_t ownership,
+                   mutex_lock_Anderson(&obj->mutex_Anderson, &ownership),
+                   mutex_unlock_Anderson(&obj->mutex_Anderson, &ownership),
+                   cond_wait_Anderson(&obj->conds[c], &obj->mutex_Anderson,
+                                      &ownership),
+                   cond_signal_Anderson(&obj->conds[c], &obj->mutex_Anderson),
+                   cond_broadcast_Anderson(&obj->conds[c],
+                                           &obj->mutex_Anderson))
+CREATE_COND_TESTER(GT, , mutex_lock_GT(&obj->mutex_GT),
+                   mutex_unlock_GT(&obj->mutex_GT),
+                   cond_wait_GT(&obj->conds[c], &obj->mutex_GT),
+                   cond_signal_GT(&obj->conds[c], &obj->mutex_GT),
+                   cond_broadcast_GT(&obj->conds[c], &obj->mutex_GT))
+CREATE_COND_TESTER(MCS, mutex_MCS_ownership_t ownership,
+                   mutex_lock_MCS(&obj->mutex_MCS, &ownership),
+                   mutex_unlock_MCS(&obj->mutex_MCS, &ownership),
+                   cond_wait_MCS(&obj->conds[c], &obj->mutex_MCS, &ownership),
+                   cond_signal_MCS(&obj->conds[c], &obj->mutex_MCS),
+                   cond_broadcast_MCS(&obj->conds[c], &obj->mutex_MCS))
+CREATE_COND_TESTER(CLH, , mutex_lock_CLH(&obj->mutex_CLH),
+                   mutex_unlock_CLH(&obj->mutex_CLH),
+                   cond_wait_CLH(&obj->conds[c], &obj->mutex_CLH),
+                   cond_signal_CLH(&obj->conds[c], &obj->mutex_CLH),
+                   cond_broadcast_CLH(&obj->conds[c], &obj->mutex_CLH))
+CREATE_COND_TESTER(pthread, , pthread_mutex_lock(&obj->mutex_pthread),
+                   pthread_mutex_unlock(&obj->mutex_pthread),
+                   pthread_cond_wait(&obj->conds_pthread[c],
+                                     &obj->mutex_pthread),
+                   pthread_cond_signal(&obj->conds_pthread[c]),
+                   pthread_cond_broadcast(&obj->conds_pthread[c]))
+
+/* Semaphores count free and filled slots, the MCS lock only guards the
+ * ring itself. */
+void test_semaphore(pthread_subroutine_args_t *obj) {
+  my_time_t t;
+  uint tid = thread_current_id();
+  uint i, n;
+  unsigned long long sum = 0;
+  mutex_MCS_ownership_t ownership;
+  n = (tid < obj->producers) ? obj->repetitions : consumer_share(obj);
+  tic(&t, &obj->barrier_aux);
+  for (i = 0; i < n; ++i) {
+    if (tid < obj->producers) {
+      semaphore_wait_futex(&obj->slots);
+      mutex_lock_MCS(&obj->mutex_MCS, &ownership);
+      buffer_put(obj, item_of(tid, i, obj->repetitions));
+      mutex_unlock_MCS(&obj->mutex_MCS, &ownership);
+      semaphore_post_futex(&obj->filled);
+    } else {
+      semaphore_wait_futex(&obj->filled);
+      mutex_lock_MCS(&obj->mutex_MCS, &ownership);
+      sum += buffer_take(obj);
+      mutex_unlock_MCS(&obj->mutex_MCS, &ownership);
+      semaphore_post_futex(&obj->slots);
+    }
+  }
+  toc(&t, &obj->barrier_aux, obj->repetitions, "buffer semaphore");
+  mutex_lock_MCS(&obj->mutex_MCS, &ownership);
+  obj->checksum += sum;
+  mutex_unlock_MCS(&obj->mutex_MCS, &ownership);
+  check_checksum(obj);
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  if (thread_current_id() == 0) {
+    printf("\tTesting a %d-slot buffer with %u producers, %u consumers...\n",
+           BUFFER_SIZE, obj->producers, obj->thread_num - obj->producers);
+  }
+  test_cond_test_and_set(obj);
+  test_cond_ticket(obj);
+  test_cond_Anderson(obj);
+  test_cond_GT(obj);
+  test_cond_MCS(obj);
+  test_cond_CLH(obj);
+  test_cond_pthread(obj);
+  test_semaphore(obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    int producers = (argc > 3) ? atoi(argv[3]) : t_num / 2;
+    if (t_num > 1 && producers > 0 && producers < t_num) {
+      int i, retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      obj.producers = producers;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      obj.checksum = 0;
+      obj.head = obj.count = 0;
+      obj.arrived = obj.generation = 0;
+      for (i = 0; i < CONDS; ++i) {
+        cond_init(&obj.conds[i]);
+        pthread_cond_init(&obj.conds_pthread[i], NULL);
+      }
+      semaphore_init_futex(&obj.slots, BUFFER_SIZE);
+      semaphore_init_futex(&obj.filled, 0);
+      mutex_init_test_and_set(&obj.mutex_test_and_set);
+      mutex_init_ticket(&obj.mutex_ticket);
+      mutex_init_Anderson(&obj.mutex_Anderson, t_num);
+      mutex_init_GT(&obj.mutex_GT, t_num);
+      mutex_init_MCS(&obj.mutex_MCS);
+      mutex_init_CLH(&obj.mutex_CLH, t_num);
+      pthread_mutex_init(&obj.mutex_pthread, NULL);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      pthread_mutex_destroy(&obj.mutex_pthread);
+      mutex_destroy_CLH(&obj.mutex_CLH);
+      mutex_destroy_GT(&obj.mutex_GT);
+      mutex_destroy_Anderson(&obj.mutex_Anderson);
+      for (i = 0; i < CONDS; ++i) {
+        pthread_cond_destroy(&obj.conds_pthread[i]);
+      }
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      printf("USAGE:\n\t%s <#threads> <#repetitions> [#producers]\n",
+             argv[0]);
+      return -3;
+    }
+  } else {
+    printf("USAGE:\n\t%s <#threads> <#repetitions> [#producers]\n", argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,123 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SLOPPY_THRESHOLD 64
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  atomic_long shared;
+  counter_distributed_t counter_distributed;
+  counter_sloppy_t counter_sloppy;
+  atomic_long shared_indicator;
+  indicator_SNZI_t indicator_SNZI;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+#define CREATE_COUNTER_TESTER(name, update)                                    \
+  void test_counter_##name(pthread_subroutine_args_t *obj) {                   \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      update;                                                                  \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+  }
+
+CREATE_COUNTER_TESTER(shared, ATOMIC_ADD(&obj->shared, 1))
+CREATE_COUNTER_TESTER(distributed,
+                      counter_add_distributed(&obj->counter_distributed, 1))
+CREATE_COUNTER_TESTER(sloppy, counter_add_sloppy(&obj->counter_sloppy, 1))
+CREATE_COUNTER_TESTER(shared_indicator, {
+  ATOMIC_ADD(&obj->shared_indicator, 1);
+  ATOMIC_SUB(&obj->shared_indicator, 1);
+})
+CREATE_COUNTER_TESTER(SNZI, {
+  indicator_arrive_SNZI(&obj->indicator_SNZI);
+  indicator_depart_SNZI(&obj->indicator_SNZI);
+})
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  long total;
+  thread_init(obj->thread_num);
+  total = (long)thread_total_number() * obj->repetitions;
+  if (thread_current_id() == 0) {
+    puts("\tTesting counters...");
+  }
+
+  test_counter_shared(obj);
+  if (thread_current_id() == 0) {
+    assert(ATOMIC_LOAD(&obj->shared) == total);
+  }
+  test_counter_distributed(obj);
+  if (thread_current_id() == 0) {
+    assert(counter_read_distributed(&obj->counter_distributed) == total);
+  }
+  test_counter_sloppy(obj);
+  if (thread_current_id() == 0) {
+    long approx = counter_read_sloppy(&obj->counter_sloppy);
+    assert(total - approx < (long)obj->thread_num * SLOPPY_THRESHOLD);
+    assert(counter_read_exact_sloppy(&obj->counter_sloppy) == total);
+  }
+  counter_flush_sloppy(&obj->counter_sloppy);
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    assert(counter_read_sloppy(&obj->counter_sloppy) == total);
+    puts("\tTesting non-zero indicators...");
+  }
+
+  test_counter_shared_indicator(obj);
+  if (thread_current_id() == 0) {
+    assert(ATOMIC_LOAD(&obj->shared_indicator) == 0);
+  }
+  indicator_arrive_SNZI(&obj->indicator_SNZI);
+  pthread_barrier_wait(&obj->barrier_aux);
+  assert(indicator_query_SNZI(&obj->indicator_SNZI));
+  test_counter_SNZI(obj);
+  indicator_depart_SNZI(&obj->indicator_SNZI);
+  pthread_barrier_wait(&obj->barrier_aux);
+  assert(!indicator_query_SNZI(&obj->indicator_SNZI));
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      atomic_init(&obj.shared, 0);
+      atomic_init(&obj.shared_indicator, 0);
+      counter_init_distributed(&obj.counter_distributed, t_num);
+      counter_init_sloppy(&obj.counter_sloppy, t_num, SLOPPY_THRESHOLD);
+      indicator_init_SNZI(&obj.indicator_SNZI, t_num);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      indicator_destroy_SNZI(&obj.indicator_SNZI);
+      counter_destroy_sloppy(&obj.counter_sloppy);
+      counter_destroy_distributed(&obj.counter_distributed);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,108 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Generic barriers against their copies specialized for
+ * `BARRIER_FIXED_THREADS` threads. Between episodes every thread writes a
+ * slot that another thread reads after the next episode, so a barrier that
+ * lets a thread through early breaks the final count. */
+
+typedef struct {
+  int repetitions;
+  uint *slots[2];
+  barrier_dissemination_t barrier_dissemination;
+  barrier_fixed_dissemination_t barrier_fixed_dissemination;
+  barrier_tournament_t barrier_tournament;
+  barrier_fixed_tournament_t barrier_fixed_tournament;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static void check_slots(pthread_subroutine_args_t *obj) {
+  uint i;
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    for (i = 0; i < BARRIER_FIXED_THREADS; ++i) {
+      assert(obj->slots[obj->repetitions % 2][i] == (uint)obj->repetitions);
+      obj->slots[0][i] = obj->slots[1][i] = 0;
+    }
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+}
+
+/* In episode `i` thread `tid` copies its neighbor's slot of episode `i - 1`
+ * plus one, so all slots count the episodes */
+#define CREATE_BARRIER_TESTER(type)                                            \
+  void test_barrier_##type(pthread_subroutine_args_t *obj) {                   \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    uint tid = thread_current_id();                                            \
+    uint neighbor = (tid + 1) % BARRIER_FIXED_THREADS;                         \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      obj->slots[(i + 1) % 2][tid] = obj->slots[i % 2][neighbor] + 1;          \
+      barrier_wait_##type(&obj->barrier_##type);                               \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #type);                       \
+    check_slots(obj);                                                          \
+  }
+
+CREATE_BARRIER_TESTER(dissemination)
+CREATE_BARRIER_TESTER(fixed_dissemination)
+CREATE_BARRIER_TESTER(tournament)
+CREATE_BARRIER_TESTER(fixed_tournament)
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(BARRIER_FIXED_THREADS);
+  test_barrier_dissemination(obj);
+  test_barrier_fixed_dissemination(obj);
+  test_barrier_tournament(obj);
+  test_barrier_fixed_tournament(obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t *obj;
+  int repetitions = (argc > 1) ? atoi(argv[1]) : 0;
+  if (repetitions > 0) {
+    int retval;
+    /* The specialized barriers want their cache line alignment */
+    obj = (pthread_subroutine_args_t *)aligned_alloc(
+        CACHE_LINE_SIZE,
+        (sizeof(pthread_subroutine_args_t) + CACHE_LINE_SIZE - 1) /
+            CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+    assert(obj != NULL);
+    obj->repetitions = repetitions;
+    obj->slots[0] = (uint *)calloc(BARRIER_FIXED_THREADS, sizeof(uint));
+    obj->slots[1] = (uint *)calloc(BARRIER_FIXED_THREADS, sizeof(uint));
+    assert(obj->slots[0] != NULL && obj->slots[1] != NULL);
+    printf("Testing with %d threads, %d repetitions...\n",
+           BARRIER_FIXED_THREADS, repetitions);
+
+    pthread_barrier_init(&obj->barrier_aux, NULL, BARRIER_FIXED_THREADS);
+    barrier_init_dissemination(&obj->barrier_dissemination,
+                               BARRIER_FIXED_THREADS);
+    barrier_init_fixed_dissemination(&obj->barrier_fixed_dissemination);
+    barrier_init_tournament(&obj->barrier_tournament, BARRIER_FIXED_THREADS);
+    barrier_init_fixed_tournament(&obj->barrier_fixed_tournament);
+
+    retval = parallel_execute(pthread_subroutine, (void *)obj,
+                              BARRIER_FIXED_THREADS);
+
+    barrier_destroy_dissemination(&obj->barrier_dissemination);
+    barrier_destroy_tournament(&obj->barrier_tournament);
+    pthread_barrier_destroy(&obj->barrier_aux);
+    free(obj->slots[0]);
+    free(obj->slots[1]);
+    free(obj);
+    return retval;
+  } else {
+    printf("USAGE:\n\t%s <#repetitions>\n", argv[0]);
+    printf("\tThe thread count is fixed at %d when building.\n",
+           BARRIER_FIXED_THREADS);
+    return -3;
+  }
+}
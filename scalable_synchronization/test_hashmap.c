@@ -0,0 +1,163 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* YCSB-like workloads over a preloaded map: A is half reads and half
+ * updates, B 95% reads and C only reads, with Zipfian key popularity as in
+ * YCSB. Values always encode their key, so every read is checked. */
+
+#define KEYS (1 << 16)
+#define ZIPF_THETA 0.99
+#define DEFAULT_STRIPES 64
+/* Small enough for the preload to go through several resizes */
+#define INITIAL_CAPACITY 1024
+
+#define STRINGIFY(x_) #x_
+#define NAME(x_) STRINGIFY(x_)
+
+/* Zipfian generator of Gray et al., "Quickly generating billion-record
+ * synthetic databases", as used by YCSB */
+typedef struct {
+  double zetan, alpha, eta, half_pow_theta;
+} zipf_t;
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  hashmap_t map;
+  zipf_t zipf;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static void zipf_init(zipf_t *zipf, uint n, double theta) {
+  uint i;
+  double zeta2 = 1.0 + pow(0.5, theta);
+  zipf->zetan = 0.0;
+  for (i = 1; i <= n; ++i) {
+    zipf->zetan += 1.0 / pow((double)i, theta);
+  }
+  zipf->alpha = 1.0 / (1.0 - theta);
+  zipf->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zipf->zetan);
+  zipf->half_pow_theta = pow(0.5, theta);
+}
+
+static unsigned long zipf_next(const zipf_t *zipf, uint64_t *seed) {
+  double u = (double)(next_random(seed) >> 11) / (double)(1ull << 53);
+  double uz = u * zipf->zetan;
+  unsigned long key;
+  if (uz < 1.0) {
+    return 0;
+  }
+  if (uz < 1.0 + zipf->half_pow_theta) {
+    return 1;
+  }
+  key = (unsigned long)(KEYS * pow(zipf->eta * u - zipf->eta + 1.0,
+                                   zipf->alpha));
+  return (key < KEYS) ? key : KEYS - 1;
+}
+
+static void check_value(unsigned long key, unsigned long value) {
+  assert(value % KEYS == key);
+}
+
+static void preload(pthread_subroutine_args_t *obj) {
+  unsigned long key, value;
+  uint tid = thread_current_id();
+  bool present;
+  for (key = tid; key < KEYS; key += obj->thread_num) {
+    present = !hashmap_put(&obj->map, key, key);
+    assert(!present);
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+  for (key = tid; key < KEYS; key += obj->thread_num) {
+    present = hashmap_get(&obj->map, key, &value);
+    assert(present);
+    check_value(key, value);
+  }
+  (void)present;
+}
+
+static void test_ycsb(pthread_subroutine_args_t *obj, const char *name,
+                      uint read_percent) {
+  my_time_t t;
+  int i;
+  uint64_t seed = 88172645463325252ull + thread_current_id();
+  unsigned long version = 0, value;
+  bool present;
+  tic(&t, &obj->barrier_aux);
+  for (i = 0; i < obj->repetitions; ++i) {
+    unsigned long key = zipf_next(&obj->zipf, &seed);
+    if (next_random(&seed) % 100 < read_percent) {
+      present = hashmap_get(&obj->map, key, &value);
+      assert(present);
+      check_value(key, value);
+    } else {
+      present = !hashmap_put(&obj->map, key, key + KEYS * ++version);
+      assert(present);
+    }
+  }
+  toc(&t, &obj->barrier_aux, obj->repetitions, name);
+  (void)present;
+}
+
+static void unload(pthread_subroutine_args_t *obj) {
+  unsigned long key, value;
+  uint tid = thread_current_id();
+  bool present;
+  for (key = tid; key < KEYS; key += obj->thread_num) {
+    present = hashmap_remove(&obj->map, key);
+    assert(present);
+    present = hashmap_get(&obj->map, key, &value);
+    assert(!present);
+  }
+  (void)present;
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  preload(obj);
+  test_ycsb(obj, "YCSB_A", 50);
+  test_ycsb(obj, "YCSB_B", 95);
+  test_ycsb(obj, "YCSB_C", 100);
+  unload(obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    int stripes = (argc > 3) ? atoi(argv[3]) : DEFAULT_STRIPES;
+    if (t_num > 0 && stripes > 0) {
+      int retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+      printf("\t%d stripes with %s locks, %d keys...\n", stripes,
+             NAME(HASHMAP_MUTEX), KEYS);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      zipf_init(&obj.zipf, KEYS, ZIPF_THETA);
+      hashmap_init(&obj.map, t_num, stripes, INITIAL_CAPACITY);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      hashmap_destroy(&obj.map);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      printf("USAGE:\n\t%s <#threads> <#repetitions> [#stripes]\n", argv[0]);
+      return -3;
+    }
+  } else {
+    printf("USAGE:\n\t%s <#threads> <#repetitions> [#stripes]\n", argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,196 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Bank transfers: every operation locks a few distinct random accounts and
+ * moves one unit from the first to each of the others, so the total balance
+ * never changes. Sequential acquisition takes the locks one at a time in
+ * address order; parallel acquisition enqueues on all of them first. */
+
+#define DEFAULT_ACCOUNTS 64
+#define DEFAULT_LOCKS 2
+#define MAX_LOCKS 8
+#define INITIAL_BALANCE 1000000
+
+typedef struct {
+  long balance;
+  int inside;
+  mutex_MCS_t mutex_MCS;
+  mutex_CLH_t mutex_CLH;
+  mutex_ticket_t mutex_ticket;
+} account_t;
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  uint account_num;
+  uint lock_num;
+  account_t *accounts;
+  mutex_multi_t domain;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static void pick_accounts(pthread_subroutine_args_t *obj, uint64_t *seed,
+                          uint *picked) {
+  uint i, j;
+  for (i = 0; i < obj->lock_num; ++i) {
+    bool repeated;
+    do {
+      picked[i] = next_random(seed) % obj->account_num;
+      repeated = false;
+      for (j = 0; j < i; ++j) {
+        repeated = repeated || picked[j] == picked[i];
+      }
+    } while (repeated);
+  }
+}
+
+static void transfer(pthread_subroutine_args_t *obj, const uint *picked) {
+  uint i;
+  for (i = 0; i < obj->lock_num; ++i) {
+    ++obj->accounts[picked[i]].inside;
+    assert(obj->accounts[picked[i]].inside == 1);
+  }
+  obj->accounts[picked[0]].balance -= obj->lock_num - 1;
+  for (i = 1; i < obj->lock_num; ++i) {
+    ++obj->accounts[picked[i]].balance;
+  }
+  for (i = 0; i < obj->lock_num; ++i) {
+    --obj->accounts[picked[i]].inside;
+  }
+}
+
+static void check_balance(pthread_subroutine_args_t *obj) {
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    uint i;
+    long total = 0;
+    for (i = 0; i < obj->account_num; ++i) {
+      total += obj->accounts[i].balance;
+    }
+    assert(total == (long)obj->account_num * INITIAL_BALANCE);
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+}
+
+#define CREATE_TRANSFER_TESTER(name, type, array_type, own_decl, lock, unlock) \
+  void test_transfer_##name(pthread_subroutine_args_t *obj) {                  \
+    my_time_t t;                                                               \
+    int r;                                                                     \
+    uint i, picked[MAX_LOCKS];                                                 \
+    uint64_t seed = 88172645463325252ull + thread_current_id();                \
+    array_type mutexes[MAX_LOCKS];                                             \
+    own_decl;                                                                  \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (r = 0; r < obj->repetitions; ++r) {                                   \
+      pick_accounts(obj, &seed, picked);                                       \
+      for (i = 0; i < obj->lock_num; ++i) {                                    \
+        mutexes[i] = &obj->accounts[picked[i]].mutex_##type;                   \
+      }                                                                        \
+      lock;                                                                    \
+      transfer(obj, picked);                                                   \
+      unlock;                                                                  \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+    check_balance(obj);                                                        \
+  }
+
+CREATE_TRANSFER_TESTER(ticket_sequential, ticket, void *, ,
+                       mutex_lock_multi(&rwlock_mutex_ticket, mutexes, NULL,
+                                        obj->lock_num),
+                       mutex_unlock_multi(&rwlock_mutex_ticket, mutexes, NULL,
+                                          obj->lock_num))
+CREATE_TRANSFER_TESTER(MCS_sequential, MCS, void *,
+                       mutex_MCS_ownership_t ownerships[MAX_LOCKS];
+                       void *owned[MAX_LOCKS];
+                       for (i = 0; i < MAX_LOCKS; ++i) {
+                         owned[i] = &ownerships[i];
+                       },
+                       mutex_lock_multi(&rwlock_mutex_MCS, mutexes, owned,
+                                        obj->lock_num),
+                       mutex_unlock_multi(&rwlock_mutex_MCS, mutexes, owned,
+                                          obj->lock_num))
+CREATE_TRANSFER_TESTER(MCS_parallel, MCS, mutex_MCS_t *,
+                       mutex_MCS_ownership_t ownerships[MAX_LOCKS],
+                       mutex_lock_multi_MCS(&obj->domain, mutexes, ownerships,
+                                            obj->lock_num),
+                       mutex_unlock_multi_MCS(mutexes, ownerships,
+                                              obj->lock_num))
+CREATE_TRANSFER_TESTER(CLH_sequential, CLH, void *, ,
+                       mutex_lock_multi(&rwlock_mutex_CLH, mutexes, NULL,
+                                        obj->lock_num),
+                       mutex_unlock_multi(&rwlock_mutex_CLH, mutexes, NULL,
+                                          obj->lock_num))
+CREATE_TRANSFER_TESTER(CLH_parallel, CLH, mutex_CLH_t *, ,
+                       mutex_lock_multi_CLH(&obj->domain, mutexes,
+                                            obj->lock_num),
+                       mutex_unlock_multi_CLH(mutexes, obj->lock_num))
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  test_transfer_ticket_sequential(obj);
+  test_transfer_MCS_sequential(obj);
+  test_transfer_MCS_parallel(obj);
+  test_transfer_CLH_sequential(obj);
+  test_transfer_CLH_parallel(obj);
+  return NULL;
+}
+
+static void print_usage(const char *argv0) {
+  printf("USAGE:\n\t%s <#threads> <#repetitions> [#accounts] "
+         "[#locks per transfer]\n",
+         argv0);
+  printf("\tTransfers take 2 to %d locks, and there must be at least as "
+         "many accounts.\n",
+         MAX_LOCKS);
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    int accounts = (argc > 3) ? atoi(argv[3]) : DEFAULT_ACCOUNTS;
+    int locks = (argc > 4) ? atoi(argv[4]) : DEFAULT_LOCKS;
+    if (t_num > 0 && locks >= 2 && locks <= MAX_LOCKS && accounts >= locks) {
+      int i, retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      obj.account_num = accounts;
+      obj.lock_num = locks;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+      printf("\t%d accounts, %d locks per transfer...\n", accounts, locks);
+
+      obj.accounts = (account_t *)calloc(accounts, sizeof(account_t));
+      assert(obj.accounts != NULL);
+      for (i = 0; i < accounts; ++i) {
+        obj.accounts[i].balance = INITIAL_BALANCE;
+        mutex_init_MCS(&obj.accounts[i].mutex_MCS);
+        mutex_init_CLH(&obj.accounts[i].mutex_CLH, t_num);
+        mutex_init_ticket(&obj.accounts[i].mutex_ticket);
+      }
+      mutex_init_multi(&obj.domain);
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      pthread_barrier_destroy(&obj.barrier_aux);
+      for (i = 0; i < accounts; ++i) {
+        mutex_destroy_CLH(&obj.accounts[i].mutex_CLH);
+      }
+      free(obj.accounts);
+      return retval;
+    } else {
+      print_usage(argv[0]);
+      return -3;
+    }
+  } else {
+    print_usage(argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,238 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Per-thread slots against per-CPU slots updated in restartable sequences.
+ * Run with more threads than CPUs, the per-CPU layout keeps its size while
+ * updates get preempted and restarted. */
+
+#define CONFIG_FIELDS 4
+/* Thread 0 writes once per `RWLOCK_PERIOD` operations, all others only read */
+#define RWLOCK_PERIOD 256
+/* Nodes of the free lists per thread */
+#define LIST_NODES 4
+
+typedef struct { uint fields[CONFIG_FIELDS]; } config_t;
+
+static void config_write(config_t *config) {
+  int i;
+  uint value = config->fields[0] + 1;
+  for (i = 0; i < CONFIG_FIELDS; ++i) {
+    config->fields[i] = value;
+  }
+}
+
+static void config_check(config_t *config) {
+  int i;
+  for (i = 1; i < CONFIG_FIELDS; ++i) {
+    assert(config->fields[i] == config->fields[0]);
+  }
+}
+
+/* Per-thread free list: a stack of its own for every thread, so that a
+ * node only changes hands when the thread is gone */
+typedef struct { void *head; } list_thread_t;
+
+AVOID_FALSE_SHARING(list_thread_t, padded_list_thread_t)
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  config_t config;
+  counter_distributed_t counter_distributed;
+  counter_percpu_t counter_percpu;
+  mutex_ticket_t flags_mutex;
+  rwlock_flags_t rwlock_flags;
+  mutex_ticket_t percpu_mutex;
+  rwlock_percpu_t rwlock_percpu;
+  padded_list_thread_t *list_thread;
+  list_percpu_t list_percpu;
+  atomic_long list_nodes;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+#define CREATE_COUNTER_TESTER(name)                                            \
+  void test_counter_##name(pthread_subroutine_args_t *obj) {                   \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      counter_add_##name(&obj->counter_##name, 1);                             \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+    if (thread_current_id() == 0) {                                            \
+      assert(counter_read_##name(&obj->counter_##name) ==                      \
+             (long)obj->thread_num * obj->repetitions);                        \
+    }                                                                          \
+  }
+
+#define CREATE_RWLOCK_TESTER(name)                                             \
+  void test_rwlock_##name(pthread_subroutine_args_t *obj) {                    \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    bool writer = thread_current_id() == 0;                                    \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      if (writer && i % RWLOCK_PERIOD == 0) {                                  \
+        rwlock_write_lock_##name(&obj->rwlock_##name, NULL);                   \
+        config_write(&obj->config);                                            \
+        rwlock_write_unlock_##name(&obj->rwlock_##name, NULL);                 \
+      } else {                                                                 \
+        rwlock_read_lock_##name(&obj->rwlock_##name);                          \
+        config_check(&obj->config);                                            \
+        rwlock_read_unlock_##name(&obj->rwlock_##name);                        \
+      }                                                                        \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+  }
+
+/* Every thread cycles its nodes through the list, and allocates one when the
+ * list at hand is empty */
+#define CREATE_LIST_TESTER(name, pop, push)                                    \
+  void test_list_##name(pthread_subroutine_args_t *obj) {                      \
+    my_time_t t;                                                               \
+    int i, j;                                                                  \
+    void *nodes[LIST_NODES];                                                   \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      for (j = 0; j < LIST_NODES; ++j) {                                       \
+        if ((nodes[j] = pop) == NULL) {                                        \
+          nodes[j] = slab_alloc(sizeof(void *));                               \
+          assert(nodes[j] != NULL);                                            \
+          ATOMIC_ADD(&obj->list_nodes, 1);                                     \
+        }                                                                      \
+      }                                                                        \
+      for (j = 0; j < LIST_NODES; ++j) {                                       \
+        void *node = nodes[j];                                                 \
+        push;                                                                  \
+      }                                                                        \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+  }
+
+static void *list_pop_thread(pthread_subroutine_args_t *obj) {
+  list_thread_t *list = &obj->list_thread[thread_current_id()].value;
+  void *node = list->head;
+  if (node != NULL) {
+    list->head = *(void **)node;
+  }
+  return node;
+}
+
+static void list_push_thread(pthread_subroutine_args_t *obj, void *node) {
+  list_thread_t *list = &obj->list_thread[thread_current_id()].value;
+  *(void **)node = list->head;
+  list->head = node;
+}
+
+CREATE_COUNTER_TESTER(distributed)
+CREATE_COUNTER_TESTER(percpu)
+CREATE_RWLOCK_TESTER(flags)
+CREATE_RWLOCK_TESTER(percpu)
+CREATE_LIST_TESTER(thread, list_pop_thread(obj), list_push_thread(obj, node))
+CREATE_LIST_TESTER(percpu, list_pop_percpu(&obj->list_percpu),
+                   list_push_percpu(&obj->list_percpu, node))
+
+static pthread_subroutine_args_t *reclaimed_obj;
+
+static void reclaim_node(void *node) {
+  ATOMIC_SUB(&reclaimed_obj->list_nodes, 1);
+  slab_free(node);
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  if (thread_current_id() == 0) {
+    puts("\tTesting counters...");
+  }
+  test_counter_distributed(obj);
+  test_counter_percpu(obj);
+  if (thread_current_id() == 0) {
+    printf("\tTesting reader-writer locks with one write per %d "
+           "operations...\n",
+           RWLOCK_PERIOD);
+  }
+  test_rwlock_flags(obj);
+  test_rwlock_percpu(obj);
+  if (thread_current_id() == 0) {
+    puts("\tTesting free lists...");
+  }
+  test_list_thread(obj);
+  test_list_percpu(obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int i, retval;
+      uint cpu_num = percpu_cpu_num();
+      if (!percpu_available()) {
+        puts("\tRestartable sequences are not available");
+        return LIB_INIT_INVALID;
+      }
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+      /* Each layout takes one cache line per slot */
+      printf("\tSlots per counter, lock or list: %d per-thread, %u "
+             "per-CPU\n",
+             t_num, cpu_num);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      for (i = 0; i < CONFIG_FIELDS; ++i) {
+        obj.config.fields[i] = 0;
+      }
+      counter_init_distributed(&obj.counter_distributed, t_num);
+      counter_init_percpu(&obj.counter_percpu);
+      mutex_init_ticket(&obj.flags_mutex);
+      rwlock_init_flags(&obj.rwlock_flags, t_num, &obj.flags_mutex,
+                        &rwlock_mutex_ticket);
+      mutex_init_ticket(&obj.percpu_mutex);
+      rwlock_init_percpu(&obj.rwlock_percpu, &obj.percpu_mutex,
+                         &rwlock_mutex_ticket);
+      obj.list_thread = (padded_list_thread_t *)calloc(
+          t_num, sizeof(padded_list_thread_t));
+      assert(obj.list_thread != NULL);
+      list_init_percpu(&obj.list_percpu);
+      atomic_init(&obj.list_nodes, 0);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      /* Every node allocated is in one of the lists */
+      reclaimed_obj = &obj;
+      for (i = 0; i < t_num; ++i) {
+        void *node = obj.list_thread[i].value.head;
+        while (node != NULL) {
+          void *next = *(void **)node;
+          reclaim_node(node);
+          node = next;
+        }
+      }
+      list_destroy_percpu(&obj.list_percpu, reclaim_node);
+      assert(ATOMIC_LOAD(&obj.list_nodes) == 0);
+      free(obj.list_thread);
+
+      counter_destroy_distributed(&obj.counter_distributed);
+      counter_destroy_percpu(&obj.counter_percpu);
+      rwlock_destroy_flags(&obj.rwlock_flags);
+      rwlock_destroy_percpu(&obj.rwlock_percpu);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
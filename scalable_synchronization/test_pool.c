@@ -0,0 +1,170 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FOR_SIZE 4096
+#define FOR_GRAIN 256
+#define FIB_N 16
+
+/* Only worker 0 measures, so the timing barrier has a single participant */
+static pthread_barrier_t solo;
+
+typedef struct {
+  pool_t *pool;
+  int n, result;
+} fib_frame_t;
+
+static void fib_task(void *arg) {
+  fib_frame_t *frame = (fib_frame_t *)arg;
+  if (frame->n < 2) {
+    frame->result = frame->n;
+  } else {
+    fib_frame_t left = {frame->pool, frame->n - 1, 0};
+    fib_frame_t right = {frame->pool, frame->n - 2, 0};
+    pool_task_t task;
+    pool_spawn(frame->pool, &task, fib_task, &right);
+    fib_task(&left);
+    pool_sync(frame->pool, &task);
+    frame->result = left.result + right.result;
+  }
+}
+
+static int fib(int n) { return (n < 2) ? n : fib(n - 1) + fib(n - 2); }
+
+static void empty_region(void *arg) {}
+
+static void *empty_routine(void *arg) { return NULL; }
+
+static void increment_body(long begin, long end, void *arg) {
+  int *array = (int *)arg;
+  long i;
+  for (i = begin; i < end; ++i) {
+    ++array[i];
+  }
+}
+
+typedef pthread_barrier_t barrier_pthread_t;
+
+void pool_join_pthread(void *barrier) {
+  pthread_barrier_wait((pthread_barrier_t *)barrier);
+}
+
+void test_create_join(int t_num, int repetitions) {
+  my_time_t t;
+  int i;
+  tic(&t, &solo);
+  for (i = 0; i < repetitions; ++i) {
+    parallel_execute(empty_routine, NULL, t_num);
+  }
+  toc(&t, &solo, repetitions, "create and join");
+}
+
+#define CREATE_POOL_TESTER(type)                                               \
+  void test_pool_##type(pool_t *pool, barrier_##type##_t *barrier,             \
+                        int *array, int repetitions) {                         \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    tic(&t, &solo);                                                            \
+    for (i = 0; i < repetitions; ++i) {                                        \
+      pool_run(pool, empty_region, NULL, pool_join_##type, barrier);           \
+    }                                                                          \
+    toc(&t, &solo, repetitions, "region " #type);                              \
+    tic(&t, &solo);                                                            \
+    for (i = 0; i < repetitions; ++i) {                                        \
+      pool_parallel_for(pool, 0, FOR_SIZE, FOR_GRAIN, increment_body, array,   \
+                        pool_join_##type, barrier);                            \
+    }                                                                          \
+    toc(&t, &solo, repetitions, "parallel for " #type);                        \
+  }
+
+CREATE_POOL_TESTER(centralized)
+CREATE_POOL_TESTER(combining_tree)
+CREATE_POOL_TESTER(dissemination)
+CREATE_POOL_TESTER(tournament)
+CREATE_POOL_TESTER(dual_tree)
+CREATE_POOL_TESTER(arrival_tree)
+CREATE_POOL_TESTER(pthread)
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int i;
+      pool_t pool;
+      my_time_t t;
+      fib_frame_t frame;
+      int *array = (int *)calloc(FOR_SIZE, sizeof(int));
+      barrier_centralized_t barrier_centralized;
+      barrier_combining_tree_t barrier_combining_tree;
+      barrier_dissemination_t barrier_dissemination;
+      barrier_tournament_t barrier_tournament;
+      barrier_dual_tree_t barrier_dual_tree;
+      barrier_arrival_tree_t barrier_arrival_tree;
+      pthread_barrier_t barrier_pthread;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      assert(array != NULL);
+      pthread_barrier_init(&solo, NULL, 1);
+      pthread_barrier_init(&barrier_pthread, NULL, t_num);
+      barrier_init_centralized(&barrier_centralized, t_num);
+      barrier_init_combining_tree(&barrier_combining_tree, t_num);
+      barrier_init_dissemination(&barrier_dissemination, t_num);
+      barrier_init_tournament(&barrier_tournament, t_num);
+      barrier_init_dual_tree(&barrier_dual_tree, t_num);
+      barrier_init_arrival_tree(&barrier_arrival_tree, t_num);
+
+      puts("\tTesting thread start-up...");
+      test_create_join(t_num, repetitions);
+      if (pool_init(&pool, t_num) != SUCCESS) {
+        return -1;
+      }
+
+      puts("\tTesting regions and joins...");
+      test_pool_centralized(&pool, &barrier_centralized, array, repetitions);
+      test_pool_combining_tree(&pool, &barrier_combining_tree, array,
+                               repetitions);
+      test_pool_dissemination(&pool, &barrier_dissemination, array,
+                              repetitions);
+      test_pool_tournament(&pool, &barrier_tournament, array, repetitions);
+      test_pool_dual_tree(&pool, &barrier_dual_tree, array, repetitions);
+      test_pool_arrival_tree(&pool, &barrier_arrival_tree, array, repetitions);
+      test_pool_pthread(&pool, &barrier_pthread, array, repetitions);
+      for (i = 0; i < FOR_SIZE; ++i) {
+        assert(array[i] == 7 * repetitions);
+      }
+
+      puts("\tTesting fork-join...");
+      frame.pool = &pool;
+      frame.n = FIB_N;
+      tic(&t, &solo);
+      for (i = 0; i < repetitions; ++i) {
+        fib_task(&frame);
+        assert(frame.result == fib(FIB_N));
+      }
+      toc(&t, &solo, repetitions, "fib");
+
+      pool_destroy(&pool);
+      barrier_destroy_centralized(&barrier_centralized);
+      barrier_destroy_combining_tree(&barrier_combining_tree);
+      barrier_destroy_dissemination(&barrier_dissemination);
+      barrier_destroy_tournament(&barrier_tournament);
+      barrier_destroy_dual_tree(&barrier_dual_tree);
+      barrier_destroy_arrival_tree(&barrier_arrival_tree);
+      pthread_barrier_destroy(&barrier_pthread);
+      pthread_barrier_destroy(&solo);
+      free(array);
+      return 0;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
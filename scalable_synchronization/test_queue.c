@@ -0,0 +1,219 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define QUEUE_CAPACITY 1024
+#define QUEUE_BATCH 16
+
+/* Baseline: a bounded array queue guarded by an MCS lock */
+typedef struct {
+  mutex_MCS_t mutex;
+  void **items;
+  uint mask, head, tail;
+} queue_locked_t;
+
+int queue_init_locked(queue_locked_t *queue, uint capacity) {
+  uint size = 1;
+  while (size < capacity) {
+    size = size << 1;
+  }
+  queue->items = (void **)malloc(sizeof(void *) * size);
+  if (queue->items == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  queue->mask = size - 1;
+  queue->head = queue->tail = 0;
+  return mutex_init_MCS(&queue->mutex);
+}
+
+void queue_destroy_locked(queue_locked_t *queue) {
+  free(queue->items);
+  queue->items = NULL;
+}
+
+bool queue_enqueue_locked(queue_locked_t *queue, void *data) {
+  mutex_MCS_ownership_t ownership;
+  bool success = false;
+  mutex_lock_MCS(&queue->mutex, &ownership);
+  if (queue->tail - queue->head <= queue->mask) {
+    queue->items[queue->tail++ & queue->mask] = data;
+    success = true;
+  }
+  mutex_unlock_MCS(&queue->mutex, &ownership);
+  return success;
+}
+
+bool queue_dequeue_locked(queue_locked_t *queue, void **data) {
+  mutex_MCS_ownership_t ownership;
+  bool success = false;
+  mutex_lock_MCS(&queue->mutex, &ownership);
+  if (queue->tail != queue->head) {
+    *data = queue->items[queue->head++ & queue->mask];
+    success = true;
+  }
+  mutex_unlock_MCS(&queue->mutex, &ownership);
+  return success;
+}
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  uint producers;
+  atomic_ullong checksum;
+  queue_locked_t queue_locked;
+  queue_ring_t queue_ring;
+  queue_MS_t queue_MS;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static void *item_of(uint producer, int i, int repetitions) {
+  return (void *)(uintptr_t)((unsigned long long)producer * repetitions + i +
+                             1);
+}
+
+/* Consumers split the items of all producers evenly */
+static uint consumer_share(pthread_subroutine_args_t *obj) {
+  uint consumers = obj->thread_num - obj->producers;
+  uint total = obj->producers * obj->repetitions;
+  uint c = thread_current_id() - obj->producers;
+  return total / consumers + (c < total % consumers ? 1 : 0);
+}
+
+static void check_checksum(pthread_subroutine_args_t *obj) {
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    unsigned long long n =
+        (unsigned long long)obj->producers * obj->repetitions;
+    assert(ATOMIC_LOAD(&obj->checksum) == n * (n + 1) / 2);
+    ATOMIC_STORE(&obj->checksum, 0);
+  }
+}
+
+#define CREATE_QUEUE_TESTER(type)                                              \
+  void test_queue_##type(queue_##type##_t *queue,                              \
+                         pthread_subroutine_args_t *obj) {                     \
+    my_time_t t;                                                               \
+    uint tid = thread_current_id();                                            \
+    tic(&t, &obj->barrier_aux);                                                \
+    if (tid < obj->producers) {                                                \
+      int i;                                                                   \
+      for (i = 0; i < obj->repetitions; ++i) {                                 \
+        while (!queue_enqueue_##type(queue,                                    \
+                                     item_of(tid, i, obj->repetitions))) {     \
+          delay(0);                                                            \
+        }                                                                      \
+      }                                                                        \
+    } else {                                                                   \
+      uint i, share = consumer_share(obj);                                     \
+      unsigned long long sum = 0;                                              \
+      for (i = 0; i < share; ++i) {                                            \
+        void *data;                                                            \
+        while (!queue_dequeue_##type(queue, &data)) {                          \
+          delay(0);                                                            \
+        }                                                                      \
+        sum += (uintptr_t)data;                                                \
+      }                                                                        \
+      ATOMIC_ADD(&obj->checksum, sum);                                         \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #type);                       \
+    check_checksum(obj);                                                       \
+  }
+
+#define CREATE_BATCH_QUEUE_TESTER(type)                                        \
+  void test_queue_batch_##type(queue_##type##_t *queue,                        \
+                               pthread_subroutine_args_t *obj) {               \
+    my_time_t t;                                                               \
+    void *batch[QUEUE_BATCH];                                                  \
+    uint tid = thread_current_id();                                            \
+    tic(&t, &obj->barrier_aux);                                                \
+    if (tid < obj->producers) {                                                \
+      int i = 0;                                                               \
+      while (i < obj->repetitions) {                                           \
+        uint j, n = 0, sent = 0;                                               \
+        for (j = 0; j < QUEUE_BATCH && i + j < obj->repetitions; ++j) {        \
+          batch[n++] = item_of(tid, i + j, obj->repetitions);                  \
+        }                                                                      \
+        while (sent < n) {                                                     \
+          sent += queue_enqueue_batch_##type(queue, batch + sent, n - sent);   \
+        }                                                                      \
+        i += n;                                                                \
+      }                                                                        \
+    } else {                                                                   \
+      uint received = 0, share = consumer_share(obj);                          \
+      unsigned long long sum = 0;                                              \
+      while (received < share) {                                               \
+        uint j, want = share - received;                                       \
+        uint n = queue_dequeue_batch_##type(                                   \
+            queue, batch, want < QUEUE_BATCH ? want : QUEUE_BATCH);            \
+        for (j = 0; j < n; ++j) {                                              \
+          sum += (uintptr_t)batch[j];                                          \
+        }                                                                      \
+        received += n;                                                         \
+      }                                                                        \
+      ATOMIC_ADD(&obj->checksum, sum);                                         \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, "batch " #type);              \
+    check_checksum(obj);                                                       \
+  }
+
+CREATE_QUEUE_TESTER(locked)
+CREATE_QUEUE_TESTER(ring)
+CREATE_QUEUE_TESTER(MS)
+CREATE_BATCH_QUEUE_TESTER(ring)
+CREATE_BATCH_QUEUE_TESTER(MS)
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  if (thread_current_id() == 0) {
+    printf("\tTesting queues with %u producers, %u consumers...\n",
+           obj->producers, obj->thread_num - obj->producers);
+  }
+  test_queue_locked(&obj->queue_locked, obj);
+  test_queue_ring(&obj->queue_ring, obj);
+  test_queue_MS(&obj->queue_MS, obj);
+  test_queue_batch_ring(&obj->queue_ring, obj);
+  test_queue_batch_MS(&obj->queue_MS, obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    int producers = (argc > 3) ? atoi(argv[3]) : t_num / 2;
+    if (t_num > 1 && producers > 0 && producers < t_num) {
+      int retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      obj.producers = producers;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      atomic_init(&obj.checksum, 0);
+      queue_init_locked(&obj.queue_locked, QUEUE_CAPACITY);
+      queue_init_ring(&obj.queue_ring, QUEUE_CAPACITY);
+      queue_init_MS(&obj.queue_MS, t_num);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      queue_destroy_MS(&obj.queue_MS);
+      queue_destroy_ring(&obj.queue_ring);
+      queue_destroy_locked(&obj.queue_locked);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      printf("USAGE:\n\t%s <#threads> <#repetitions> [#producers]\n",
+             argv[0]);
+      return -3;
+    }
+  } else {
+    printf("USAGE:\n\t%s <#threads> <#repetitions> [#producers]\n", argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,277 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define LIST_KEY_RANGE 1024
+#define LIST_UPDATE_PERCENT 10
+
+/* Read-heavy workload: a sorted linked list whose readers never lock, while
+ * writers are serialized by a ticket lock. A writer marks the low bit of a
+ * node's `next` before unlinking it, so a reader that validates
+ * `prev->next == cur` knows that both nodes were still in the list. */
+
+typedef struct LIST_NODE {
+  atomic_uintptr_t next;
+  uint key;
+  struct timespec retired_at;
+} list_node_t;
+
+typedef struct {
+  list_node_t head;
+  mutex_ticket_t mutex;
+} list_t;
+
+typedef struct {
+  unsigned long retired, reclaimed, peak_pending;
+  double latency;
+} reclaim_stats_t;
+
+AVOID_FALSE_SHARING(reclaim_stats_t, padded_reclaim_stats_t)
+
+static padded_reclaim_stats_t *stats;
+
+static list_node_t *pointer_of(uintptr_t link) {
+  return (list_node_t *)(link & ~(uintptr_t)1);
+}
+
+static void node_retired(list_node_t *node) {
+  reclaim_stats_t *s = &stats[thread_current_id()].value;
+  clock_gettime(CLOCK_MONOTONIC, &node->retired_at);
+  ++s->retired;
+  if (s->retired - s->reclaimed > s->peak_pending) {
+    s->peak_pending = s->retired - s->reclaimed;
+  }
+}
+
+static void node_reclaim(void *ptr) {
+  list_node_t *node = (list_node_t *)ptr;
+  reclaim_stats_t *s = &stats[thread_current_id()].value;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  s->latency += (double)(now.tv_sec - node->retired_at.tv_sec) +
+                1e-9 * (double)(now.tv_nsec - node->retired_at.tv_nsec);
+  ++s->reclaimed;
+  free(node);
+}
+
+static void list_init(list_t *list) {
+  atomic_init(&list->head.next, (uintptr_t)NULL);
+  mutex_init_ticket(&list->mutex);
+}
+
+static void list_destroy(list_t *list) {
+  list_node_t *node = pointer_of(ATOMIC_LOAD(&list->head.next));
+  while (node != NULL) {
+    list_node_t *next = pointer_of(ATOMIC_LOAD(&node->next));
+    free(node);
+    node = next;
+  }
+}
+
+/* Writers hold the mutex, and only writers free nodes, so no protection is
+ * needed while searching. */
+static list_node_t *list_locate(list_t *list, uint key, list_node_t **cur) {
+  list_node_t *prev = &list->head;
+  *cur = pointer_of(ATOMIC_LOAD(&prev->next));
+  while (*cur != NULL && (*cur)->key < key) {
+    prev = *cur;
+    *cur = pointer_of(ATOMIC_LOAD(&prev->next));
+  }
+  return prev;
+}
+
+static bool list_insert(list_t *list, uint key) {
+  list_node_t *prev, *cur, *node;
+  bool inserted = false;
+  mutex_lock_ticket(&list->mutex);
+  prev = list_locate(list, key, &cur);
+  if (cur == NULL || cur->key != key) {
+    node = (list_node_t *)malloc(sizeof(list_node_t));
+    node->key = key;
+    atomic_init(&node->next, (uintptr_t)cur);
+    ATOMIC_RELEASE(&prev->next, (uintptr_t)node);
+    inserted = true;
+  }
+  mutex_unlock_ticket(&list->mutex);
+  return inserted;
+}
+
+static list_node_t *list_remove(list_t *list, uint key) {
+  list_node_t *prev, *cur;
+  mutex_lock_ticket(&list->mutex);
+  prev = list_locate(list, key, &cur);
+  if (cur != NULL && cur->key == key) {
+    uintptr_t next = ATOMIC_LOAD(&cur->next);
+    ATOMIC_STORE(&cur->next, next | 1);
+    ATOMIC_RELEASE(&prev->next, next);
+  } else {
+    cur = NULL;
+  }
+  mutex_unlock_ticket(&list->mutex);
+  return cur;
+}
+
+static bool list_contains_hazard(list_t *list, reclaim_hazard_t *domain,
+                                 uint key) {
+  list_node_t *prev, *cur;
+  uint slot;
+retry:
+  prev = &list->head;
+  cur = pointer_of(ATOMIC_ACQUIRE(&prev->next));
+  slot = 0;
+  while (cur != NULL) {
+    reclaim_protect_hazard(domain, slot, cur);
+    if (ATOMIC_ACQUIRE(&prev->next) != (uintptr_t)cur) {
+      goto retry;
+    }
+    if (cur->key >= key) {
+      break;
+    }
+    prev = cur;
+    cur = pointer_of(ATOMIC_ACQUIRE(&cur->next));
+    slot ^= 1;
+  }
+  reclaim_release_hazard(domain);
+  return cur != NULL && cur->key == key;
+}
+
+static bool list_contains_epoch(list_t *list, uint key) {
+  list_node_t *cur = pointer_of(ATOMIC_ACQUIRE(&list->head.next));
+  while (cur != NULL && cur->key < key) {
+    cur = pointer_of(ATOMIC_ACQUIRE(&cur->next));
+  }
+  return cur != NULL && cur->key == key;
+}
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  list_t list_hazard;
+  list_t list_epoch;
+  reclaim_hazard_t reclaim_hazard;
+  reclaim_epoch_t reclaim_epoch;
+  atomic_ulong found;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static void report(pthread_subroutine_args_t *obj, const char *name) {
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    int i;
+    reclaim_stats_t total = {0, 0, 0, 0.0};
+    for (i = 0; i < obj->thread_num; ++i) {
+      reclaim_stats_t *s = &stats[i].value;
+      total.retired += s->retired;
+      total.reclaimed += s->reclaimed;
+      total.peak_pending += s->peak_pending;
+      total.latency += s->latency;
+      s->retired = s->reclaimed = s->peak_pending = 0;
+      s->latency = 0.0;
+    }
+    printf("\t\t%s: retired %lu, reclaimed %lu, average latency %lfus, "
+           "peak pending %lu nodes (%lu bytes)\n",
+           name, total.retired, total.reclaimed,
+           total.reclaimed ? total.latency / total.reclaimed * 1e6 : 0.0,
+           total.peak_pending, total.peak_pending * sizeof(list_node_t));
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+}
+
+#define CREATE_RECLAIM_TESTER(type, enter, exit, contains, retire)             \
+  void test_reclaim_##type(list_t *list, reclaim_##type##_t *domain,           \
+                           pthread_subroutine_args_t *obj) {                   \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    unsigned long found = 0;                                                   \
+    uint64_t seed = 2463534242u + thread_current_id();                         \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      uint r = (uint)next_random(&seed);                                       \
+      uint key = (r >> 8) % LIST_KEY_RANGE;                                    \
+      uint op = r % 100;                                                       \
+      enter;                                                                   \
+      if (op >= LIST_UPDATE_PERCENT) {                                         \
+        found += contains;                                                     \
+      } else if (op % 2 == 0) {                                                \
+        list_insert(list, key);                                                \
+      } else {                                                                 \
+        list_node_t *node = list_remove(list, key);                            \
+        if (node != NULL) {                                                    \
+          node_retired(node);                                                  \
+          retire;                                                              \
+        }                                                                      \
+      }                                                                        \
+      exit;                                                                    \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #type);                       \
+    ATOMIC_ADD(&obj->found, found);                                            \
+    report(obj, #type);                                                        \
+  }
+
+CREATE_RECLAIM_TESTER(hazard, , , list_contains_hazard(list, domain, key),
+                      reclaim_retire_hazard(domain, node))
+CREATE_RECLAIM_TESTER(epoch, reclaim_enter_epoch(domain),
+                      reclaim_exit_epoch(domain),
+                      list_contains_epoch(list, key),
+                      reclaim_retire_epoch(domain, node))
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  if (thread_current_id() == 0) {
+    printf("\tTesting memory reclamation with %d%% updates...\n",
+           LIST_UPDATE_PERCENT);
+  }
+  test_reclaim_hazard(&obj->list_hazard, &obj->reclaim_hazard, obj);
+  test_reclaim_epoch(&obj->list_epoch, &obj->reclaim_epoch, obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int i, retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      stats = (padded_reclaim_stats_t *)calloc(t_num,
+                                               sizeof(padded_reclaim_stats_t));
+      assert(stats != NULL);
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      atomic_init(&obj.found, 0);
+      list_init(&obj.list_hazard);
+      list_init(&obj.list_epoch);
+      for (i = 0; i < LIST_KEY_RANGE; i += 2) {
+        list_insert(&obj.list_hazard, i);
+        list_insert(&obj.list_epoch, i);
+      }
+      reclaim_init_hazard(&obj.reclaim_hazard, t_num, node_reclaim);
+      reclaim_init_epoch(&obj.reclaim_epoch, t_num, node_reclaim);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      reclaim_destroy_epoch(&obj.reclaim_epoch);
+      reclaim_destroy_hazard(&obj.reclaim_hazard);
+      list_destroy(&obj.list_epoch);
+      list_destroy(&obj.list_hazard);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      free(stats);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,216 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CONFIG_FIELDS 4
+/* Thread 0 writes once per `period` operations, all others only read */
+#define READ_MOSTLY_PERIOD 1024
+#define WRITE_HEAVY_PERIOD 8
+/* Nodes the NUMA-aware locks split the threads into */
+#define NUMA_NODES 2
+
+/* A small configuration struct whose fields are always equal */
+typedef struct { uint fields[CONFIG_FIELDS]; } config_t;
+
+static void config_write(config_t *config) {
+  int i;
+  uint value = config->fields[0] + 1;
+  for (i = 0; i < CONFIG_FIELDS; ++i) {
+    config->fields[i] = value;
+  }
+}
+
+static void config_check(config_t *config) {
+  int i;
+  for (i = 1; i < CONFIG_FIELDS; ++i) {
+    assert(config->fields[i] == config->fields[0]);
+  }
+}
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  config_t config;
+  mutex_ticket_t mutex_ticket;
+  mutex_MCS_t mutex_MCS;
+  mutex_test_and_set_t mutex_test_and_set;
+  mutex_ticket_t bravo_mutex_ticket;
+  mutex_MCS_t bravo_mutex_MCS;
+  mutex_test_and_set_t bravo_mutex_test_and_set;
+  rwlock_BRAVO_t rwlock_BRAVO_ticket;
+  rwlock_BRAVO_t rwlock_BRAVO_MCS;
+  rwlock_BRAVO_t rwlock_BRAVO_test_and_set;
+  mutex_ticket_t flags_mutex_ticket;
+  mutex_MCS_t flags_mutex_MCS;
+  rwlock_flags_t rwlock_flags_ticket;
+  rwlock_flags_t rwlock_flags_MCS;
+  rwlock_NUMA_t rwlock_NUMA_writer;
+  rwlock_NUMA_t rwlock_NUMA_neutral;
+  pthread_rwlock_t rwlock_pthread;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+#define CREATE_RWLOCK_TESTER(name, own_decl, read_lock, read_unlock,           \
+                             write_lock, write_unlock)                         \
+  void test_rwlock_##name(pthread_subroutine_args_t *obj, int period) {        \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    bool writer = thread_current_id() == 0;                                    \
+    own_decl;                                                                  \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      if (writer && i % period == 0) {                                         \
+        write_lock;                                                            \
+        config_write(&obj->config);                                            \
+        write_unlock;                                                          \
+      } else {                                                                 \
+        read_lock;                                                             \
+        config_check(&obj->config);                                            \
+        read_unlock;                                                           \
+      }                                                                        \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+  }
+
+#define CREATE_BRAVO_TESTER(type, own_decl, own)                               \
+  CREATE_RWLOCK_TESTER(BRAVO_##type,                                           \
+                       own_decl; rwlock_BRAVO_token_t token;                   \
+                       token.ownership = own,                                  \
+                       rwlock_read_lock_BRAVO(&obj->rwlock_BRAVO_##type,       \
+                                              &token),                         \
+                       rwlock_read_unlock_BRAVO(&obj->rwlock_BRAVO_##type,     \
+                                                &token),                       \
+                       rwlock_write_lock_BRAVO(&obj->rwlock_BRAVO_##type,      \
+                                               own),                           \
+                       rwlock_write_unlock_BRAVO(&obj->rwlock_BRAVO_##type,    \
+                                                 own))
+
+#define CREATE_FLAGS_TESTER(type, own_decl, own)                               \
+  CREATE_RWLOCK_TESTER(flags_##type, own_decl,                                 \
+                       rwlock_read_lock_flags(&obj->rwlock_flags_##type),      \
+                       rwlock_read_unlock_flags(&obj->rwlock_flags_##type),    \
+                       rwlock_write_lock_flags(&obj->rwlock_flags_##type,      \
+                                               own),                           \
+                       rwlock_write_unlock_flags(&obj->rwlock_flags_##type,    \
+                                                 own))
+
+#define CREATE_NUMA_TESTER(preference)                                         \
+  CREATE_RWLOCK_TESTER(                                                        \
+      NUMA_##preference, mutex_MCS_ownership_t ownership,                      \
+      rwlock_read_lock_NUMA(&obj->rwlock_NUMA_##preference, &ownership),       \
+      rwlock_read_unlock_NUMA(&obj->rwlock_NUMA_##preference),                 \
+      rwlock_write_lock_NUMA(&obj->rwlock_NUMA_##preference, &ownership),      \
+      rwlock_write_unlock_NUMA(&obj->rwlock_NUMA_##preference, &ownership))
+
+CREATE_RWLOCK_TESTER(ticket, , mutex_lock_ticket(&obj->mutex_ticket),
+                     mutex_unlock_ticket(&obj->mutex_ticket),
+                     mutex_lock_ticket(&obj->mutex_ticket),
+                     mutex_unlock_ticket(&obj->mutex_ticket))
+CREATE_RWLOCK_TESTER(MCS, mutex_MCS_ownership_t ownership,
+                     mutex_lock_MCS(&obj->mutex_MCS, &ownership),
+                     mutex_unlock_MCS(&obj->mutex_MCS, &ownership),
+                     mutex_lock_MCS(&obj->mutex_MCS, &ownership),
+                     mutex_unlock_MCS(&obj->mutex_MCS, &ownership))
+CREATE_RWLOCK_TESTER(test_and_set, ,
+                     mutex_lock_test_and_set(&obj->mutex_test_and_set),
+                     mutex_unlock_test_and_set(&obj->mutex_test_and_set),
+                     mutex_lock_test_and_set(&obj->mutex_test_and_set),
+                     mutex_unlock_test_and_set(&obj->mutex_test_and_set))
+CREATE_BRAVO_TESTER(ticket, , NULL)
+CREATE_BRAVO_TESTER(MCS, mutex_MCS_ownership_t ownership, &ownership)
+CREATE_BRAVO_TESTER(test_and_set, , NULL)
+CREATE_FLAGS_TESTER(ticket, , NULL)
+CREATE_FLAGS_TESTER(MCS, mutex_MCS_ownership_t ownership, &ownership)
+CREATE_NUMA_TESTER(writer)
+CREATE_NUMA_TESTER(neutral)
+CREATE_RWLOCK_TESTER(rwlock_pthread, ,
+                     pthread_rwlock_rdlock(&obj->rwlock_pthread),
+                     pthread_rwlock_unlock(&obj->rwlock_pthread),
+                     pthread_rwlock_wrlock(&obj->rwlock_pthread),
+                     pthread_rwlock_unlock(&obj->rwlock_pthread))
+
+static void test_all(pthread_subroutine_args_t *obj, int period) {
+  if (thread_current_id() == 0) {
+    printf("\tTesting with one write per %d operations...\n", period);
+  }
+  test_rwlock_ticket(obj, period);
+  test_rwlock_BRAVO_ticket(obj, period);
+  test_rwlock_flags_ticket(obj, period);
+  test_rwlock_MCS(obj, period);
+  test_rwlock_BRAVO_MCS(obj, period);
+  test_rwlock_flags_MCS(obj, period);
+  test_rwlock_NUMA_writer(obj, period);
+  test_rwlock_NUMA_neutral(obj, period);
+  test_rwlock_test_and_set(obj, period);
+  test_rwlock_BRAVO_test_and_set(obj, period);
+  test_rwlock_rwlock_pthread(obj, period);
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  test_all(obj, READ_MOSTLY_PERIOD);
+  test_all(obj, WRITE_HEAVY_PERIOD);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int i, retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      for (i = 0; i < CONFIG_FIELDS; ++i) {
+        obj.config.fields[i] = 0;
+      }
+      mutex_init_ticket(&obj.mutex_ticket);
+      mutex_init_MCS(&obj.mutex_MCS);
+      mutex_init_test_and_set(&obj.mutex_test_and_set);
+      mutex_init_ticket(&obj.bravo_mutex_ticket);
+      mutex_init_MCS(&obj.bravo_mutex_MCS);
+      mutex_init_test_and_set(&obj.bravo_mutex_test_and_set);
+      rwlock_init_BRAVO(&obj.rwlock_BRAVO_ticket, &obj.bravo_mutex_ticket,
+                        &rwlock_mutex_ticket);
+      rwlock_init_BRAVO(&obj.rwlock_BRAVO_MCS, &obj.bravo_mutex_MCS,
+                        &rwlock_mutex_MCS);
+      rwlock_init_BRAVO(&obj.rwlock_BRAVO_test_and_set,
+                        &obj.bravo_mutex_test_and_set,
+                        &rwlock_mutex_test_and_set);
+      mutex_init_ticket(&obj.flags_mutex_ticket);
+      mutex_init_MCS(&obj.flags_mutex_MCS);
+      rwlock_init_flags(&obj.rwlock_flags_ticket, t_num,
+                        &obj.flags_mutex_ticket, &rwlock_mutex_ticket);
+      rwlock_init_flags(&obj.rwlock_flags_MCS, t_num, &obj.flags_mutex_MCS,
+                        &rwlock_mutex_MCS);
+      rwlock_init_NUMA(&obj.rwlock_NUMA_writer, t_num, NUMA_NODES, true);
+      rwlock_init_NUMA(&obj.rwlock_NUMA_neutral, t_num, NUMA_NODES, false);
+      pthread_rwlock_init(&obj.rwlock_pthread, NULL);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      pthread_rwlock_destroy(&obj.rwlock_pthread);
+      rwlock_destroy_flags(&obj.rwlock_flags_ticket);
+      rwlock_destroy_flags(&obj.rwlock_flags_MCS);
+      rwlock_destroy_NUMA(&obj.rwlock_NUMA_writer);
+      rwlock_destroy_NUMA(&obj.rwlock_NUMA_neutral);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,160 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CONFIG_FIELDS 4
+/* Thread 0 writes once per `WRITE_PERIOD` operations, all others only read */
+#define WRITE_PERIOD 64
+
+/* A small configuration struct whose fields are always equal */
+typedef struct { atomic_uint fields[CONFIG_FIELDS]; } config_t;
+
+typedef struct {
+  config_t *config;
+  uint snapshot[CONFIG_FIELDS];
+} config_reader_t;
+
+static void config_read(void *arg) {
+  config_reader_t *reader = (config_reader_t *)arg;
+  int i;
+  for (i = 0; i < CONFIG_FIELDS; ++i) {
+    reader->snapshot[i] = ATOMIC_LOAD(&reader->config->fields[i]);
+  }
+}
+
+static void config_write(config_t *config) {
+  int i;
+  uint value = ATOMIC_LOAD(&config->fields[0]) + 1;
+  for (i = 0; i < CONFIG_FIELDS; ++i) {
+    ATOMIC_STORE(&config->fields[i], value);
+  }
+}
+
+static void config_check(config_reader_t *reader) {
+  int i;
+  for (i = 1; i < CONFIG_FIELDS; ++i) {
+    assert(reader->snapshot[i] == reader->snapshot[0]);
+  }
+}
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  config_t config;
+  seqlock_ticket_t seqlock_ticket;
+  seqlock_versioned_t seqlock_versioned;
+  mutex_ticket_t mutex_ticket;
+  pthread_rwlock_t rwlock_pthread;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+#define CREATE_SEQLOCK_TESTER(name, read_section, write_section)               \
+  void test_seqlock_##name(pthread_subroutine_args_t *obj) {                   \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    config_reader_t reader = {&obj->config, {0}};                              \
+    bool writer = thread_current_id() == 0;                                    \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      if (writer && i % WRITE_PERIOD == 0) {                                   \
+        write_section;                                                         \
+      } else {                                                                 \
+        read_section;                                                          \
+        config_check(&reader);                                                 \
+      }                                                                        \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+  }
+
+CREATE_SEQLOCK_TESTER(ticket, {
+  uint start;
+  do {
+    start = seqlock_read_begin_ticket(&obj->seqlock_ticket);
+    config_read(&reader);
+  } while (seqlock_read_retry_ticket(&obj->seqlock_ticket, start));
+}, {
+  seqlock_write_lock_ticket(&obj->seqlock_ticket);
+  config_write(&obj->config);
+  seqlock_write_unlock_ticket(&obj->seqlock_ticket);
+})
+
+CREATE_SEQLOCK_TESTER(versioned, {
+  seqlock_read_versioned(&obj->seqlock_versioned, config_read, &reader);
+}, {
+  seqlock_write_lock_versioned(&obj->seqlock_versioned);
+  config_write(&obj->config);
+  seqlock_write_unlock_versioned(&obj->seqlock_versioned);
+})
+
+CREATE_SEQLOCK_TESTER(mutex_ticket, {
+  mutex_lock_ticket(&obj->mutex_ticket);
+  config_read(&reader);
+  mutex_unlock_ticket(&obj->mutex_ticket);
+}, {
+  mutex_lock_ticket(&obj->mutex_ticket);
+  config_write(&obj->config);
+  mutex_unlock_ticket(&obj->mutex_ticket);
+})
+
+CREATE_SEQLOCK_TESTER(rwlock_pthread, {
+  pthread_rwlock_rdlock(&obj->rwlock_pthread);
+  config_read(&reader);
+  pthread_rwlock_unlock(&obj->rwlock_pthread);
+}, {
+  pthread_rwlock_wrlock(&obj->rwlock_pthread);
+  config_write(&obj->config);
+  pthread_rwlock_unlock(&obj->rwlock_pthread);
+})
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  if (thread_current_id() == 0) {
+    printf("\tTesting read paths with one write per %d operations...\n",
+           WRITE_PERIOD);
+  }
+  test_seqlock_ticket(obj);
+  test_seqlock_versioned(obj);
+  test_seqlock_mutex_ticket(obj);
+  test_seqlock_rwlock_pthread(obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int i, retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      for (i = 0; i < CONFIG_FIELDS; ++i) {
+        atomic_init(&obj.config.fields[i], 0);
+      }
+      seqlock_init_ticket(&obj.seqlock_ticket);
+      seqlock_init_versioned(&obj.seqlock_versioned);
+      mutex_init_ticket(&obj.mutex_ticket);
+      pthread_rwlock_init(&obj.rwlock_pthread, NULL);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      pthread_rwlock_destroy(&obj.rwlock_pthread);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
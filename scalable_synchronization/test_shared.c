@@ -0,0 +1,254 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Every participant is a process of its own, forked after the segment is
+ * mapped; the parent is participant 0 and prints the results. The shared
+ * locks follow the fixed part of the segment, each at a cache line aligned
+ * offset. */
+
+#define ALIGN_LINE(size)                                                       \
+  (((size) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE)
+
+typedef struct {
+  int process_num;
+  int repetitions;
+  unsigned long counter;
+  shared_registry_t registry;
+  pthread_mutex_t mutex_pthread;
+  pthread_barrier_t barrier_pthread;
+  barrier_shared_futex_t barrier_shared_futex;
+  pthread_barrier_t barrier_aux;
+  size_t MCS_offset, Anderson_offset, CLH_offset, slots_offset;
+} segment_t;
+
+static mutex_shared_MCS_t *segment_MCS(segment_t *segment) {
+  return (mutex_shared_MCS_t *)((char *)segment + segment->MCS_offset);
+}
+
+static mutex_shared_Anderson_t *segment_Anderson(segment_t *segment) {
+  return (mutex_shared_Anderson_t *)((char *)segment +
+                                     segment->Anderson_offset);
+}
+
+static mutex_shared_CLH_t *segment_CLH(segment_t *segment) {
+  return (mutex_shared_CLH_t *)((char *)segment + segment->CLH_offset);
+}
+
+/* Two rows of one slot per participant */
+static uint *segment_slots(segment_t *segment, int row) {
+  return (uint *)((char *)segment + segment->slots_offset) +
+         row * segment->process_num;
+}
+
+static void check_counter(segment_t *segment) {
+  pthread_barrier_wait(&segment->barrier_aux);
+  if (shared_current_id() == 0) {
+    assert(segment->counter ==
+           (unsigned long)segment->process_num * segment->repetitions);
+    segment->counter = 0;
+  }
+  pthread_barrier_wait(&segment->barrier_aux);
+}
+
+static void check_slots(segment_t *segment) {
+  int i;
+  pthread_barrier_wait(&segment->barrier_aux);
+  if (shared_current_id() == 0) {
+    for (i = 0; i < segment->process_num; ++i) {
+      assert(segment_slots(segment, segment->repetitions % 2)[i] ==
+             (uint)segment->repetitions);
+      segment_slots(segment, 0)[i] = segment_slots(segment, 1)[i] = 0;
+    }
+  }
+  pthread_barrier_wait(&segment->barrier_aux);
+}
+
+#define CREATE_MUTEX_TESTER(name, own_decl, lock, unlock)                      \
+  void test_mutex_##name(segment_t *segment) {                                 \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    own_decl;                                                                  \
+    tic(&t, &segment->barrier_aux);                                            \
+    for (i = 0; i < segment->repetitions; ++i) {                               \
+      lock;                                                                    \
+      ++segment->counter;                                                      \
+      unlock;                                                                  \
+    }                                                                          \
+    toc(&t, &segment->barrier_aux, segment->repetitions, #name);               \
+    check_counter(segment);                                                    \
+  }
+
+/* In episode `i` each participant copies its neighbor's slot of episode
+ * `i - 1` plus one, so all slots count the episodes */
+#define CREATE_BARRIER_TESTER(name, wait)                                      \
+  void test_barrier_##name(segment_t *segment) {                               \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    uint id = shared_current_id();                                             \
+    uint neighbor = (id + 1) % segment->process_num;                           \
+    tic(&t, &segment->barrier_aux);                                            \
+    for (i = 0; i < segment->repetitions; ++i) {                               \
+      segment_slots(segment, (i + 1) % 2)[id] =                                \
+          segment_slots(segment, i % 2)[neighbor] + 1;                         \
+      wait;                                                                    \
+    }                                                                          \
+    toc(&t, &segment->barrier_aux, segment->repetitions, #name);               \
+    check_slots(segment);                                                      \
+  }
+
+CREATE_MUTEX_TESTER(shared_MCS, , mutex_lock_shared_MCS(segment_MCS(segment)),
+                    mutex_unlock_shared_MCS(segment_MCS(segment)))
+CREATE_MUTEX_TESTER(shared_Anderson, mutex_Anderson_ownership_t ownership,
+                    mutex_lock_shared_Anderson(segment_Anderson(segment),
+                                               &ownership),
+                    mutex_unlock_shared_Anderson(segment_Anderson(segment),
+                                                 &ownership))
+CREATE_MUTEX_TESTER(shared_CLH, , mutex_lock_shared_CLH(segment_CLH(segment)),
+                    mutex_unlock_shared_CLH(segment_CLH(segment)))
+CREATE_MUTEX_TESTER(pthread, ,
+                    pthread_mutex_lock(&segment->mutex_pthread),
+                    pthread_mutex_unlock(&segment->mutex_pthread))
+CREATE_BARRIER_TESTER(shared_futex,
+                      barrier_wait_shared_futex(&segment->barrier_shared_futex))
+CREATE_BARRIER_TESTER(pthread, pthread_barrier_wait(&segment->barrier_pthread))
+
+static void join(segment_t *segment) {
+  int joined = shared_registry_join(&segment->registry);
+  assert(joined == SUCCESS);
+  /* `tic` and `toc` report from thread 0 */
+  thread_set_id(shared_current_id());
+}
+
+static void participate(segment_t *segment) {
+  if (shared_current_id() == 0) {
+    puts("\tTesting mutexes...");
+  }
+  test_mutex_shared_MCS(segment);
+  test_mutex_shared_Anderson(segment);
+  test_mutex_shared_CLH(segment);
+  test_mutex_pthread(segment);
+  if (shared_current_id() == 0) {
+    puts("\tTesting barriers...");
+  }
+  test_barrier_shared_futex(segment);
+  test_barrier_pthread(segment);
+}
+
+static segment_t *segment_create(int p_num, int repetitions, size_t *size) {
+  segment_t *segment;
+  pthread_mutexattr_t mutex_attr;
+  pthread_barrierattr_t barrier_attr;
+  size_t MCS_offset = ALIGN_LINE(sizeof(segment_t));
+  size_t Anderson_offset =
+      MCS_offset + ALIGN_LINE(mutex_size_shared_MCS(p_num));
+  size_t CLH_offset =
+      Anderson_offset + ALIGN_LINE(mutex_size_shared_Anderson(p_num));
+  size_t slots_offset = CLH_offset + ALIGN_LINE(mutex_size_shared_CLH(p_num));
+  *size = slots_offset + sizeof(uint) * 2 * p_num;
+
+  segment = (segment_t *)mmap(NULL, *size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (segment == MAP_FAILED) {
+    return NULL;
+  }
+  segment->process_num = p_num;
+  segment->repetitions = repetitions;
+  segment->counter = 0;
+  segment->MCS_offset = MCS_offset;
+  segment->Anderson_offset = Anderson_offset;
+  segment->CLH_offset = CLH_offset;
+  segment->slots_offset = slots_offset;
+  shared_registry_init(&segment->registry, p_num);
+  mutex_init_shared_MCS(segment_MCS(segment), p_num);
+  mutex_init_shared_Anderson(segment_Anderson(segment), p_num);
+  mutex_init_shared_CLH(segment_CLH(segment), p_num);
+  barrier_init_shared_futex(&segment->barrier_shared_futex, p_num);
+
+  pthread_mutexattr_init(&mutex_attr);
+  pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutex_init(&segment->mutex_pthread, &mutex_attr);
+  pthread_mutexattr_destroy(&mutex_attr);
+  pthread_barrierattr_init(&barrier_attr);
+  pthread_barrierattr_setpshared(&barrier_attr, PTHREAD_PROCESS_SHARED);
+  pthread_barrier_init(&segment->barrier_pthread, &barrier_attr, p_num);
+  pthread_barrier_init(&segment->barrier_aux, &barrier_attr, p_num);
+  pthread_barrierattr_destroy(&barrier_attr);
+  return segment;
+}
+
+static void segment_destroy(segment_t *segment, size_t size) {
+  pthread_mutex_destroy(&segment->mutex_pthread);
+  pthread_barrier_destroy(&segment->barrier_pthread);
+  pthread_barrier_destroy(&segment->barrier_aux);
+  munmap(segment, size);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    int p_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (p_num > 0) {
+      int i, status, retval = SUCCESS;
+      size_t size;
+      pid_t *children;
+      segment_t *segment = segment_create(p_num, repetitions, &size);
+      if (segment == NULL) {
+        printf("\tCannot map a shared segment of %lu bytes\n",
+               (unsigned long)size);
+        return OUT_OF_MEMORY;
+      }
+      children = (pid_t *)malloc(sizeof(pid_t) * p_num);
+      assert(children != NULL);
+      printf("Testing with %d processes, %d repetitions...\n", p_num,
+             repetitions);
+      /* The parent joins first and prints as participant 0 */
+      join(segment);
+      fflush(stdout);
+
+      for (i = 1; i < p_num; ++i) {
+        children[i] = fork();
+        if (children[i] == 0) {
+          join(segment);
+          participate(segment);
+          _exit(0);
+        } else if (children[i] < 0) {
+          /* The children forked so far wait for the rest at the first
+           * barrier, forever */
+          printf("\tCannot fork participant %d\n", i);
+          while (--i > 0) {
+            kill(children[i], SIGKILL);
+            waitpid(children[i], &status, 0);
+          }
+          free(children);
+          /* Not destroyed: the barrier still counts the killed waiters */
+          munmap(segment, size);
+          return -2;
+        }
+      }
+      participate(segment);
+      for (i = 1; i < p_num; ++i) {
+        if (waitpid(children[i], &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+          retval = -2;
+        }
+      }
+      free(children);
+      segment_destroy(segment, size);
+      return retval;
+    } else {
+      printf("USAGE:\n\t%s <#processes> <#repetitions>\n", argv[0]);
+      return -3;
+    }
+  } else {
+    printf("USAGE:\n\t%s <#processes> <#repetitions>\n", argv[0]);
+    return -3;
+  }
+}
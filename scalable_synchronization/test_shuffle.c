@@ -0,0 +1,158 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Threads are split into two simulated sockets by parity, and thread 0 is
+ * the only latency-critical thread. Every acquisition records whether the
+ * previous owner had the same socket, and how long the thread waited. */
+
+#define SOCKETS 2
+
+typedef struct { double wait; } shuffle_stats_t;
+
+AVOID_FALSE_SHARING(shuffle_stats_t, padded_shuffle_stats_t)
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  int test_shared[2];
+  uint last_socket;
+  unsigned long same_socket;
+  padded_shuffle_stats_t *stats;
+  mutex_MCS_t mutex_MCS;
+  mutex_shuffle_t mutex_shuffle_socket;
+  mutex_shuffle_t mutex_shuffle_priority;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+}
+
+static void critical_section(pthread_subroutine_args_t *obj, uint socket) {
+  ++obj->test_shared[1];
+  assert(obj->test_shared[1] == 1);
+  ++obj->test_shared[0];
+  obj->same_socket += (obj->last_socket == socket);
+  obj->last_socket = socket;
+  --obj->test_shared[1];
+}
+
+static void report(pthread_subroutine_args_t *obj) {
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    int i;
+    double others = 0.0;
+    unsigned long total = (unsigned long)obj->thread_num * obj->repetitions;
+    assert(obj->test_shared[0] == (int)total);
+    for (i = 1; i < obj->thread_num; ++i) {
+      others += obj->stats[i].value.wait;
+    }
+    printf("\t\t\tsame-socket handoffs %.1f%%, average wait thread 0 %lfus, "
+           "others %lfus\n",
+           100.0 * obj->same_socket / total,
+           obj->stats[0].value.wait / obj->repetitions * 1e6,
+           (obj->thread_num > 1)
+               ? others / (total - obj->repetitions) * 1e6
+               : 0.0);
+    obj->test_shared[0] = 0;
+    obj->same_socket = 0;
+    for (i = 0; i < obj->thread_num; ++i) {
+      obj->stats[i].value.wait = 0.0;
+    }
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+}
+
+#define CREATE_SHUFFLE_TESTER(name, own_decl, lock, unlock)                    \
+  void test_mutex_##name(pthread_subroutine_args_t *obj) {                     \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    uint tid = thread_current_id(), socket = tid % SOCKETS;                    \
+    shuffle_stats_t *stats = &obj->stats[tid].value;                           \
+    own_decl;                                                                  \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      double start = now();                                                    \
+      lock;                                                                    \
+      stats->wait += now() - start;                                            \
+      critical_section(obj, socket);                                           \
+      unlock;                                                                  \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+    report(obj);                                                               \
+  }
+
+CREATE_SHUFFLE_TESTER(MCS, mutex_MCS_ownership_t ownership,
+                      mutex_lock_MCS(&obj->mutex_MCS, &ownership),
+                      mutex_unlock_MCS(&obj->mutex_MCS, &ownership))
+CREATE_SHUFFLE_TESTER(shuffle_socket,
+                      mutex_shuffle_ownership_t ownership;
+                      ownership.key = socket,
+                      mutex_lock_shuffle(&obj->mutex_shuffle_socket,
+                                         &ownership),
+                      mutex_unlock_shuffle(&obj->mutex_shuffle_socket,
+                                           &ownership))
+CREATE_SHUFFLE_TESTER(shuffle_priority,
+                      mutex_shuffle_ownership_t ownership;
+                      ownership.key = (tid == 0),
+                      mutex_lock_shuffle(&obj->mutex_shuffle_priority,
+                                         &ownership),
+                      mutex_unlock_shuffle(&obj->mutex_shuffle_priority,
+                                           &ownership))
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  if (thread_current_id() == 0) {
+    printf("\tTesting with %d simulated sockets...\n", SOCKETS);
+  }
+  test_mutex_MCS(obj);
+  test_mutex_shuffle_socket(obj);
+  test_mutex_shuffle_priority(obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      obj.stats = (padded_shuffle_stats_t *)calloc(
+          t_num, sizeof(padded_shuffle_stats_t));
+      assert(obj.stats != NULL);
+      obj.test_shared[0] = obj.test_shared[1] = 0;
+      obj.last_socket = 0;
+      obj.same_socket = 0;
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      mutex_init_MCS(&obj.mutex_MCS);
+      mutex_init_shuffle(&obj.mutex_shuffle_socket, mutex_shuffle_same_key);
+      mutex_init_shuffle(&obj.mutex_shuffle_priority, mutex_shuffle_priority);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      pthread_barrier_destroy(&obj.barrier_aux);
+      free(obj.stats);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
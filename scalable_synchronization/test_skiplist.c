@@ -0,0 +1,389 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The skip list against a binary search tree guarded by one MCS lock, over
+ * uniform keys so that the tree stays balanced in expectation. Each run
+ * starts with the even keys of its range and splits its updates evenly
+ * between puts and removes. Values always encode their key, so every read
+ * is checked, and the final size is checked against the updates that took
+ * effect. */
+
+#define STRINGIFY(x_) #x_
+#define NAME(x_) STRINGIFY(x_)
+
+static const unsigned long key_ranges[] = {1 << 8, 1 << 12, 1 << 16};
+static const uint update_percents[] = {0, 10, 50};
+#define KEY_RANGES (sizeof(key_ranges) / sizeof(key_ranges[0]))
+#define UPDATE_PERCENTS (sizeof(update_percents) / sizeof(update_percents[0]))
+/* Odd, so that multiplying by it shuffles the even keys of a power of two
+ * range; the tree would be a list if they were put in order */
+#define PREFILL_STRIDE 0x9e3779b97f4a7c15ul
+/* Keys each thread puts in one batch */
+#define BATCH 64
+
+typedef struct TREE_NODE {
+  unsigned long key, value;
+  struct TREE_NODE *left, *right;
+} tree_node_t;
+
+typedef struct {
+  tree_node_t *root;
+  mutex_MCS_t lock;
+} tree_t;
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  unsigned long key_range;
+  atomic_long size;
+  skiplist_t skiplist;
+  tree_t tree;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+/* Returns the link to `key`, or to where it would be */
+static tree_node_t **tree_find(tree_t *tree, unsigned long key) {
+  tree_node_t **link = &tree->root;
+  while (*link != NULL && (*link)->key != key) {
+    link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+  }
+  return link;
+}
+
+static bool tree_get(tree_t *tree, unsigned long key, unsigned long *value) {
+  mutex_MCS_ownership_t ownership;
+  tree_node_t *node;
+  mutex_lock_MCS(&tree->lock, &ownership);
+  node = *tree_find(tree, key);
+  if (node != NULL) {
+    *value = node->value;
+  }
+  mutex_unlock_MCS(&tree->lock, &ownership);
+  return node != NULL;
+}
+
+static bool tree_put(tree_t *tree, unsigned long key, unsigned long value) {
+  mutex_MCS_ownership_t ownership;
+  tree_node_t **link;
+  bool inserted = false;
+  mutex_lock_MCS(&tree->lock, &ownership);
+  link = tree_find(tree, key);
+  if (*link != NULL) {
+    (*link)->value = value;
+  } else if ((*link = (tree_node_t *)slab_alloc(sizeof(tree_node_t))) !=
+             NULL) {
+    (*link)->key = key;
+    (*link)->value = value;
+    (*link)->left = (*link)->right = NULL;
+    inserted = true;
+  }
+  mutex_unlock_MCS(&tree->lock, &ownership);
+  return inserted;
+}
+
+static bool tree_remove(tree_t *tree, unsigned long key) {
+  mutex_MCS_ownership_t ownership;
+  tree_node_t **link, *node;
+  mutex_lock_MCS(&tree->lock, &ownership);
+  link = tree_find(tree, key);
+  node = *link;
+  if (node != NULL) {
+    if (node->left == NULL || node->right == NULL) {
+      *link = (node->left != NULL) ? node->left : node->right;
+    } else {
+      /* Replaced by its successor */
+      tree_node_t **successor = &node->right;
+      while ((*successor)->left != NULL) {
+        successor = &(*successor)->left;
+      }
+      *link = *successor;
+      *successor = (*successor)->right;
+      (*link)->left = node->left;
+      (*link)->right = node->right;
+    }
+  }
+  mutex_unlock_MCS(&tree->lock, &ownership);
+  slab_free(node);
+  return node != NULL;
+}
+
+static uint tree_range_from(tree_node_t *node, unsigned long low,
+                            unsigned long high, unsigned long *keys,
+                            unsigned long *values, uint max) {
+  uint count = 0;
+  if (node == NULL || max == 0) {
+    return 0;
+  }
+  if (low < node->key) {
+    count = tree_range_from(node->left, low, high, keys, values, max);
+  }
+  if (count < max && low <= node->key && node->key <= high) {
+    keys[count] = node->key;
+    values[count] = node->value;
+    ++count;
+  }
+  if (node->key < high) {
+    count += tree_range_from(node->right, low, high, keys + count,
+                             values + count, max - count);
+  }
+  return count;
+}
+
+static uint tree_range(tree_t *tree, unsigned long low, unsigned long high,
+                       unsigned long *keys, unsigned long *values, uint max) {
+  mutex_MCS_ownership_t ownership;
+  uint count;
+  mutex_lock_MCS(&tree->lock, &ownership);
+  count = tree_range_from(tree->root, low, high, keys, values, max);
+  mutex_unlock_MCS(&tree->lock, &ownership);
+  return count;
+}
+
+static void tree_free(tree_node_t *node) {
+  if (node != NULL) {
+    tree_free(node->left);
+    tree_free(node->right);
+    slab_free(node);
+  }
+}
+
+static void check_value(pthread_subroutine_args_t *obj, unsigned long key,
+                        unsigned long value) {
+  assert(value % obj->key_range == key);
+}
+
+/* Quiescent check: a full scan is ascending, checked and of the expected
+ * size */
+static void check_range(pthread_subroutine_args_t *obj, const char *name,
+                        uint (*range)(pthread_subroutine_args_t *,
+                                      unsigned long *, unsigned long *, uint)) {
+  uint i, count, size = (uint)ATOMIC_LOAD(&obj->size);
+  unsigned long *keys = (unsigned long *)malloc(sizeof(long) * (size + 1));
+  unsigned long *values = (unsigned long *)malloc(sizeof(long) * (size + 1));
+  assert(keys != NULL && values != NULL);
+  count = range(obj, keys, values, size + 1);
+  if (count != size) {
+    printf("\t\t%s: %u keys found, %u expected\n", name, count, size);
+  }
+  assert(count == size);
+  for (i = 0; i < count; ++i) {
+    assert(i == 0 || keys[i - 1] < keys[i]);
+    check_value(obj, keys[i], values[i]);
+  }
+  free(keys);
+  free(values);
+}
+
+static uint range_skiplist(pthread_subroutine_args_t *obj, unsigned long *keys,
+                           unsigned long *values, uint max) {
+  return skiplist_range(&obj->skiplist, 0, obj->key_range - 1, keys, values,
+                        max);
+}
+
+static uint range_tree(pthread_subroutine_args_t *obj, unsigned long *keys,
+                       unsigned long *values, uint max) {
+  return tree_range(&obj->tree, 0, obj->key_range - 1, keys, values, max);
+}
+
+static bool get_skiplist(pthread_subroutine_args_t *obj, unsigned long key,
+                         unsigned long *value) {
+  return skiplist_get(&obj->skiplist, key, value);
+}
+
+static bool put_skiplist(pthread_subroutine_args_t *obj, unsigned long key,
+                         unsigned long value) {
+  return skiplist_put(&obj->skiplist, key, value);
+}
+
+static bool remove_skiplist(pthread_subroutine_args_t *obj,
+                            unsigned long key) {
+  return skiplist_remove(&obj->skiplist, key);
+}
+
+static void init_skiplist(pthread_subroutine_args_t *obj) {
+  int retval = skiplist_init(&obj->skiplist, obj->thread_num);
+  assert(retval == SUCCESS);
+  (void)retval;
+}
+
+static void destroy_skiplist(pthread_subroutine_args_t *obj) {
+  skiplist_destroy(&obj->skiplist);
+}
+
+static bool get_tree(pthread_subroutine_args_t *obj, unsigned long key,
+                     unsigned long *value) {
+  return tree_get(&obj->tree, key, value);
+}
+
+static bool put_tree(pthread_subroutine_args_t *obj, unsigned long key,
+                     unsigned long value) {
+  return tree_put(&obj->tree, key, value);
+}
+
+static bool remove_tree(pthread_subroutine_args_t *obj, unsigned long key) {
+  return tree_remove(&obj->tree, key);
+}
+
+static void init_tree(pthread_subroutine_args_t *obj) {
+  obj->tree.root = NULL;
+  mutex_init_MCS(&obj->tree.lock);
+}
+
+static void destroy_tree(pthread_subroutine_args_t *obj) {
+  tree_free(obj->tree.root);
+  obj->tree.root = NULL;
+}
+
+/* Thread 0 builds the set, every thread puts its share of the even keys,
+ * then runs the timed mix; thread 0 checks and frees the set at the end */
+#define CREATE_SET_TESTER(name)                                                \
+  void test_set_##name(pthread_subroutine_args_t *obj, uint update_percent) {  \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    uint64_t seed = 0x9e3779b97f4a7c15ull * (thread_current_id() + 1);         \
+    unsigned long key, value, version = 0;                                     \
+    long delta = 0;                                                            \
+    char label[64];                                                            \
+    if (thread_current_id() == 0) {                                            \
+      ATOMIC_STORE(&obj->size, 0);                                             \
+      init_##name(obj);                                                        \
+    }                                                                          \
+    pthread_barrier_wait(&obj->barrier_aux);                                   \
+    for (key = thread_current_id(); key < obj->key_range / 2;                  \
+         key += obj->thread_num) {                                             \
+      unsigned long even = 2 * (key * PREFILL_STRIDE % (obj->key_range / 2));  \
+      delta += put_##name(obj, even, even);                                    \
+    }                                                                          \
+    snprintf(label, sizeof(label), "%s, %u%% updates", #name,                  \
+             update_percent);                                                  \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      uint op = (uint)(next_random(&seed) % 200);                              \
+      key = next_random(&seed) % obj->key_range;                               \
+      if (op < update_percent) {                                               \
+        delta += put_##name(obj, key, key + obj->key_range * ++version);       \
+      } else if (op < 2 * update_percent) {                                    \
+        delta -= remove_##name(obj, key);                                      \
+      } else if (get_##name(obj, key, &value)) {                               \
+        check_value(obj, key, value);                                          \
+      }                                                                        \
+    }                                                                          \
+    ATOMIC_ADD(&obj->size, delta);                                             \
+    toc(&t, &obj->barrier_aux, obj->repetitions, label);                       \
+    if (thread_current_id() == 0) {                                            \
+      check_range(obj, #name, range_##name);                                   \
+      destroy_##name(obj);                                                     \
+    }                                                                          \
+    pthread_barrier_wait(&obj->barrier_aux);                                   \
+  }
+
+CREATE_SET_TESTER(skiplist)
+CREATE_SET_TESTER(tree)
+
+/* Every thread puts `repetitions` keys interleaved with everyone else's,
+ * one at a time or in ascending batches */
+#define CREATE_BATCH_TESTER(name)                                              \
+  void test_batch_##name(pthread_subroutine_args_t *obj) {                     \
+    my_time_t t;                                                               \
+    int i, j;                                                                  \
+    unsigned long keys[BATCH];                                                 \
+    long inserted = 0;                                                         \
+    if (thread_current_id() == 0) {                                            \
+      ATOMIC_STORE(&obj->size, 0);                                             \
+      init_skiplist(obj);                                                      \
+    }                                                                          \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; i += BATCH) {                            \
+      int n = (obj->repetitions - i < BATCH) ? obj->repetitions - i : BATCH;   \
+      for (j = 0; j < n; ++j) {                                                \
+        keys[j] = (unsigned long)(i + j) * obj->thread_num +                   \
+                  thread_current_id();                                         \
+      }                                                                        \
+      inserted += put_##name(obj, keys, (uint)n);                              \
+    }                                                                          \
+    assert(inserted == obj->repetitions);                                      \
+    ATOMIC_ADD(&obj->size, inserted);                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+    if (thread_current_id() == 0) {                                            \
+      check_range(obj, #name, range_skiplist);                                 \
+      destroy_skiplist(obj);                                                   \
+    }                                                                          \
+    pthread_barrier_wait(&obj->barrier_aux);                                   \
+  }
+
+static uint put_single(pthread_subroutine_args_t *obj,
+                       const unsigned long *keys, uint n) {
+  uint i, inserted = 0;
+  for (i = 0; i < n; ++i) {
+    inserted += skiplist_put(&obj->skiplist, keys[i], keys[i]);
+  }
+  return inserted;
+}
+
+static uint put_batch(pthread_subroutine_args_t *obj,
+                      const unsigned long *keys, uint n) {
+  return skiplist_put_batch(&obj->skiplist, keys, keys, n);
+}
+
+CREATE_BATCH_TESTER(single)
+CREATE_BATCH_TESTER(batch)
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  uint i, j;
+  thread_init(obj->thread_num);
+  for (i = 0; i < KEY_RANGES; ++i) {
+    if (thread_current_id() == 0) {
+      obj->key_range = key_ranges[i];
+      printf("\tTesting %lu keys...\n", obj->key_range);
+    }
+    pthread_barrier_wait(&obj->barrier_aux);
+    for (j = 0; j < UPDATE_PERCENTS; ++j) {
+      test_set_skiplist(obj, update_percents[j]);
+      test_set_tree(obj, update_percents[j]);
+    }
+  }
+  if (thread_current_id() == 0) {
+    obj->key_range = (unsigned long)obj->thread_num * obj->repetitions;
+    printf("\tTesting puts of %d keys per thread, by %d...\n",
+           obj->repetitions, BATCH);
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+  test_batch_single(obj);
+  test_batch_batch(obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0 && repetitions > 0) {
+      int retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+      printf("\tSkip list with %s node locks\n", NAME(SKIPLIST_MUTEX));
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      atomic_init(&obj.size, 0);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,168 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Blocks allocated per thread and repetition; the odd ones are freed by the
+ * next thread, so half the frees are remote */
+#define BATCH 16
+
+/* Up to `SLAB_MAX_LINES`, larger blocks only take a separate check */
+static const size_t sizes[] = {8, 64, 100, 256, 1000, 4096, 16384};
+#define SIZE_NUM (sizeof(sizes) / sizeof(sizes[0]))
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  void **handoff;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static size_t block_size(uint tid, int i) {
+  return sizes[(tid + (uint)i) % SIZE_NUM];
+}
+
+/* One byte per cache line and the last one are marked, so a block
+ * overlapping another live block loses its pattern */
+static void block_fill(void *block, size_t size, uint tid, int i) {
+  unsigned char *bytes = (unsigned char *)block;
+  size_t j;
+  for (j = 0; j < size; j += CACHE_LINE_SIZE) {
+    bytes[j] = (unsigned char)(tid * BATCH + (uint)i);
+  }
+  bytes[size - 1] = (unsigned char)(tid * BATCH + (uint)i);
+}
+
+static void block_check(void *block, size_t size, uint tid, int i) {
+  const unsigned char *bytes = (const unsigned char *)block;
+  size_t j;
+  for (j = 0; j < size; j += CACHE_LINE_SIZE) {
+    assert(bytes[j] == (unsigned char)(tid * BATCH + (uint)i));
+  }
+  assert(bytes[size - 1] == (unsigned char)(tid * BATCH + (uint)i));
+}
+
+static void *slab_alloc_aligned(size_t size) {
+  void *block = slab_alloc(size);
+  assert((uintptr_t)block % CACHE_LINE_SIZE == 0);
+  return block;
+}
+
+#define CREATE_ALLOC_TESTER(name, alloc, release)                              \
+  void test_alloc_##name(pthread_subroutine_args_t *obj) {                     \
+    my_time_t t;                                                               \
+    int i, j;                                                                  \
+    uint tid = thread_current_id();                                            \
+    uint previous = (tid + obj->thread_num - 1) % obj->thread_num;             \
+    void **mine = &obj->handoff[tid * BATCH];                                  \
+    void **theirs = &obj->handoff[previous * BATCH];                           \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      for (j = 0; j < BATCH; ++j) {                                            \
+        size_t size = block_size(tid, j);                                      \
+        mine[j] = alloc(size);                                                 \
+        assert(mine[j] != NULL);                                               \
+        block_fill(mine[j], size, tid, j);                                     \
+      }                                                                        \
+      for (j = 0; j < BATCH; j += 2) {                                         \
+        block_check(mine[j], block_size(tid, j), tid, j);                      \
+        release(mine[j]);                                                      \
+      }                                                                        \
+      pthread_barrier_wait(&obj->barrier_aux);                                 \
+      for (j = 1; j < BATCH; j += 2) {                                         \
+        block_check(theirs[j], block_size(previous, j), previous, j);          \
+        release(theirs[j]);                                                    \
+      }                                                                        \
+      pthread_barrier_wait(&obj->barrier_aux);                                 \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #name);                       \
+  }
+
+CREATE_ALLOC_TESTER(slab, slab_alloc_aligned, slab_free)
+CREATE_ALLOC_TESTER(malloc, malloc, free)
+
+/* Blocks beyond `SLAB_MAX_LINES`, freed remotely too */
+static void check_large(pthread_subroutine_args_t *obj) {
+  uint tid = thread_current_id();
+  uint previous = (tid + obj->thread_num - 1) % obj->thread_num;
+  size_t size = (size_t)SLAB_MAX_LINES * CACHE_LINE_SIZE + 1;
+  obj->handoff[tid * BATCH] = slab_alloc_aligned(size + tid);
+  assert(obj->handoff[tid * BATCH] != NULL);
+  block_fill(obj->handoff[tid * BATCH], size + tid, tid, 0);
+  pthread_barrier_wait(&obj->barrier_aux);
+  block_check(obj->handoff[previous * BATCH], size + previous, previous, 0);
+  slab_free(obj->handoff[previous * BATCH]);
+  pthread_barrier_wait(&obj->barrier_aux);
+}
+
+/* Lock and barrier churn: every thread creates and destroys objects of its
+ * own, which used to take one `malloc` per thread for the dissemination and
+ * tournament barriers */
+void test_churn(pthread_subroutine_args_t *obj) {
+  my_time_t t;
+  int i, retval = SUCCESS;
+  tic(&t, &obj->barrier_aux);
+  for (i = 0; i < obj->repetitions; ++i) {
+    barrier_dissemination_t dissemination;
+    barrier_tournament_t tournament;
+    mutex_CLH_t CLH;
+    retval = barrier_init_dissemination(&dissemination, obj->thread_num);
+    assert(retval == SUCCESS);
+    retval = barrier_init_tournament(&tournament, obj->thread_num);
+    assert(retval == SUCCESS);
+    retval = mutex_init_CLH(&CLH, obj->thread_num);
+    assert(retval == SUCCESS);
+    barrier_destroy_dissemination(&dissemination);
+    barrier_destroy_tournament(&tournament);
+    mutex_destroy_CLH(&CLH);
+  }
+  toc(&t, &obj->barrier_aux, obj->repetitions, "churn");
+  (void)retval;
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  if (thread_current_id() == 0) {
+    puts("\tTesting allocators...");
+  }
+  test_alloc_slab(obj);
+  test_alloc_malloc(obj);
+  check_large(obj);
+  if (thread_current_id() == 0) {
+    puts("\tTesting object churn...");
+  }
+  test_churn(obj);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      obj.handoff = (void **)malloc(sizeof(void *) * BATCH * t_num);
+      assert(obj.handoff != NULL);
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      free(obj.handoff);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
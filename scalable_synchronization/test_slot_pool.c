@@ -0,0 +1,189 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Many locks, each protecting one counter, and every iteration takes a
+ * randomly chosen one: the footprint of a lock instance decides how many of
+ * them stay in cache. */
+
+#define LOCKS 1024
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  int *counters;
+  mutex_pool_t pool;
+  mutex_Anderson_t *Anderson;
+  mutex_Anderson_pooled_t *Anderson_pooled;
+  mutex_GT_t *GT;
+  mutex_GT_pooled_t *GT_pooled;
+  mutex_CLH_t *CLH;
+  mutex_CLH_pooled_t *CLH_pooled;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+static uint ceiling_2(uint n) {
+  uint i = 2;
+  while (i < n) {
+    i = i << 1;
+  }
+  return i;
+}
+
+static void check_counters(pthread_subroutine_args_t *obj) {
+  pthread_barrier_wait(&obj->barrier_aux);
+  if (thread_current_id() == 0) {
+    int i;
+    long sum = 0;
+    for (i = 0; i < LOCKS; ++i) {
+      sum += obj->counters[i];
+      obj->counters[i] = 0;
+    }
+    assert(sum == (long)obj->thread_num * obj->repetitions);
+  }
+  pthread_barrier_wait(&obj->barrier_aux);
+}
+
+#define CREATE_SLOT_POOL_TESTER(type, own_decl, lock, unlock)                  \
+  void test_mutex_##type(pthread_subroutine_args_t *obj) {                     \
+    my_time_t t;                                                               \
+    int i;                                                                     \
+    uint64_t seed = 2463534242u + thread_current_id();                         \
+    uint l;                                                                    \
+    own_decl;                                                                  \
+    tic(&t, &obj->barrier_aux);                                                \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      l = next_random(&seed) % LOCKS;                                          \
+      lock;                                                                    \
+      ++obj->counters[l];                                                      \
+      unlock;                                                                  \
+    }                                                                          \
+    toc(&t, &obj->barrier_aux, obj->repetitions, #type);                       \
+    check_counters(obj);                                                       \
+  }
+
+CREATE_SLOT_POOL_TESTER(Anderson, mutex_Anderson_ownership_t ownership,
+                        mutex_lock_Anderson(&obj->Anderson[l], &ownership),
+                        mutex_unlock_Anderson(&obj->Anderson[l], &ownership))
+CREATE_SLOT_POOL_TESTER(
+    Anderson_pooled, mutex_Anderson_pooled_ownership_t ownership,
+    mutex_lock_Anderson_pooled(&obj->Anderson_pooled[l], &ownership),
+    mutex_unlock_Anderson_pooled(&obj->Anderson_pooled[l], &ownership))
+CREATE_SLOT_POOL_TESTER(GT, , mutex_lock_GT(&obj->GT[l]),
+                        mutex_unlock_GT(&obj->GT[l]))
+CREATE_SLOT_POOL_TESTER(GT_pooled, mutex_GT_pooled_ownership_t ownership,
+                        mutex_lock_GT_pooled(&obj->GT_pooled[l], &ownership),
+                        mutex_unlock_GT_pooled(&obj->GT_pooled[l],
+                                               &ownership))
+CREATE_SLOT_POOL_TESTER(CLH, , mutex_lock_CLH(&obj->CLH[l]),
+                        mutex_unlock_CLH(&obj->CLH[l]))
+CREATE_SLOT_POOL_TESTER(CLH_pooled, mutex_CLH_pooled_ownership_t ownership,
+                        mutex_lock_CLH_pooled(&obj->CLH_pooled[l],
+                                              &ownership),
+                        mutex_unlock_CLH_pooled(&obj->CLH_pooled[l],
+                                                &ownership))
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  test_mutex_Anderson(obj);
+  test_mutex_Anderson_pooled(obj);
+  test_mutex_GT(obj);
+  test_mutex_GT_pooled(obj);
+  test_mutex_CLH(obj);
+  test_mutex_CLH_pooled(obj);
+  return NULL;
+}
+
+/* Bytes allocated per lock instance, following each init routine */
+static void print_footprint(uint t_num) {
+  unsigned long pool =
+      t_num * MUTEX_POOL_DEPTH *
+          (sizeof(padded_auint_t) + sizeof(padded_CLH_node_t)) +
+      t_num * sizeof(padded_pool_thread_t);
+  printf("\tBytes per lock with %u threads:\n", t_num);
+  printf("\t\tAnderson %lu, pooled %lu\n",
+         sizeof(mutex_Anderson_t) + ceiling_2(t_num) * sizeof(padded_abool_t),
+         sizeof(mutex_Anderson_pooled_t) +
+             ceiling_2(t_num) * sizeof(atomic_uint));
+  printf("\t\tGT %lu, pooled %lu\n",
+         sizeof(mutex_GT_t) + t_num * sizeof(padded_abool_t),
+         sizeof(mutex_GT_pooled_t));
+  printf("\t\tCLH %lu, pooled %lu\n",
+         sizeof(mutex_CLH_t) + (t_num + 1) * sizeof(padded_abool_t) +
+             t_num * sizeof(padded_CLH_state_t),
+         sizeof(mutex_CLH_pooled_t) + sizeof(padded_CLH_node_t));
+  printf("\t\tshared pool %lu, %.1f per lock over %d locks\n", pool,
+         (double)pool / LOCKS, LOCKS);
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 2) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0) {
+      int i, retval;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      printf("Testing with %d threads, %d repetitions...\n", t_num,
+             repetitions);
+      print_footprint(t_num);
+
+      obj.counters = (int *)calloc(LOCKS, sizeof(int));
+      obj.Anderson =
+          (mutex_Anderson_t *)malloc(LOCKS * sizeof(mutex_Anderson_t));
+      obj.Anderson_pooled = (mutex_Anderson_pooled_t *)malloc(
+          LOCKS * sizeof(mutex_Anderson_pooled_t));
+      obj.GT = (mutex_GT_t *)malloc(LOCKS * sizeof(mutex_GT_t));
+      obj.GT_pooled =
+          (mutex_GT_pooled_t *)malloc(LOCKS * sizeof(mutex_GT_pooled_t));
+      obj.CLH = (mutex_CLH_t *)malloc(LOCKS * sizeof(mutex_CLH_t));
+      obj.CLH_pooled =
+          (mutex_CLH_pooled_t *)malloc(LOCKS * sizeof(mutex_CLH_pooled_t));
+      assert(obj.counters != NULL && obj.Anderson != NULL &&
+             obj.Anderson_pooled != NULL && obj.GT != NULL &&
+             obj.GT_pooled != NULL && obj.CLH != NULL &&
+             obj.CLH_pooled != NULL);
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      mutex_pool_init(&obj.pool, t_num);
+      for (i = 0; i < LOCKS; ++i) {
+        mutex_init_Anderson(&obj.Anderson[i], t_num);
+        mutex_init_Anderson_pooled(&obj.Anderson_pooled[i], &obj.pool);
+        mutex_init_GT(&obj.GT[i], t_num);
+        mutex_init_GT_pooled(&obj.GT_pooled[i], &obj.pool);
+        mutex_init_CLH(&obj.CLH[i], t_num);
+        mutex_init_CLH_pooled(&obj.CLH_pooled[i], &obj.pool);
+      }
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      for (i = 0; i < LOCKS; ++i) {
+        mutex_destroy_Anderson(&obj.Anderson[i]);
+        mutex_destroy_Anderson_pooled(&obj.Anderson_pooled[i]);
+        mutex_destroy_GT(&obj.GT[i]);
+        mutex_destroy_CLH(&obj.CLH[i]);
+        mutex_destroy_CLH_pooled(&obj.CLH_pooled[i]);
+      }
+      mutex_pool_destroy(&obj.pool);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      free(obj.counters);
+      free(obj.Anderson);
+      free(obj.Anderson_pooled);
+      free(obj.GT);
+      free(obj.GT_pooled);
+      free(obj.CLH);
+      free(obj.CLH_pooled);
+      return retval;
+    } else {
+      print_help(argv[0]);
+      return -3;
+    }
+  } else {
+    print_help(argv[0]);
+    return -3;
+  }
+}
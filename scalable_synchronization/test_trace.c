@@ -0,0 +1,271 @@
+#include "synchronize.h"
+#include "test_utils.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Records the atomic accesses of one lock or barrier for `coherence_sim`.
+ * Every lock acquire, and every barrier episode as seen by thread 0, ends
+ * with an episode mark. Built against the library compiled with
+ * `ATOMIC_TRACE`. */
+
+#define TRACE_CAPACITY (1ul << 24)
+/* Thread 0 writes once per `RWLOCK_PERIOD` operations, all others read */
+#define RWLOCK_PERIOD 64
+/* Nodes of the NUMA-aware reader-writer lock, laid out like the sockets of
+ * `coherence_sim` in compact mode */
+#define RWLOCK_NODES 2
+
+typedef struct {
+  int thread_num;
+  int repetitions;
+  int test_shared;
+  const char *primitive;
+  mutex_test_and_set_t mutex_test_and_set;
+  mutex_ticket_t mutex_ticket;
+  mutex_partitioned_ticket_t mutex_partitioned_ticket;
+  mutex_TWA_t mutex_TWA;
+  mutex_Anderson_t mutex_Anderson;
+  mutex_GT_t mutex_GT;
+  mutex_MCS_t mutex_MCS;
+  mutex_CLH_t mutex_CLH;
+  mutex_Malthusian_t mutex_Malthusian;
+  barrier_centralized_t barrier_centralized;
+  barrier_combining_tree_t barrier_combining_tree;
+  barrier_dissemination_t barrier_dissemination;
+  barrier_tournament_t barrier_tournament;
+  barrier_dual_tree_t barrier_dual_tree;
+  barrier_arrival_tree_t barrier_arrival_tree;
+  barrier_wide_tree_t barrier_wide_tree;
+  mutex_MCS_t flags_mutex;
+  rwlock_flags_t rwlock_flags;
+  rwlock_NUMA_t rwlock_NUMA_writer;
+  rwlock_NUMA_t rwlock_NUMA_neutral;
+  rwlock_NUMA_t rwlock_NUMA_one_node;
+  pthread_barrier_t barrier_aux;
+} pthread_subroutine_args_t;
+
+typedef void (*trace_run_t)(pthread_subroutine_args_t *obj);
+
+#define CREATE_MUTEX_TRACER(type, own_decl, lock, unlock)                      \
+  static void trace_mutex_##type(pthread_subroutine_args_t *obj) {             \
+    int i;                                                                     \
+    own_decl;                                                                  \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      lock;                                                                    \
+      atomic_trace(NULL, ATOMIC_TRACE_EPISODE);                                \
+      ++obj->test_shared;                                                      \
+      unlock;                                                                  \
+    }                                                                          \
+  }
+
+#define CREATE_RWLOCK_TRACER(type, own_decl, read_lock, read_unlock,           \
+                             write_lock, write_unlock)                         \
+  static void trace_rwlock_##type(pthread_subroutine_args_t *obj) {            \
+    int i;                                                                     \
+    own_decl;                                                                  \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      if (thread_current_id() == 0 && i % RWLOCK_PERIOD == 0) {                \
+        write_lock;                                                            \
+        atomic_trace(NULL, ATOMIC_TRACE_EPISODE);                              \
+        ++obj->test_shared;                                                    \
+        write_unlock;                                                          \
+      } else {                                                                 \
+        read_lock;                                                             \
+        atomic_trace(NULL, ATOMIC_TRACE_EPISODE);                              \
+        read_unlock;                                                           \
+      }                                                                        \
+    }                                                                          \
+  }
+
+#define CREATE_NUMA_TRACER(type)                                               \
+  CREATE_RWLOCK_TRACER(                                                        \
+      NUMA_##type, mutex_MCS_ownership_t ownership,                            \
+      rwlock_read_lock_NUMA(&obj->rwlock_NUMA_##type, &ownership),             \
+      rwlock_read_unlock_NUMA(&obj->rwlock_NUMA_##type),                       \
+      rwlock_write_lock_NUMA(&obj->rwlock_NUMA_##type, &ownership),            \
+      rwlock_write_unlock_NUMA(&obj->rwlock_NUMA_##type, &ownership))
+
+#define CREATE_BARRIER_TRACER(type)                                            \
+  static void trace_barrier_##type(pthread_subroutine_args_t *obj) {           \
+    int i;                                                                     \
+    for (i = 0; i < obj->repetitions; ++i) {                                   \
+      barrier_wait_##type(&obj->barrier_##type);                               \
+      if (thread_current_id() == 0) {                                          \
+        atomic_trace(NULL, ATOMIC_TRACE_EPISODE);                              \
+      }                                                                        \
+    }                                                                          \
+  }
+
+CREATE_MUTEX_TRACER(test_and_set, ,
+                    mutex_lock_test_and_set(&obj->mutex_test_and_set),
+                    mutex_unlock_test_and_set(&obj->mutex_test_and_set))
+CREATE_MUTEX_TRACER(ticket, , mutex_lock_ticket(&obj->mutex_ticket),
+                    mutex_unlock_ticket(&obj->mutex_ticket))
+CREATE_MUTEX_TRACER(
+    partitioned_ticket, ,
+    mutex_lock_partitioned_ticket(&obj->mutex_partitioned_ticket),
+    mutex_unlock_partitioned_ticket(&obj->mutex_partitioned_ticket))
+CREATE_MUTEX_TRACER(TWA, , mutex_lock_TWA(&obj->mutex_TWA),
+                    mutex_unlock_TWA(&obj->mutex_TWA))
+CREATE_MUTEX_TRACER(Anderson, mutex_Anderson_ownership_t ownership,
+                    mutex_lock_Anderson(&obj->mutex_Anderson, &ownership),
+                    mutex_unlock_Anderson(&obj->mutex_Anderson, &ownership))
+CREATE_MUTEX_TRACER(GT, , mutex_lock_GT(&obj->mutex_GT),
+                    mutex_unlock_GT(&obj->mutex_GT))
+CREATE_MUTEX_TRACER(MCS, mutex_MCS_ownership_t ownership,
+                    mutex_lock_MCS(&obj->mutex_MCS, &ownership),
+                    mutex_unlock_MCS(&obj->mutex_MCS, &ownership))
+CREATE_MUTEX_TRACER(CLH, , mutex_lock_CLH(&obj->mutex_CLH),
+                    mutex_unlock_CLH(&obj->mutex_CLH))
+CREATE_MUTEX_TRACER(Malthusian, mutex_Malthusian_ownership_t ownership,
+                    mutex_lock_Malthusian(&obj->mutex_Malthusian, &ownership),
+                    mutex_unlock_Malthusian(&obj->mutex_Malthusian,
+                                            &ownership))
+CREATE_RWLOCK_TRACER(flags, mutex_MCS_ownership_t ownership,
+                     rwlock_read_lock_flags(&obj->rwlock_flags),
+                     rwlock_read_unlock_flags(&obj->rwlock_flags),
+                     rwlock_write_lock_flags(&obj->rwlock_flags, &ownership),
+                     rwlock_write_unlock_flags(&obj->rwlock_flags, &ownership))
+CREATE_NUMA_TRACER(writer)
+CREATE_NUMA_TRACER(neutral)
+CREATE_NUMA_TRACER(one_node)
+CREATE_BARRIER_TRACER(centralized)
+CREATE_BARRIER_TRACER(combining_tree)
+CREATE_BARRIER_TRACER(dissemination)
+CREATE_BARRIER_TRACER(tournament)
+CREATE_BARRIER_TRACER(dual_tree)
+CREATE_BARRIER_TRACER(arrival_tree)
+CREATE_BARRIER_TRACER(wide_tree)
+
+static const struct {
+  const char *name;
+  trace_run_t run;
+} tracers[] = {
+    {"test_and_set", trace_mutex_test_and_set},
+    {"ticket", trace_mutex_ticket},
+    {"partitioned_ticket", trace_mutex_partitioned_ticket},
+    {"TWA", trace_mutex_TWA},
+    {"Anderson", trace_mutex_Anderson},
+    {"GT", trace_mutex_GT},
+    {"MCS", trace_mutex_MCS},
+    {"CLH", trace_mutex_CLH},
+    {"Malthusian", trace_mutex_Malthusian},
+    {"rwlock_flags", trace_rwlock_flags},
+    {"rwlock_NUMA_writer", trace_rwlock_NUMA_writer},
+    {"rwlock_NUMA_neutral", trace_rwlock_NUMA_neutral},
+    {"rwlock_NUMA_one_node", trace_rwlock_NUMA_one_node},
+    {"centralized", trace_barrier_centralized},
+    {"combining_tree", trace_barrier_combining_tree},
+    {"dissemination", trace_barrier_dissemination},
+    {"tournament", trace_barrier_tournament},
+    {"dual_tree", trace_barrier_dual_tree},
+    {"arrival_tree", trace_barrier_arrival_tree},
+    {"wide_tree", trace_barrier_wide_tree},
+};
+
+#define TRACERS (sizeof(tracers) / sizeof(tracers[0]))
+
+static trace_run_t find_tracer(const char *name) {
+  uint i;
+  for (i = 0; i < TRACERS; ++i) {
+    if (strcmp(tracers[i].name, name) == 0) {
+      return tracers[i].run;
+    }
+  }
+  return NULL;
+}
+
+void *pthread_subroutine(void *args) {
+  pthread_subroutine_args_t *obj = (pthread_subroutine_args_t *)args;
+  thread_init(obj->thread_num);
+  pthread_barrier_wait(&obj->barrier_aux);
+  find_tracer(obj->primitive)(obj);
+  return NULL;
+}
+
+static void print_usage(const char *argv0) {
+  uint i;
+  printf("USAGE:\n\t%s <#threads> <#repetitions> <primitive> <trace file>\n",
+         argv0);
+  printf("\tprimitives:");
+  for (i = 0; i < TRACERS; ++i) {
+    printf(" %s", tracers[i].name);
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  pthread_subroutine_args_t obj;
+  if (argc > 4) {
+    int t_num = atoi(argv[1]);
+    int repetitions = atoi(argv[2]);
+    if (t_num > 0 && find_tracer(argv[3]) != NULL) {
+      int retval, dropped;
+      obj.thread_num = t_num;
+      obj.repetitions = repetitions;
+      obj.primitive = argv[3];
+      obj.test_shared = 0;
+      printf("Tracing %s with %d threads, %d repetitions...\n", argv[3], t_num,
+             repetitions);
+
+      pthread_barrier_init(&obj.barrier_aux, NULL, t_num);
+      mutex_init_test_and_set(&obj.mutex_test_and_set);
+      mutex_init_ticket(&obj.mutex_ticket);
+      mutex_init_partitioned_ticket(&obj.mutex_partitioned_ticket, t_num);
+      mutex_init_TWA(&obj.mutex_TWA);
+      mutex_init_Anderson(&obj.mutex_Anderson, t_num);
+      mutex_init_GT(&obj.mutex_GT, t_num);
+      mutex_init_MCS(&obj.mutex_MCS);
+      mutex_init_CLH(&obj.mutex_CLH, t_num);
+      mutex_init_Malthusian(&obj.mutex_Malthusian);
+      mutex_init_MCS(&obj.flags_mutex);
+      rwlock_init_flags(&obj.rwlock_flags, t_num, &obj.flags_mutex,
+                        &rwlock_mutex_MCS);
+      rwlock_init_NUMA(&obj.rwlock_NUMA_writer, t_num, RWLOCK_NODES, true);
+      rwlock_init_NUMA(&obj.rwlock_NUMA_neutral, t_num, RWLOCK_NODES, false);
+      rwlock_init_NUMA(&obj.rwlock_NUMA_one_node, t_num, 1, true);
+      barrier_init_centralized(&obj.barrier_centralized, t_num);
+      barrier_init_combining_tree(&obj.barrier_combining_tree, t_num);
+      barrier_init_dissemination(&obj.barrier_dissemination, t_num);
+      barrier_init_tournament(&obj.barrier_tournament, t_num);
+      barrier_init_dual_tree(&obj.barrier_dual_tree, t_num);
+      barrier_init_arrival_tree(&obj.barrier_arrival_tree, t_num);
+      barrier_init_wide_tree(&obj.barrier_wide_tree, t_num);
+      atomic_trace_start(TRACE_CAPACITY);
+
+      retval = parallel_execute(pthread_subroutine, (void *)&obj, t_num);
+
+      dropped = atomic_trace_dump(argv[4]);
+      if (dropped < 0) {
+        printf("\tCannot write %s\n", argv[4]);
+      } else if (dropped > 0) {
+        printf("\tTrace full, %d accesses dropped\n", dropped);
+      }
+      mutex_destroy_partitioned_ticket(&obj.mutex_partitioned_ticket);
+      mutex_destroy_Anderson(&obj.mutex_Anderson);
+      mutex_destroy_GT(&obj.mutex_GT);
+      mutex_destroy_CLH(&obj.mutex_CLH);
+      rwlock_destroy_flags(&obj.rwlock_flags);
+      rwlock_destroy_NUMA(&obj.rwlock_NUMA_writer);
+      rwlock_destroy_NUMA(&obj.rwlock_NUMA_neutral);
+      rwlock_destroy_NUMA(&obj.rwlock_NUMA_one_node);
+      barrier_destroy_centralized(&obj.barrier_centralized);
+      barrier_destroy_combining_tree(&obj.barrier_combining_tree);
+      barrier_destroy_dissemination(&obj.barrier_dissemination);
+      barrier_destroy_tournament(&obj.barrier_tournament);
+      barrier_destroy_dual_tree(&obj.barrier_dual_tree);
+      barrier_destroy_arrival_tree(&obj.barrier_arrival_tree);
+      barrier_destroy_wide_tree(&obj.barrier_wide_tree);
+      pthread_barrier_destroy(&obj.barrier_aux);
+      return retval;
+    } else {
+      print_usage(argv[0]);
+      return -3;
+    }
+  } else {
+    print_usage(argv[0]);
+    return -3;
+  }
+}
@@ -0,0 +1,60 @@
+#include "test_utils.h"
+#include "synchronize.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void print_help(const char *argv0) {
+  printf("USAGE:\n\t%s <#threads> <#repetitions>\n", argv0);
+}
+
+void tic(my_time_t *start, pthread_barrier_t *barrier) {
+  pthread_barrier_wait(barrier);
+  if (thread_current_id() == 0) {
+    gettimeofday(start, NULL);
+  }
+}
+
+void toc(my_time_t *start, pthread_barrier_t *barrier, int repetitions,
+         const char *name) {
+  pthread_barrier_wait(barrier);
+  if (thread_current_id() == 0) {
+    my_time_t end;
+    double t;
+    gettimeofday(&end, NULL);
+    t = (double)(end.tv_sec - start->tv_sec) +
+        1e-6 * (double)(end.tv_usec - start->tv_usec);
+    printf("\t\t%s: total %lfs, average %lfus \n", name, t,
+           t / (double)repetitions * 1e9);
+  }
+}
+
+uint64_t next_random(uint64_t *seed) {
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return *seed;
+}
+
+int parallel_execute(void *(*routine)(void *), void *args, int thread_num) {
+  int created_tnum = 0;
+  int i;
+  pthread_t *threads =
+      (pthread_t *)malloc(sizeof(pthread_t) * (thread_num - 1));
+  if (threads == NULL) {
+    return -1;
+  }
+
+  for (i = 0; i < thread_num - 1; ++i) {
+    if (pthread_create(&threads[i], NULL, routine, args) != 0) {
+      break;
+    }
+  }
+  created_tnum = i;
+  routine(args);
+  for (i = 0; i < created_tnum; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  free(threads);
+  return (thread_num - 1 == created_tnum) ? 0 : -2;
+}
@@ -0,0 +1,21 @@
+#ifndef TEST_UTILS_H_INCLUDED
+#define TEST_UTILS_H_INCLUDED 1
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+typedef struct timeval my_time_t;
+
+void print_help(const char *argv0);
+
+void tic(my_time_t *start, pthread_barrier_t *barrier);
+void toc(my_time_t *start, pthread_barrier_t *barrier, int repetitions,
+         const char *name);
+
+/* xorshift64: `seed` must start nonzero */
+uint64_t next_random(uint64_t *seed);
+
+int parallel_execute(void *(*routine)(void *), void *args, int thread_num);
+
+#endif
@@ -14,3 +14,5 @@ void thread_init(int expected_thread_num) {
 uint thread_total_number() { return atomic_load(&thread_num); }
 
 uint thread_current_id() { return thread_id; }
+
+void thread_set_id(uint id) { thread_id = id; }
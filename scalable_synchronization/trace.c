@@ -0,0 +1,71 @@
+#include "synchronize.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Records go to one preallocated array in the order their slots were
+ * claimed, which is the interleaving `coherence_sim` replays. The slot is
+ * claimed just before the access itself, so the order is approximate for
+ * accesses that race closely. Records past the capacity are dropped. */
+
+typedef struct {
+  uint thread;
+  char operation;
+  const void *address;
+} trace_record_t;
+
+static trace_record_t *records;
+static unsigned long record_capacity;
+static atomic_ulong record_num;
+
+int atomic_trace_start(unsigned long capacity) {
+  trace_record_t *array =
+      (trace_record_t *)malloc(sizeof(trace_record_t) * capacity);
+  if (array == NULL) {
+    return OUT_OF_MEMORY;
+  }
+  free(records);
+  records = array;
+  record_capacity = capacity;
+  atomic_init(&record_num, 0);
+  return SUCCESS;
+}
+
+void atomic_trace(const void *address, char operation) {
+  unsigned long i =
+      atomic_fetch_add_explicit(&record_num, 1, memory_order_relaxed);
+  if (i < record_capacity) {
+    records[i].thread = thread_current_id();
+    records[i].operation = operation;
+    records[i].address = address;
+  }
+}
+
+/* Visits the records in the order they were claimed */
+int atomic_trace_stop(atomic_trace_visitor_t visitor, void *arg) {
+  unsigned long i, num = atomic_load(&record_num);
+  for (i = 0; i < num && i < record_capacity; ++i) {
+    visitor(records[i].thread, records[i].operation, records[i].address, arg);
+  }
+  free(records);
+  records = NULL;
+  record_capacity = 0;
+  return (num > i) ? (int)(num - i) : SUCCESS;
+}
+
+static void print_record(uint thread, char operation, const void *address,
+                         void *arg) {
+  fprintf((FILE *)arg, "%u %c %lx\n", thread, operation,
+          (unsigned long)(uintptr_t)address);
+}
+
+/* One access per line: thread, operation and address in hexadecimal */
+int atomic_trace_dump(const char *path) {
+  int dropped;
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    return LIB_INIT_INVALID;
+  }
+  dropped = atomic_trace_stop(print_record, file);
+  fclose(file);
+  return dropped;
+}